@@ -0,0 +1,71 @@
+#include "VkTestSiteApp.h"
+#include "spdlog/sinks/stdout_color_sinks.h"
+
+VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE
+
+/**
+ * Directory of running executable, resource root "../res" is looked up next to it (build directory layout)
+ */
+static std::filesystem::path executableDir(const char *argv0) {
+  std::error_code error;
+  if (const auto self = std::filesystem::read_symlink("/proc/self/exe", error); !error)
+    return self.parent_path();
+  return std::filesystem::absolute(argv0).parent_path();
+}
+
+/**
+ * Resolve path given on command line against launch directory, "-" (stdout) is kept
+ */
+static void makeAbsolute(std::optional<std::filesystem::path> &path) {
+  if (path && *path != "-")
+    path = std::filesystem::absolute(*path);
+}
+
+/**
+ * Benchmark harness: headless run of scripted camera path over a model,
+ * frame-time stats are printed to stdout as JSON (logs go to stderr).
+ * Default scene and shaders are taken from resource root, so bench runs from any working directory.
+ */
+int main(const int argc, char **argv) {
+  const auto console_sink = std::make_shared<spdlog::sinks::stderr_color_sink_mt>();
+  const auto logger = std::make_shared<spdlog::logger>("bench_logger", console_sink);
+  spdlog::set_default_logger(logger);
+
+  try {
+    const auto exeDir = executableDir(argv[0]);
+    const auto resourceRoot = (exeDir / "../res").lexically_normal();
+    auto defaults = AppOptions{
+      .headless = true,
+      .frameCount = 600,
+      .warmupFrames = 60,
+      .modelPath = resourceRoot / "models/light_test/lightTest.gltf",
+      .cameraPath = resourceRoot / "camera_paths/light_test_orbit.campath",
+      .statsOutput = "-"
+    };
+
+    auto options = parseAppOptions(argc, argv, defaults);
+    options.headless = true;
+    for (auto *path: {&options.modelPath, &options.textureCacheDir, &options.cameraPath,
+                      &options.captureDir, &options.statsOutput}) {
+      makeAbsolute(*path);
+    }
+    for (const auto &path: {options.modelPath, options.cameraPath}) {
+      if (path && !std::filesystem::exists(*path))
+        throw std::runtime_error(std::format("File not found: {}", path->string()));
+    }
+    if (!std::filesystem::is_directory(resourceRoot / "shaders"))
+      throw std::runtime_error(std::format(
+        "Resource root not found: {} (expected res directory next to build directory of {})",
+        resourceRoot.string(), exeDir.string()));
+
+    // Shaders and fonts are loaded by "../res" paths relative to working directory
+    std::filesystem::current_path(exeDir);
+    VkTestSiteApp app{options};
+    app.run();
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
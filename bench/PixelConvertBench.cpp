@@ -0,0 +1,93 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "PixelConvert.h"
+
+/**
+ * Micro-benchmark of pixel conversion kernels: every kernel runs over 4096x4096 pixels
+ * for every instruction set available on this CPU, best of repeats is reported as
+ * GB/s of source plus destination bytes. Output of vector kernels is checked against scalar one.
+ * JSON is printed to stdout.
+ */
+
+struct Kernel {
+  std::string name;
+  size_t srcBytes; // Per element
+  size_t dstBytes;
+  std::function<void(const void *, void *, size_t, PixelIsa)> run;
+};
+
+int main(const int argc, char **argv) {
+  const size_t count = argc > 1 ? std::stoul(argv[1]) : 4096 * 4096;
+  constexpr int repeats = 20;
+
+  const std::vector<Kernel> kernels = {
+    {"rgb8ToRgba8", 3, 4, [](const void *s, void *d, size_t n, PixelIsa isa) {
+      convertRgb8ToRgba8(static_cast<const uint8_t *>(s), static_cast<uint8_t *>(d), n, isa);
+    }},
+    {"grey8ToRgba8", 1, 4, [](const void *s, void *d, size_t n, PixelIsa isa) {
+      convertGrey8ToRgba8(static_cast<const uint8_t *>(s), static_cast<uint8_t *>(d), n, isa);
+    }},
+    {"greyAlpha8ToRgba8", 2, 4, [](const void *s, void *d, size_t n, PixelIsa isa) {
+      convertGreyAlpha8ToRgba8(static_cast<const uint8_t *>(s), static_cast<uint8_t *>(d), n, isa);
+    }},
+    {"rgb16ToRgba16", 6, 8, [](const void *s, void *d, size_t n, PixelIsa isa) {
+      convertRgb16ToRgba16(static_cast<const uint16_t *>(s), static_cast<uint16_t *>(d), n, isa);
+    }},
+    {"floatToHalf", 4, 2, [](const void *s, void *d, size_t n, PixelIsa isa) {
+      convertFloatToHalf(static_cast<const float *>(s), static_cast<uint16_t *>(d), n, isa);
+    }},
+  };
+
+  std::vector<PixelIsa> isas = {PixelIsa::Scalar};
+#if defined(PIXEL_CONVERT_X86)
+  if (pixelIsa() == PixelIsa::Avx2 || pixelIsa() == PixelIsa::Sse4)
+    isas.push_back(PixelIsa::Sse4);
+  if (pixelIsa() == PixelIsa::Avx2)
+    isas.push_back(PixelIsa::Avx2);
+#elif defined(PIXEL_CONVERT_NEON)
+  isas.push_back(PixelIsa::Neon);
+#endif
+
+  // Random bytes, floats are kept finite and in HDR range
+  std::mt19937 rng(42);
+  std::vector<uint8_t> src(count * 6 + 16);
+  std::ranges::generate(src, [&] { return static_cast<uint8_t>(rng()); });
+  std::uniform_real_distribution<float> hdr(-70000.0f, 70000.0f);
+  std::vector<float> floats(count);
+  std::ranges::generate(floats, [&] { return hdr(rng) / static_cast<float>(1 << (rng() % 30)); });
+
+  std::vector<uint8_t> reference(count * 8), dst(count * 8);
+  std::cout << std::format("{{\n  \"detectedIsa\": \"{}\",\n  \"pixels\": {},\n  \"kernels\": [", pixelIsaName(pixelIsa()), count);
+  bool first = true;
+  bool allMatch = true;
+  for (const auto &kernel: kernels) {
+    const void *input = kernel.name == "floatToHalf" ? static_cast<const void *>(floats.data()) : src.data();
+    kernel.run(input, reference.data(), count, PixelIsa::Scalar);
+    for (const auto isa: isas) {
+      std::ranges::fill(dst, 0);
+      double best = 1e30;
+      for (int r = 0; r < repeats; ++r) {
+        const auto start = std::chrono::steady_clock::now();
+        kernel.run(input, dst.data(), count, isa);
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+      }
+      const bool match = std::equal(dst.begin(), dst.begin() + static_cast<ptrdiff_t>(count * kernel.dstBytes),
+                                    reference.begin());
+      allMatch &= match;
+      const auto gbps = static_cast<double>(count * (kernel.srcBytes + kernel.dstBytes)) / best / 1e9;
+      std::cout << std::format("{}\n    {{\"kernel\": \"{}\", \"isa\": \"{}\", \"gbps\": {:.2f}, \"match\": {}}}",
+                               first ? "" : ",", kernel.name, pixelIsaName(isa), gbps, match);
+      first = false;
+    }
+  }
+  std::cout << "\n  ]\n}" << std::endl;
+  return allMatch ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "concurrentqueue/blockingconcurrentqueue.h"
+#include "StagingBuffer.h"
+
+VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE
+
+/**
+ * Staging allocator contention benchmark: N threads stage bursts of small allocations
+ * (like texture load jobs) into one StagingBuffer, single tracker thread plays transfer thread
+ * and completes every tracked batch at once by host signal of staging timeline, so GPU time is excluded.
+ * Runs every thread count 1, 2, 4 .. hardware threads for VMA virtual block and ring mode,
+ * prints allocations per second as JSON to stdout.
+ *
+ * Usage: StagingBufferBench [allocations per run] [allocation KB]
+ */
+
+#define BENCH_STAGING_SIZE (128 * 1024 * 1024) // Same as app staging buffer
+#define BENCH_BURST_SIZE 16 // Allocations per simulated load job
+
+struct BenchDevice {
+  vk::detail::DynamicLoader loader;
+  vk::UniqueInstance instance;
+  vk::UniqueDevice device;
+  VmaAllocator allocator = nullptr;
+
+  ~BenchDevice() {
+    if (allocator)
+      vmaDestroyAllocator(allocator);
+  }
+};
+
+static void createBenchDevice(BenchDevice &bench) {
+  VULKAN_HPP_DEFAULT_DISPATCHER.init(bench.loader.getProcAddress<PFN_vkGetInstanceProcAddr>("vkGetInstanceProcAddr"));
+  constexpr vk::ApplicationInfo appInfo("StagingBufferBench", 1, "VK Test Site", 1, VK_API_VERSION_1_3);
+  bench.instance = vk::createInstanceUnique(vk::InstanceCreateInfo({}, &appInfo));
+  VULKAN_HPP_DEFAULT_DISPATCHER.init(bench.instance.get());
+
+  const auto physicalDevices = bench.instance->enumeratePhysicalDevices();
+  if (physicalDevices.empty())
+    throw std::runtime_error("No Vulkan device");
+  const auto physicalDevice = physicalDevices.front();
+
+  // Queue is never used, device needs one
+  constexpr float priority = 1.0f;
+  const auto queueInfo = vk::DeviceQueueCreateInfo({}, 0, 1, &priority);
+  auto features12 = vk::PhysicalDeviceVulkan12Features().setTimelineSemaphore(true);
+  const auto deviceInfo = vk::DeviceCreateInfo({}, queueInfo).setPNext(&features12);
+  bench.device = physicalDevice.createDeviceUnique(deviceInfo);
+  VULKAN_HPP_DEFAULT_DISPATCHER.init(bench.device.get());
+
+  VmaAllocatorCreateInfo allocatorInfo = {};
+  allocatorInfo.vulkanApiVersion = VK_API_VERSION_1_3;
+  allocatorInfo.physicalDevice = physicalDevice;
+  allocatorInfo.device = bench.device.get();
+  allocatorInfo.instance = bench.instance.get();
+  if (vmaCreateAllocator(&allocatorInfo, &bench.allocator) != VK_SUCCESS)
+    throw std::runtime_error("Failed to create VMA allocator");
+}
+
+/**
+ * @return seconds to stage allocationCount allocations of allocSize from threadCount threads
+ */
+static double runContention(
+  const BenchDevice &bench,
+  const StagingAllocMode mode,
+  const uint32_t threadCount,
+  const uint32_t allocationCount,
+  const vk::DeviceSize allocSize
+) {
+  StagingBuffer staging(bench.device.get(), vma::Allocator(bench.allocator), BENCH_STAGING_SIZE, mode);
+  moodycamel::BlockingConcurrentQueue<StagingBuffer::Allocation> staged;
+  std::atomic_uint32_t remaining = allocationCount;
+
+  // Tracks allocations in batches and completes them at once, like transfer thread with instant GPU
+  std::thread tracker([&] {
+    std::vector<StagingBuffer::Allocation> batch(64);
+    for (uint32_t tracked = 0; tracked < allocationCount;) {
+      const auto count = staged.wait_dequeue_bulk_timed(batch.begin(), batch.size(), std::chrono::milliseconds(1));
+      if (count == 0)
+        continue;
+      for (size_t i = 0; i < count; ++i)
+        staging.trackAlloc(batch[i]);
+      bench.device->signalSemaphore(vk::SemaphoreSignalInfo(staging.getTimeline(), staging.makeSignalInfo().value));
+      tracked += static_cast<uint32_t>(count);
+    }
+  });
+
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (uint32_t t = 0; t < threadCount; ++t) {
+    threads.emplace_back([&] {
+      while (true) {
+        auto burst = remaining.load();
+        uint32_t count;
+        do {
+          count = std::min<uint32_t>(burst, BENCH_BURST_SIZE);
+        } while (count > 0 && !remaining.compare_exchange_weak(burst, burst - count));
+        if (count == 0)
+          break;
+
+        for (uint32_t i = 0; i < count; ++i) {
+          auto alloc = staging.allocateBlocking(allocSize);
+          static_cast<uint8_t *>(alloc.mapped)[0] = static_cast<uint8_t>(i); // Touch, copy cost is not measured
+          staged.enqueue(alloc);
+        }
+        staging.releaseThreadChunk();
+      }
+    });
+  }
+  for (auto &thread: threads)
+    thread.join();
+  tracker.join();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(const int argc, char **argv) {
+  try {
+    const uint32_t allocationCount = argc > 1 ? std::stoul(argv[1]) : 200'000;
+    const vk::DeviceSize allocSize = (argc > 2 ? std::stoul(argv[2]) : 64) * 1024;
+    const auto maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    BenchDevice bench;
+    createBenchDevice(bench);
+
+    std::cout << std::format("{{\n  \"allocations\": {},\n  \"allocationBytes\": {},\n  \"runs\": [",
+                             allocationCount, allocSize);
+    bool first = true;
+    for (const auto mode: {StagingAllocMode::VirtualBlock, StagingAllocMode::Ring}) {
+      for (uint32_t threadCount = 1;; threadCount = std::min(threadCount * 2, maxThreads)) {
+        const auto seconds = runContention(bench, mode, threadCount, allocationCount, allocSize);
+        std::cout << std::format(
+          "{}\n    {{\"mode\": \"{}\", \"threads\": {}, \"ms\": {:.2f}, \"allocsPerSec\": {:.0f}}}",
+          first ? "" : ",", mode == StagingAllocMode::Ring ? "ring" : "virtualBlock", threadCount,
+          seconds * 1000.0, allocationCount / seconds);
+        first = false;
+        if (threadCount == maxThreads)
+          break;
+      }
+    }
+    std::cout << "\n  ]\n}" << std::endl;
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
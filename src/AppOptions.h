@@ -0,0 +1,124 @@
+#ifndef APPOPTIONS_H
+#define APPOPTIONS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+
+struct AppOptions {
+  bool headless = false; // Render into offscreen images, no window/surface/swapchain
+  uint32_t width = 1280;
+  uint32_t height = 720;
+  uint32_t frameCount = 300; // Headless only: frames to render before exit
+  uint32_t warmupFrames = 0; // Headless only: frames excluded from stats
+  float frameDelta = 1.0f / 60.0f; // Headless only: fixed simulation step
+  std::optional<std::filesystem::path> modelPath; // Load on startup
+  bool optimizeVertexCache = true; // Reorder model triangles for post-transform cache on import
+  bool frustumCulling = true; // GPU culling of draws outside of view frustum
+  bool occlusionCulling = true; // GPU culling of draws hidden behind previous frame depth
+  bool stagingRing = false; // Lock-free chunked ring staging allocator instead of VMA virtual block
+  uint32_t jobWorkers = std::max(std::thread::hardware_concurrency(), 2u) - 1; // Job system threads, one core is left to render thread
+  uint32_t uploadBudgetMb = 32; // Transfer bytes submitted per frame, 0 - unlimited
+  std::optional<std::filesystem::path> textureCacheDir; // Encode generic textures into BC7/BC5 KTX2 cache
+  uint32_t textureCacheMb = 2048; // Texture cache size cap
+  std::optional<std::filesystem::path> cameraPath; // Headless only: scripted camera
+  std::optional<std::filesystem::path> captureDir; // Headless only: write frames as PNG
+  std::optional<std::filesystem::path> statsOutput; // Headless only: frame stats JSON, "-" for stdout
+};
+
+static void printUsage(const char *exe, const AppOptions &defaults) {
+  std::cout << "Usage: " << exe << " [options]\n"
+      << "  --headless            Render offscreen without window (no display required)\n"
+      << "  --frames <N>          Headless: number of frames to render (default " << defaults.frameCount << ")\n"
+      << "  --warmup <N>          Headless: frames excluded from stats (default " << defaults.warmupFrames << ")\n"
+      << "  --size <W>x<H>        Render resolution (default " << defaults.width << "x" << defaults.height << ")\n"
+      << "  --model <path>        Load model on startup\n"
+      << "  --no-vertex-cache-opt Import models without triangle reorder for vertex cache\n"
+      << "  --no-frustum-culling  Disable GPU frustum culling\n"
+      << "  --no-occlusion-culling Disable GPU Hi-Z occlusion culling\n"
+      << "  --staging-ring        Use lock-free ring allocator for staging buffer\n"
+      << "  --workers <N>         Number of job system threads (default " << defaults.jobWorkers << ")\n"
+      << "  --upload-budget <MB>  Transfer bytes per frame, 0 - unlimited (default " << defaults.uploadBudgetMb << ")\n"
+      << "  --texture-cache <dir> Cache generic textures as BC7/BC5 KTX2 in dir\n"
+      << "  --texture-cache-size <MB> Texture cache size cap (default " << defaults.textureCacheMb << ")\n"
+      << "  --camera-path <path>  Headless: scripted camera path file\n"
+      << "  --capture <dir>       Headless: write every frame as PNG into dir\n"
+      << "  --stats <path>        Headless: write frame-time stats JSON, \"-\" for stdout\n";
+}
+
+/**
+ * Parse command line on top of given defaults
+ * @throws std::invalid_argument on unknown or malformed argument
+ */
+static AppOptions parseAppOptions(const int argc, char **argv, AppOptions options = {}) {
+  const auto defaults = options;
+  const auto next = [&](int &i) -> std::string {
+    if (i + 1 >= argc)
+      throw std::invalid_argument(std::format("Missing value for {}", argv[i]));
+    return argv[++i];
+  };
+
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    if (arg == "--headless") {
+      options.headless = true;
+    } else if (arg == "--frames") {
+      options.frameCount = static_cast<uint32_t>(std::stoul(next(i)));
+    } else if (arg == "--warmup") {
+      options.warmupFrames = static_cast<uint32_t>(std::stoul(next(i)));
+    } else if (arg == "--size") {
+      const auto value = next(i);
+      const auto x = value.find('x');
+      if (x == std::string::npos)
+        throw std::invalid_argument("Size must be in <W>x<H> format");
+      options.width = static_cast<uint32_t>(std::stoul(value.substr(0, x)));
+      options.height = static_cast<uint32_t>(std::stoul(value.substr(x + 1)));
+    } else if (arg == "--model") {
+      options.modelPath = next(i);
+    } else if (arg == "--no-vertex-cache-opt") {
+      options.optimizeVertexCache = false;
+    } else if (arg == "--no-frustum-culling") {
+      options.frustumCulling = false;
+    } else if (arg == "--no-occlusion-culling") {
+      options.occlusionCulling = false;
+    } else if (arg == "--staging-ring") {
+      options.stagingRing = true;
+    } else if (arg == "--workers") {
+      options.jobWorkers = static_cast<uint32_t>(std::stoul(next(i)));
+    } else if (arg == "--upload-budget") {
+      options.uploadBudgetMb = static_cast<uint32_t>(std::stoul(next(i)));
+    } else if (arg == "--texture-cache") {
+      options.textureCacheDir = next(i);
+    } else if (arg == "--texture-cache-size") {
+      options.textureCacheMb = static_cast<uint32_t>(std::stoul(next(i)));
+    } else if (arg == "--camera-path") {
+      options.cameraPath = next(i);
+    } else if (arg == "--capture") {
+      options.captureDir = next(i);
+    } else if (arg == "--stats") {
+      options.statsOutput = next(i);
+    } else if (arg == "--help" || arg == "-h") {
+      printUsage(argv[0], defaults);
+      std::exit(EXIT_SUCCESS);
+    } else {
+      throw std::invalid_argument(std::format("Unknown argument: {}", arg));
+    }
+  }
+
+  if (options.jobWorkers == 0)
+    throw std::invalid_argument("Job workers count must be greater than 0");
+  if (options.warmupFrames > 0 && options.warmupFrames >= options.frameCount)
+    throw std::invalid_argument("Warmup frames must be less than total frames");
+
+  return options;
+}
+
+#endif //APPOPTIONS_H
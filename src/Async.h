@@ -0,0 +1,258 @@
+#ifndef ASYNC_H
+#define ASYNC_H
+
+#include <coroutine>
+#include <exception>
+#include <format>
+#include <functional>
+#include <optional>
+#include <utility>
+#include <spdlog/spdlog.h>
+
+#include "JobSystem.h"
+
+template<typename T = void>
+class Task;
+
+/**
+ * Promise part shared by all results: stores exception and resumes awaiting coroutine on completion
+ */
+class TaskPromiseBase {
+public:
+  std::suspend_always initial_suspend() noexcept { return {}; }
+
+  /**
+   * Transfer control into awaiting coroutine, task frame stays suspended until <code>Task</code> is destroyed
+   */
+  struct FinalAwaiter {
+    std::coroutine_handle<> continuation;
+
+    bool await_ready() const noexcept { return false; }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<>) const noexcept { return continuation; }
+
+    void await_resume() const noexcept {
+    }
+  };
+
+  FinalAwaiter final_suspend() const noexcept { return {m_continuation}; }
+
+  void unhandled_exception() { m_exception = std::current_exception(); }
+
+  void setContinuation(const std::coroutine_handle<> continuation) { m_continuation = continuation; }
+
+protected:
+  void rethrow() const {
+    if (m_exception)
+      std::rethrow_exception(m_exception);
+  }
+
+private:
+  std::coroutine_handle<> m_continuation = std::noop_coroutine();
+  std::exception_ptr m_exception;
+};
+
+template<typename T>
+class TaskPromise : public TaskPromiseBase {
+public:
+  Task<T> get_return_object();
+
+  void return_value(T value) { m_value = std::move(value); }
+
+  T result() {
+    rethrow();
+    return std::move(*m_value);
+  }
+
+private:
+  std::optional<T> m_value;
+};
+
+template<>
+class TaskPromise<void> : public TaskPromiseBase {
+public:
+  Task<void> get_return_object();
+
+  void return_void() {
+  }
+
+  void result() const { rethrow(); }
+};
+
+/**
+ * @brief Lazy coroutine producing T
+ *
+ * Task starts when awaited and runs on awaiting thread until its first suspension,
+ * awaiting coroutine is resumed right after task completes (on the thread which completed it).
+ * Exception thrown by task is rethrown from <code>co_await</code>.
+ * Top-level task is started by <code>spawn</code>.
+ * @remark Arguments of coroutine are copied into its frame only when passed by value,
+ * reference arguments must outlive <code>co_await</code>
+ */
+template<typename T>
+class [[nodiscard]] Task {
+public:
+  using promise_type = TaskPromise<T>;
+
+  Task() = default;
+
+  explicit Task(const std::coroutine_handle<promise_type> handle) : m_handle(handle) {
+  }
+
+  Task(Task &&other) noexcept : m_handle(std::exchange(other.m_handle, {})) {
+  }
+
+  Task &operator=(Task &&other) noexcept {
+    if (this != &other) {
+      if (m_handle)
+        m_handle.destroy();
+      m_handle = std::exchange(other.m_handle, {});
+    }
+    return *this;
+  }
+
+  Task(const Task &) = delete;
+
+  Task &operator=(const Task &) = delete;
+
+  ~Task() {
+    if (m_handle)
+      m_handle.destroy();
+  }
+
+  bool await_ready() const noexcept { return !m_handle || m_handle.done(); }
+
+  std::coroutine_handle<> await_suspend(const std::coroutine_handle<> awaiting) noexcept {
+    m_handle.promise().setContinuation(awaiting);
+    return m_handle;
+  }
+
+  T await_resume() { return m_handle.promise().result(); }
+
+private:
+  std::coroutine_handle<promise_type> m_handle;
+};
+
+template<typename T>
+Task<T> TaskPromise<T>::get_return_object() {
+  return Task<T>(std::coroutine_handle<TaskPromise>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() {
+  return Task<void>(std::coroutine_handle<TaskPromise>::from_promise(*this));
+}
+
+/**
+ * Awaitable moving coroutine onto job system worker
+ */
+class ScheduleAwaiter {
+public:
+  ScheduleAwaiter(JobSystem &jobSystem, const JobPriority priority) : m_jobSystem(jobSystem), m_priority(priority) {
+  }
+
+  bool await_ready() const noexcept { return false; }
+
+  void await_suspend(const std::coroutine_handle<> handle) const {
+    m_jobSystem.submit([handle] { handle.resume(); }, m_priority);
+  }
+
+  void await_resume() const noexcept {
+  }
+
+private:
+  JobSystem &m_jobSystem;
+  JobPriority m_priority;
+};
+
+/**
+ * Continue coroutine as job of given priority, e.g. <code>co_await schedule(jobSystem, JobPriority::Low)</code>
+ */
+inline ScheduleAwaiter schedule(JobSystem &jobSystem, const JobPriority priority = JobPriority::Normal) {
+  return {jobSystem, priority};
+}
+
+/**
+ * @brief Awaitable over callback-based completion, resumes coroutine as job
+ *
+ * Subscribe function receives completion callback, it must call it exactly once with result
+ * (immediately when operation is already finished, e.g. from another thread later otherwise).
+ * Callback only submits resume job, so it may be called under completing side lock.
+ */
+class CompletionAwaiter {
+public:
+  using Callback = std::function<void(bool)>;
+  using Subscribe = std::function<void(Callback)>;
+
+  CompletionAwaiter(JobSystem &jobSystem, const JobPriority priority, Subscribe subscribe)
+    : m_jobSystem(jobSystem), m_priority(priority), m_subscribe(std::move(subscribe)) {
+  }
+
+  bool await_ready() const noexcept { return false; }
+
+  void await_suspend(const std::coroutine_handle<> handle) {
+    // Coroutine may resume and destroy awaiter before subscribe returns
+    const auto subscribe = std::move(m_subscribe);
+    subscribe([this, handle](const bool result) {
+      m_result = result;
+      m_jobSystem.submit([handle] { handle.resume(); }, m_priority);
+    });
+  }
+
+  bool await_resume() const noexcept { return m_result; }
+
+private:
+  JobSystem &m_jobSystem;
+  JobPriority m_priority;
+  Subscribe m_subscribe;
+  bool m_result = false;
+};
+
+/**
+ * Fire-and-forget coroutine driving spawned task, frame destroys itself on completion
+ */
+struct DetachedTask {
+  struct promise_type {
+    DetachedTask get_return_object() noexcept { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+
+    void return_void() noexcept {
+    }
+
+    void unhandled_exception() noexcept { std::terminate(); }
+  };
+};
+
+template<typename T>
+DetachedTask runDetached(JobSystem &jobSystem, Task<T> task, const JobPriority priority, JobCounter *counter) {
+  co_await schedule(jobSystem, priority);
+  {
+    // Task frame (and everything it holds) is released before counter, so waiter sees it destroyed
+    auto local = std::move(task);
+    try {
+      co_await local;
+    } catch (const std::exception &e) {
+      spdlog::error(std::format("Task failed: {}", e.what()));
+    }
+  }
+  if (counter)
+    jobSystem.release(*counter);
+}
+
+/**
+ * Start task as job, its result is dropped and exception is logged
+ * @param counter optional, covers whole task including time it is suspended, see <code>JobSystem::wait</code>
+ */
+template<typename T>
+void spawn(
+  JobSystem &jobSystem,
+  Task<T> task,
+  const JobPriority priority = JobPriority::Normal,
+  JobCounter *counter = nullptr
+) {
+  if (counter)
+    jobSystem.retain(*counter);
+  runDetached(jobSystem, std::move(task), priority, counter);
+}
+
+#endif //ASYNC_H
@@ -1,6 +1,7 @@
 #ifndef CAMERA_H
 #define CAMERA_H
 
+#include <array>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -88,12 +89,32 @@ public:
     rotation = glm::normalize(yaw_rotation * rotation * pitch_rotation);
   }
 
+  void setPose(const glm::vec3 &newPosition, const glm::quat &newRotation) {
+    position = newPosition;
+    rotation = glm::normalize(newRotation);
+    velocity = glm::vec3(0.0f);
+  }
+
   void updateFrustum() {
     auto halfAngleY = glm::tan(fov * 0.5f);
     auto halfAngleX = halfAngleY * aspectRatio;
 
     frustumCorners = glm::vec4(halfAngleX, -halfAngleY, halfAngleX * zFar, -halfAngleY * zFar);
     invFrustumCorners = glm::vec4(1.f / halfAngleX, -1.f / halfAngleY, 1.f / (halfAngleX * zFar), -1.f / (halfAngleY * zFar));
+
+    // World space planes (xyz = normal pointing inside, w = distance) extracted from view projection rows,
+    // clip space is reverse-Z: 0 <= z <= w
+    const auto m = glm::transpose(viewProj);
+    frustumPlanes = {
+      m[3] + m[0], // Left
+      m[3] - m[0], // Right
+      m[3] + m[1], // Bottom
+      m[3] - m[1], // Top
+      m[3] - m[2], // Near
+      m[2] // Far
+    };
+    for (auto &plane: frustumPlanes)
+      plane /= glm::length(glm::vec3(plane));
   }
 
   [[nodiscard]] glm::mat4 getView() const { return view; }
@@ -103,6 +124,7 @@ public:
   [[nodiscard]] glm::vec3 getViewPos() const { return position; }
   [[nodiscard]] glm::vec4 getFrustumCorners() const { return frustumCorners; }
   [[nodiscard]] glm::vec4 getInvFrustumCorners() const { return invFrustumCorners; }
+  [[nodiscard]] const std::array<glm::vec4, 6> &getFrustumPlanes() const { return frustumPlanes; }
 
   [[nodiscard]] float getZNear() const { return zNear; }
   [[nodiscard]] float getZFar() const { return zFar; }
@@ -127,6 +149,7 @@ private:
 
   glm::vec4 frustumCorners;
   glm::vec4 invFrustumCorners;
+  std::array<glm::vec4, 6> frustumPlanes{};
 };
 
 #endif //CAMERA_H
@@ -0,0 +1,102 @@
+#ifndef CAMERAPATH_H
+#define CAMERAPATH_H
+
+#include <algorithm>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+struct CameraKeyframe {
+  float time = 0.0f;
+  glm::vec3 position = glm::vec3(0.0f);
+  glm::quat rotation = glm::quat(glm::vec3(0.0f));
+};
+
+/**
+ * @brief Recorded camera path used for scripted (headless/benchmark) runs
+ *
+ * Path file is a plain text file, one keyframe per line:
+ * <code>time posX posY posZ yawDeg pitchDeg</code>.
+ * Empty lines and lines started with <code>#</code> are ignored.
+ * Keyframes must be sorted by time. Sampling interpolates position linearly
+ * and rotation spherically, time outside the path range is clamped.
+ */
+class CameraPath {
+public:
+  CameraPath() = default;
+
+  explicit CameraPath(std::vector<CameraKeyframe> keyframes) : m_keyframes(std::move(keyframes)) {
+  }
+
+  static CameraPath fromFile(const std::filesystem::path &path) {
+    auto file = std::ifstream(path);
+    if (!file.is_open())
+      throw std::runtime_error("Failed to open camera path file: " + path.string());
+
+    std::vector<CameraKeyframe> keyframes;
+    std::string line;
+    uint32_t lineNumber = 0;
+    while (std::getline(file, line)) {
+      ++lineNumber;
+      if (line.empty() || line.front() == '#')
+        continue;
+
+      auto stream = std::istringstream(line);
+      CameraKeyframe key;
+      float yaw = 0.0f, pitch = 0.0f;
+      if (!(stream >> key.time >> key.position.x >> key.position.y >> key.position.z >> yaw >> pitch))
+        throw std::runtime_error(std::format("Malformed camera path keyframe at {}:{}", path.string(), lineNumber));
+
+      key.rotation = makeRotation(yaw, pitch);
+      if (!keyframes.empty() && key.time < keyframes.back().time)
+        throw std::runtime_error(std::format("Camera path keyframes not sorted at {}:{}", path.string(), lineNumber));
+      keyframes.push_back(key);
+    }
+
+    if (keyframes.empty())
+      throw std::runtime_error("Camera path has no keyframes: " + path.string());
+
+    return CameraPath(std::move(keyframes));
+  }
+
+  static glm::quat makeRotation(const float yawDeg, const float pitchDeg) {
+    const auto yaw = glm::angleAxis(glm::radians(yawDeg), glm::vec3(0.0f, 1.0f, 0.0f));
+    const auto pitch = glm::angleAxis(glm::radians(pitchDeg), glm::vec3(1.0f, 0.0f, 0.0f));
+    return glm::normalize(yaw * pitch);
+  }
+
+  [[nodiscard]] CameraKeyframe sample(const float time) const {
+    if (m_keyframes.empty())
+      return {};
+    if (time <= m_keyframes.front().time)
+      return m_keyframes.front();
+    if (time >= m_keyframes.back().time)
+      return m_keyframes.back();
+
+    const auto next = std::ranges::upper_bound(m_keyframes, time, {}, &CameraKeyframe::time);
+    const auto &b = *next;
+    const auto &a = *(next - 1);
+    const float t = (time - a.time) / std::max(b.time - a.time, 1e-6f);
+
+    return CameraKeyframe{
+      .time = time,
+      .position = glm::mix(a.position, b.position, t),
+      .rotation = glm::slerp(a.rotation, b.rotation, t)
+    };
+  }
+
+  [[nodiscard]] bool empty() const { return m_keyframes.empty(); }
+  [[nodiscard]] float duration() const { return m_keyframes.empty() ? 0.0f : m_keyframes.back().time; }
+
+private:
+  std::vector<CameraKeyframe> m_keyframes;
+};
+
+#endif //CAMERAPATH_H
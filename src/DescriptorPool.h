@@ -7,10 +7,13 @@ class DescriptorPool {
 public:
   DescriptorPool() = default;
 
-  explicit DescriptorPool(const vk::Device &device) {
+  /**
+   * @param bindlessTextures combined image samplers of bindless texture tables of all sets, on top of common ones
+   */
+  explicit DescriptorPool(const vk::Device &device, const uint32_t bindlessTextures = 0) {
     auto pool_sizes = std::vector{
       vk::DescriptorPoolSize(vk::DescriptorType::eSampler, 1000),
-      vk::DescriptorPoolSize(vk::DescriptorType::eCombinedImageSampler, 1000),
+      vk::DescriptorPoolSize(vk::DescriptorType::eCombinedImageSampler, 1000 + bindlessTextures),
       vk::DescriptorPoolSize(vk::DescriptorType::eSampledImage, 1000),
       vk::DescriptorPoolSize(vk::DescriptorType::eStorageImage, 1000),
       vk::DescriptorPoolSize(vk::DescriptorType::eUniformTexelBuffer, 1000),
@@ -1,5 +1,7 @@
 #include "DescriptorSet.h"
 
+#include <algorithm>
+
 DescriptorSet::DescriptorSet(
   const vk::Device &device,
   const vk::DescriptorPool &descriptorPool,
@@ -71,7 +73,18 @@ void DescriptorSet::create(
 ) {
   if (!m_isPushDescriptor) {
     const auto setLayouts = std::vector(m_descriptorSetCount, m_descriptorSetLayout);
-    const auto info = vk::DescriptorSetAllocateInfo(descriptorPool, setLayouts);
+    auto info = vk::DescriptorSetAllocateInfo(descriptorPool, setLayouts);
+
+    // Variable count binding is allocated with its full count in every set
+    const auto variableLayout = std::ranges::find_if(m_descriptorLayouts, [](const DescriptorLayout &layout) {
+      return static_cast<bool>(layout.bindingFlags & vk::DescriptorBindingFlagBits::eVariableDescriptorCount);
+    });
+    const auto variableCounts = variableLayout != m_descriptorLayouts.end()
+                                  ? std::vector(m_descriptorSetCount, variableLayout->count)
+                                  : std::vector<uint32_t>();
+    const auto variableInfo = vk::DescriptorSetVariableDescriptorCountAllocateInfo(variableCounts);
+    if (!variableCounts.empty())
+      info.pNext = &variableInfo;
     m_descriptorSets = device.allocateDescriptorSets(info);
 
     for (int i = 0; i < m_descriptorSetCount; ++i) {
@@ -92,15 +105,19 @@ void DescriptorSet::create(
       } else if (layout.type == vk::DescriptorType::eCombinedImageSampler ||
                  layout.type == vk::DescriptorType::eInputAttachment || layout.type ==
                  vk::DescriptorType::eStorageImage) {
-        try {
-          for (int y = 0; y < layout.count; y++) {
-            auto writeInfo = vk::WriteDescriptorSet(
-              descriptorSet, layout.shaderBinding, {}, layout.count, layout.type,
-              &layout.imageInfos.at(y));
-            m_descriptorSetWrites.push_back(writeInfo);
-          }
-        } catch (std::out_of_range &_) {
-        }
+        // Empty - written later by updateTexture
+        if (layout.imageInfos.empty())
+          continue;
+
+        // count * setCount infos - own images for every set, otherwise images are shared by all sets
+        const bool perSet = m_descriptorSetCount > 1 &&
+                            layout.imageInfos.size() == static_cast<size_t>(layout.count) * m_descriptorSetCount;
+        const auto first = perSet ? i * layout.count : 0;
+        const auto imageCount = std::min<uint32_t>(layout.count, layout.imageInfos.size());
+        auto writeInfo = vk::WriteDescriptorSet(
+          descriptorSet, layout.shaderBinding, {}, imageCount, layout.type,
+          &layout.imageInfos[first]);
+        m_descriptorSetWrites.push_back(writeInfo);
       }
     }
 
@@ -155,6 +172,21 @@ void DescriptorSet::updateTexture(
   }
 }
 
+void DescriptorSet::updateTextures(
+  const vk::Device &device,
+  const uint32_t shaderBinding,
+  const uint32_t firstIndex,
+  const std::vector<vk::DescriptorImageInfo> &imageInfos,
+  const vk::DescriptorType type
+) const {
+  std::vector<vk::WriteDescriptorSet> writes;
+  writes.reserve(m_descriptorSets.size());
+  for (auto &descriptorSet: m_descriptorSets) {
+    writes.emplace_back(descriptorSet, shaderBinding, firstIndex, type, imageInfos);
+  }
+  device.updateDescriptorSets(writes, {});
+}
+
 const vk::PipelineLayout &DescriptorSet::getPipelineLayout() const {
   return m_pipelineLayout;
 }
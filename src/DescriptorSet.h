@@ -7,12 +7,12 @@
 struct DescriptorLayout {
   vk::DescriptorType type;
   vk::ShaderStageFlags stage;
-  vk::DescriptorBindingFlags bindingFlags;
+  vk::DescriptorBindingFlags bindingFlags; // VariableDescriptorCount binding must be the last one, it is allocated with count
   uint32_t shaderBinding;
   uint32_t count;
 
-  std::vector<vk::DescriptorImageInfo> imageInfos;
-  std::vector<vk::DescriptorBufferInfo> bufferInfos;
+  std::vector<vk::DescriptorImageInfo> imageInfos; // Shared by all sets, or count infos per set in set order
+  std::vector<vk::DescriptorBufferInfo> bufferInfos; // One per set
 };
 
 class DescriptorSet {
@@ -44,6 +44,17 @@ public:
     const vk::DescriptorType type = vk::DescriptorType::eCombinedImageSampler
   ) const;
 
+  /**
+   * Write consecutive array elements of image binding in every set by one update
+   */
+  void updateTextures(
+    const vk::Device &device,
+    uint32_t shaderBinding,
+    uint32_t firstIndex,
+    const std::vector<vk::DescriptorImageInfo> &imageInfos,
+    const vk::DescriptorType type = vk::DescriptorType::eCombinedImageSampler
+  ) const;
+
   [[nodiscard]] const vk::PipelineLayout &getPipelineLayout() const;
 
   void destroy(const vk::Device &device) const;
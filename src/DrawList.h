@@ -0,0 +1,257 @@
+#ifndef DRAWLIST_H
+#define DRAWLIST_H
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+#include "vulkan-memory-allocator-hpp/vk_mem_alloc.hpp"
+#include <glm/mat4x4.hpp>
+#include <tracy/Tracy.hpp>
+
+#include "BufferUtils.cpp"
+
+#define MAX_DRAWS 65535
+
+/**
+ * Per-draw data, read in geometry and culling shaders by draw index
+ * @remark Matches <code>DrawData</code> in geometry.ep.slang and cull.cmp.slang
+ */
+struct alignas(16) DrawData {
+  glm::mat4 model;
+  glm::mat4 normal; // Inverse transpose of model
+  glm::vec4 color;
+  glm::vec4 boundingSphere; // Mesh space, .xyz = center, .w = radius
+  uint32_t albedoTexIdx; // Slot in bindless texture table
+  uint32_t normalTexIdx;
+  uint32_t _pad[2];
+};
+
+/**
+ * @brief Per-frame list of indexed draws submitted with single indirect call
+ *
+ * Draw i gets <code>firstInstance = i</code>, so shader fetches its <code>DrawData</code>
+ * by instance index. CPU writes all candidate draws into host-visible buffers,
+ * culling compute shader (see <code>GpuCulling</code>) writes visible ones into
+ * device-local culled command buffer and its count. One set of buffers per frame in flight.
+ */
+class DrawList {
+public:
+  DrawList(
+    const vma::Allocator allocator,
+    const uint32_t frameCount,
+    const uint32_t maxDraws,
+    const bool multiDrawIndirect,
+    const bool drawIndirectCount
+  ) : m_allocator(allocator), m_maxDraws(maxDraws), m_multiDrawIndirect(multiDrawIndirect),
+      m_drawIndirectCount(drawIndirectCount) {
+    ZoneScoped;
+    m_frames.resize(frameCount);
+    for (auto &frame: m_frames) {
+      std::tie(frame.drawBuffer, frame.drawAlloc) = createBufferUnique(
+        allocator, sizeof(DrawData) * maxDraws, vk::BufferUsageFlagBits::eStorageBuffer,
+        vma::MemoryUsage::eAuto,
+        vma::AllocationCreateFlagBits::eMapped | vma::AllocationCreateFlagBits::eHostAccessSequentialWrite);
+      std::tie(frame.indirectBuffer, frame.indirectAlloc) = createBufferUnique(
+        allocator, sizeof(vk::DrawIndexedIndirectCommand) * maxDraws, vk::BufferUsageFlagBits::eStorageBuffer,
+        vma::MemoryUsage::eAuto,
+        vma::AllocationCreateFlagBits::eMapped | vma::AllocationCreateFlagBits::eHostAccessSequentialWrite);
+      std::tie(frame.culledBuffer, frame.culledAlloc) = createBufferUnique(
+        allocator, sizeof(vk::DrawIndexedIndirectCommand) * maxDraws,
+        vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer,
+        vma::MemoryUsage::eGpuOnly);
+      std::tie(frame.countBuffer, frame.countAlloc) = createBufferUnique(
+        allocator, sizeof(uint32_t),
+        vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer |
+        vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst,
+        vma::MemoryUsage::eGpuOnly);
+      std::tie(frame.readbackBuffer, frame.readbackAlloc) = createBufferUnique(
+        allocator, sizeof(uint32_t), vk::BufferUsageFlagBits::eTransferDst,
+        vma::MemoryUsage::eAuto,
+        vma::AllocationCreateFlagBits::eMapped | vma::AllocationCreateFlagBits::eHostAccessRandom);
+
+      frame.draws = static_cast<DrawData *>(allocator.mapMemory(frame.drawAlloc.get()));
+      frame.commands = static_cast<vk::DrawIndexedIndirectCommand *>(allocator.mapMemory(frame.indirectAlloc.get()));
+      frame.readback = static_cast<uint32_t *>(allocator.mapMemory(frame.readbackAlloc.get()));
+      if (!frame.draws || !frame.commands || !frame.readback)
+        throw std::runtime_error("Failed to map draw list buffers");
+      *frame.readback = 0;
+    }
+  }
+
+  ~DrawList() {
+    for (auto &frame: m_frames) {
+      if (frame.draws)
+        m_allocator.unmapMemory(frame.drawAlloc.get());
+      if (frame.commands)
+        m_allocator.unmapMemory(frame.indirectAlloc.get());
+      if (frame.readback)
+        m_allocator.unmapMemory(frame.readbackAlloc.get());
+    }
+  }
+
+  DrawList(const DrawList &) = delete;
+
+  DrawList &operator=(const DrawList &) = delete;
+
+  [[nodiscard]] std::vector<vk::DescriptorBufferInfo> getBufferInfos() const {
+    std::vector<vk::DescriptorBufferInfo> infos;
+    for (const auto &frame: m_frames)
+      infos.emplace_back(frame.drawBuffer.get(), 0, sizeof(DrawData) * m_maxDraws);
+    return infos;
+  }
+
+  [[nodiscard]] std::vector<vk::DescriptorBufferInfo> getCommandBufferInfos() const {
+    std::vector<vk::DescriptorBufferInfo> infos;
+    for (const auto &frame: m_frames)
+      infos.emplace_back(frame.indirectBuffer.get(), 0, sizeof(vk::DrawIndexedIndirectCommand) * m_maxDraws);
+    return infos;
+  }
+
+  [[nodiscard]] std::vector<vk::DescriptorBufferInfo> getCulledBufferInfos() const {
+    std::vector<vk::DescriptorBufferInfo> infos;
+    for (const auto &frame: m_frames)
+      infos.emplace_back(frame.culledBuffer.get(), 0, sizeof(vk::DrawIndexedIndirectCommand) * m_maxDraws);
+    return infos;
+  }
+
+  [[nodiscard]] std::vector<vk::DescriptorBufferInfo> getCountBufferInfos() const {
+    std::vector<vk::DescriptorBufferInfo> infos;
+    for (const auto &frame: m_frames)
+      infos.emplace_back(frame.countBuffer.get(), 0, sizeof(uint32_t));
+    return infos;
+  }
+
+  /**
+   * Start filling frame slot
+   * @remark Previous GPU work using this slot must be completed
+   */
+  void reset(const uint32_t frameIndex) { m_frames[frameIndex].count = 0; }
+
+  /**
+   * Append draw into frame slot
+   * @return false when list is full, draw is dropped
+   */
+  bool push(
+    const uint32_t frameIndex,
+    const DrawData &data,
+    const uint32_t indexCount,
+    const uint32_t firstIndex,
+    const int32_t vertexOffset
+  ) {
+    const auto [drawIndex, reserved] = reserve(frameIndex, 1);
+    if (reserved == 0)
+      return false;
+
+    write(frameIndex, drawIndex, data, indexCount, firstIndex, vertexOffset);
+    return true;
+  }
+
+  /**
+   * Append count consecutive draws into frame slot, they are filled by <code>DrawList::write</code>
+   * @return first reserved draw index and reserved count, less than requested when list gets full
+   */
+  std::pair<uint32_t, uint32_t> reserve(const uint32_t frameIndex, const uint32_t count) {
+    auto &frame = m_frames[frameIndex];
+    const auto first = frame.count;
+    const auto reserved = std::min(count, m_maxDraws - first);
+    frame.count += reserved;
+    return {first, reserved};
+  }
+
+  /**
+   * Fill reserved draw
+   * @remark Thread safe for distinct draw indices, so reserved range can be filled by parallel jobs
+   */
+  void write(
+    const uint32_t frameIndex,
+    const uint32_t drawIndex,
+    const DrawData &data,
+    const uint32_t indexCount,
+    const uint32_t firstIndex,
+    const int32_t vertexOffset
+  ) const {
+    const auto &frame = m_frames[frameIndex];
+    frame.draws[drawIndex] = data;
+    frame.commands[drawIndex] = vk::DrawIndexedIndirectCommand(indexCount, 1, firstIndex, vertexOffset, drawIndex);
+  }
+
+  /**
+   * Zero visible draw count before culling dispatch
+   */
+  void cmdResetCount(const vk::CommandBuffer cmd, const uint32_t frameIndex) const {
+    cmd.fillBuffer(m_frames[frameIndex].countBuffer.get(), 0, sizeof(uint32_t), 0);
+  }
+
+  /**
+   * Copy visible draw count into host readable buffer, see <code>DrawList::getVisibleCount</code>
+   * @remark Count must be made available for transfer reads by caller
+   */
+  void cmdReadbackCount(const vk::CommandBuffer cmd, const uint32_t frameIndex) const {
+    const auto &frame = m_frames[frameIndex];
+    cmd.copyBuffer(frame.countBuffer.get(), frame.readbackBuffer.get(), vk::BufferCopy(0, 0, sizeof(uint32_t)));
+  }
+
+  /**
+   * Draw culled list
+   * @remark Without <code>drawIndirectCount</code> culled list is not compacted,
+   * culled draws have zero instance count
+   */
+  void cmdDraw(const vk::CommandBuffer cmd, const uint32_t frameIndex) const {
+    ZoneScoped;
+    const auto &frame = m_frames[frameIndex];
+    if (frame.count == 0)
+      return;
+
+    constexpr auto stride = sizeof(vk::DrawIndexedIndirectCommand);
+    if (m_drawIndirectCount) {
+      cmd.drawIndexedIndirectCount(frame.culledBuffer.get(), 0, frame.countBuffer.get(), 0, frame.count, stride);
+    } else if (m_multiDrawIndirect) {
+      cmd.drawIndexedIndirect(frame.culledBuffer.get(), 0, frame.count, stride);
+    } else {
+      for (uint32_t i = 0; i < frame.count; ++i)
+        cmd.drawIndexedIndirect(frame.culledBuffer.get(), i * stride, 1, stride);
+    }
+  }
+
+  [[nodiscard]] uint32_t getCount(const uint32_t frameIndex) const { return m_frames[frameIndex].count; }
+
+  /**
+   * @return visible draws of last frame which used slot
+   * @remark Valid after frame slot fence is signaled
+   */
+  [[nodiscard]] uint32_t getVisibleCount(const uint32_t frameIndex) const {
+    const auto &frame = m_frames[frameIndex];
+    m_allocator.invalidateAllocation(frame.readbackAlloc.get(), 0, sizeof(uint32_t));
+    return *frame.readback;
+  }
+
+  [[nodiscard]] bool isCompacted() const { return m_drawIndirectCount; }
+  [[nodiscard]] uint32_t getMaxDraws() const { return m_maxDraws; }
+
+private:
+  struct Frame {
+    vma::UniqueBuffer drawBuffer;
+    vma::UniqueAllocation drawAlloc;
+    vma::UniqueBuffer indirectBuffer; // All candidate draws, written by CPU
+    vma::UniqueAllocation indirectAlloc;
+    vma::UniqueBuffer culledBuffer; // Visible draws, written by culling shader
+    vma::UniqueAllocation culledAlloc;
+    vma::UniqueBuffer countBuffer;
+    vma::UniqueAllocation countAlloc;
+    vma::UniqueBuffer readbackBuffer;
+    vma::UniqueAllocation readbackAlloc;
+    DrawData *draws = nullptr;
+    vk::DrawIndexedIndirectCommand *commands = nullptr;
+    uint32_t *readback = nullptr;
+    uint32_t count = 0;
+  };
+
+  vma::Allocator m_allocator = nullptr;
+  uint32_t m_maxDraws = 0;
+  bool m_multiDrawIndirect = false;
+  bool m_drawIndirectCount = false;
+  std::vector<Frame> m_frames;
+};
+
+#endif //DRAWLIST_H
@@ -0,0 +1,171 @@
+#ifndef FRAMESTATS_H
+#define FRAMESTATS_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <format>
+#include <numeric>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "GpuProfiler.h"
+
+struct StatSummary {
+  size_t count = 0;
+  double mean = 0.0;
+  double min = 0.0;
+  double max = 0.0;
+  double p50 = 0.0;
+  double p95 = 0.0;
+  double p99 = 0.0;
+
+  static StatSummary from(std::vector<double> values) {
+    StatSummary summary{};
+    if (values.empty())
+      return summary;
+
+    std::ranges::sort(values);
+    summary.count = values.size();
+    summary.mean = std::accumulate(values.begin(), values.end(), 0.0) / static_cast<double>(values.size());
+    summary.min = values.front();
+    summary.max = values.back();
+    summary.p50 = percentile(values, 50.0);
+    summary.p95 = percentile(values, 95.0);
+    summary.p99 = percentile(values, 99.0);
+    return summary;
+  }
+
+  [[nodiscard]] std::string toJson() const {
+    return std::format(
+      R"({{"count": {}, "mean": {:.4f}, "min": {:.4f}, "max": {:.4f}, "p50": {:.4f}, "p95": {:.4f}, "p99": {:.4f}}})",
+      count, mean, min, max, p50, p95, p99);
+  }
+
+private:
+  // Nearest-rank percentile, values must be sorted
+  static double percentile(const std::vector<double> &sorted, const double p) {
+    const auto rank = static_cast<size_t>(std::ceil(p / 100.0 * static_cast<double>(sorted.size())));
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+  }
+};
+
+struct FrameSample {
+  std::optional<double> cpuMs;
+  std::optional<GpuFrameTimings> gpu;
+};
+
+/**
+ * @brief Collects per-frame CPU/GPU timings of scripted run and reports them as JSON
+ *
+ * Frames below <code>warmupFrames</code> are recorded but excluded from summary.
+ * GPU timings arrive few frames later than CPU ones, so samples are addressed by frame number.
+ */
+class FrameStatsRecorder {
+public:
+  FrameStatsRecorder() = default;
+
+  /**
+   * @param firstFrame frame number of first recorded frame
+   * @param frameCount total frames to record including warmup
+   * @param warmupFrames frames excluded from summary
+   */
+  FrameStatsRecorder(const uint64_t firstFrame, const uint32_t frameCount, const uint32_t warmupFrames)
+    : m_samples(frameCount), m_firstFrame(firstFrame), m_warmupFrames(warmupFrames) {
+  }
+
+  void recordCpu(const uint64_t frameNumber, const double ms) {
+    if (const auto sample = at(frameNumber))
+      sample->cpuMs = ms;
+  }
+
+  void recordGpu(const GpuFrameTimings &timings) {
+    if (const auto sample = at(timings.frameNumber))
+      sample->gpu = timings;
+  }
+
+  /**
+   * @param metadata key-value pairs written as strings at the top of report
+   */
+  [[nodiscard]] std::string toJson(const std::vector<std::pair<std::string, std::string> > &metadata) const {
+    std::vector<double> cpu, gpuFrame;
+    std::array<std::vector<double>, GPU_PASS_COUNT> gpuPasses, vertexInvocations;
+    for (size_t i = m_warmupFrames; i < m_samples.size(); ++i) {
+      const auto &sample = m_samples[i];
+      if (sample.cpuMs)
+        cpu.push_back(*sample.cpuMs);
+      if (!sample.gpu)
+        continue;
+      if (sample.gpu->frameMs)
+        gpuFrame.push_back(*sample.gpu->frameMs);
+      for (uint32_t pass = 0; pass < GPU_PASS_COUNT; ++pass) {
+        if (sample.gpu->passMs[pass])
+          gpuPasses[pass].push_back(*sample.gpu->passMs[pass]);
+        if (sample.gpu->passVertexInvocations[pass])
+          vertexInvocations[pass].push_back(static_cast<double>(*sample.gpu->passVertexInvocations[pass]));
+      }
+    }
+
+    std::string json = "{\n";
+    for (const auto &[key, value]: metadata)
+      json += std::format("  \"{}\": \"{}\",\n", escape(key), escape(value));
+    json += std::format("  \"frames\": {},\n", m_samples.size());
+    json += std::format("  \"warmupFrames\": {},\n", m_warmupFrames);
+    json += std::format("  \"cpuFrameMs\": {},\n", StatSummary::from(std::move(cpu)).toJson());
+    json += std::format("  \"gpuFrameMs\": {},\n", StatSummary::from(std::move(gpuFrame)).toJson());
+    json += "  \"gpuPassMs\": " + passesToJson(gpuPasses) + ",\n";
+    json += "  \"gpuPassVertexInvocations\": " + passesToJson(vertexInvocations) + "\n";
+    json += "}\n";
+    return json;
+  }
+
+private:
+  std::vector<FrameSample> m_samples;
+  uint64_t m_firstFrame = 0;
+  uint32_t m_warmupFrames = 0;
+
+  FrameSample *at(const uint64_t frameNumber) {
+    if (frameNumber < m_firstFrame || frameNumber - m_firstFrame >= m_samples.size())
+      return nullptr;
+    return &m_samples[frameNumber - m_firstFrame];
+  }
+
+  static std::string passesToJson(std::array<std::vector<double>, GPU_PASS_COUNT> &passes) {
+    std::string json = "{\n";
+    for (uint32_t pass = 0; pass < GPU_PASS_COUNT; ++pass) {
+      json += std::format("    \"{}\": {}{}\n",
+                          gpuPassName(static_cast<GpuPass>(pass)),
+                          StatSummary::from(std::move(passes[pass])).toJson(),
+                          pass + 1 < GPU_PASS_COUNT ? "," : "");
+    }
+    return json + "  }";
+  }
+
+  static std::string escape(const std::string_view value) {
+    std::string result;
+    result.reserve(value.size());
+    for (const char c: value) {
+      switch (c) {
+        case '"': result += "\\\"";
+          break;
+        case '\\': result += "\\\\";
+          break;
+        case '\n': result += "\\n";
+          break;
+        case '\t': result += "\\t";
+          break;
+        default:
+          if (static_cast<unsigned char>(c) < 0x20)
+            result += std::format("\\u{:04x}", static_cast<int>(c));
+          else
+            result += c;
+      }
+    }
+    return result;
+  }
+};
+
+#endif //FRAMESTATS_H
@@ -0,0 +1,200 @@
+#ifndef GEOMETRYARENA_H
+#define GEOMETRYARENA_H
+
+#include <format>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+#include "vulkan-memory-allocator-hpp/vk_mem_alloc.hpp"
+#include <tracy/Tracy.hpp>
+
+#include "BufferUtils.cpp"
+#include "TransferThread.h"
+#include "UploadHandle.h"
+
+/**
+ * @brief Single device-local vertex and index buffer shared by all meshes
+ *
+ * Ranges are suballocated with VMA virtual blocks counted in elements (not bytes),
+ * so range offsets can be used directly as <code>vertexOffset</code>/<code>firstIndex</code>
+ * of indexed draws and every mesh is drawn with the same bound buffers.
+ * Capacity is fixed at creation, allocation throws when arena is full.
+ */
+template<typename VertexType, typename IndexType>
+class GeometryArena {
+public:
+  struct Range {
+    vma::VirtualAllocation vertexAlloc = nullptr;
+    vma::VirtualAllocation indexAlloc = nullptr;
+    int32_t vertexOffset = 0;
+    uint32_t vertexCount = 0;
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+  };
+
+  GeometryArena(
+    const vk::Device device,
+    const vma::Allocator allocator,
+    const uint32_t vertexCapacity,
+    const uint32_t indexCapacity
+  ) : m_vertexCapacity(vertexCapacity), m_indexCapacity(indexCapacity) {
+    ZoneScoped;
+    std::tie(m_vertexBuffer, m_vertexBufferAlloc) = createBufferUnique(
+      allocator,
+      static_cast<vk::DeviceSize>(vertexCapacity) * sizeof(VertexType),
+      vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer,
+      vma::MemoryUsage::eGpuOnly
+    );
+    std::tie(m_indexBuffer, m_indexBufferAlloc) = createBufferUnique(
+      allocator,
+      static_cast<vk::DeviceSize>(indexCapacity) * sizeof(IndexType),
+      vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eIndexBuffer,
+      vma::MemoryUsage::eGpuOnly
+    );
+    setObjectName(device, m_vertexBuffer.get(), "Geometry arena vertices");
+    setObjectName(device, m_indexBuffer.get(), "Geometry arena indices");
+
+    m_vertexBlock = vma::createVirtualBlockUnique(vma::VirtualBlockCreateInfo(vertexCapacity));
+    m_indexBlock = vma::createVirtualBlockUnique(vma::VirtualBlockCreateInfo(indexCapacity));
+  }
+
+  GeometryArena(const GeometryArena &) = delete;
+
+  GeometryArena &operator=(const GeometryArena &) = delete;
+
+  /**
+   * Reserve range and push its upload into transfer thread
+   * @throws std::runtime_error when arena has no space for mesh
+   */
+  Range add(
+    TransferThread &transferThread,
+    const std::vector<VertexType> &vertices,
+    const std::vector<IndexType> &indices,
+    const std::shared_ptr<UploadHandle> &handle
+  ) {
+    ZoneScoped;
+    Range range{};
+    range.vertexCount = static_cast<uint32_t>(vertices.size());
+    range.indexCount = static_cast<uint32_t>(indices.size());
+    {
+      std::lock_guard lock(m_mutex);
+      vk::DeviceSize vertexOffset = 0;
+      vk::DeviceSize indexOffset = 0;
+      const auto vertexInfo = vma::VirtualAllocationCreateInfo(vertices.size(), 1);
+      const auto indexInfo = vma::VirtualAllocationCreateInfo(indices.size(), 1);
+      if (m_vertexBlock->virtualAllocate(&vertexInfo, &range.vertexAlloc, &vertexOffset) != vk::Result::eSuccess)
+        throw std::runtime_error(std::format("Geometry arena is out of vertex space ({} vertices requested)",
+                                             vertices.size()));
+      if (m_indexBlock->virtualAllocate(&indexInfo, &range.indexAlloc, &indexOffset) != vk::Result::eSuccess) {
+        m_vertexBlock->virtualFree(range.vertexAlloc);
+        throw std::runtime_error(std::format("Geometry arena is out of index space ({} indices requested)",
+                                             indices.size()));
+      }
+      range.vertexOffset = static_cast<int32_t>(vertexOffset);
+      range.firstIndex = static_cast<uint32_t>(indexOffset);
+      m_usedVertices += range.vertexCount;
+      m_usedIndices += range.indexCount;
+    }
+
+    transferThread.uploadBuffer(
+      m_vertexBuffer.get(), vertices.data(), vertices.size() * sizeof(VertexType), handle,
+      static_cast<vk::DeviceSize>(range.vertexOffset) * sizeof(VertexType));
+    transferThread.uploadBuffer(
+      m_indexBuffer.get(), indices.data(), indices.size() * sizeof(IndexType), handle,
+      static_cast<vk::DeviceSize>(range.firstIndex) * sizeof(IndexType));
+    return range;
+  }
+
+  /**
+   * Release range
+   * @remark Range must not be used by GPU anymore and its upload must be finished
+   */
+  void free(const Range &range) {
+    ZoneScoped;
+    std::lock_guard lock(m_mutex);
+    m_vertexBlock->virtualFree(range.vertexAlloc);
+    m_indexBlock->virtualFree(range.indexAlloc);
+    m_usedVertices -= range.vertexCount;
+    m_usedIndices -= range.indexCount;
+  }
+
+  void cmdBind(const vk::CommandBuffer cmd) const {
+    cmd.bindVertexBuffers(0, m_vertexBuffer.get(), {0});
+    cmd.bindIndexBuffer(m_indexBuffer.get(), 0, IndexTypeFor<IndexType>);
+  }
+
+  [[nodiscard]] uint32_t getUsedVertices() const {
+    std::lock_guard lock(m_mutex);
+    return m_usedVertices;
+  }
+
+  [[nodiscard]] uint32_t getUsedIndices() const {
+    std::lock_guard lock(m_mutex);
+    return m_usedIndices;
+  }
+
+  [[nodiscard]] uint32_t getVertexCapacity() const { return m_vertexCapacity; }
+  [[nodiscard]] uint32_t getIndexCapacity() const { return m_indexCapacity; }
+
+private:
+  template<typename T>
+  static constexpr vk::IndexType IndexTypeFor = sizeof(T) == 2 ? vk::IndexType::eUint16 : vk::IndexType::eUint32;
+
+  const uint32_t m_vertexCapacity;
+  const uint32_t m_indexCapacity;
+
+  vma::UniqueBuffer m_vertexBuffer;
+  vma::UniqueAllocation m_vertexBufferAlloc;
+  vma::UniqueBuffer m_indexBuffer;
+  vma::UniqueAllocation m_indexBufferAlloc;
+
+  mutable TracyLockableN(std::mutex, m_mutex, "Geometry Arena Mutex");
+  vma::UniqueVirtualBlock m_vertexBlock;
+  vma::UniqueVirtualBlock m_indexBlock;
+  uint32_t m_usedVertices = 0;
+  uint32_t m_usedIndices = 0;
+};
+
+/**
+ * @brief Mesh geometry living in <code>GeometryArena</code>
+ *
+ * Range is released on destruction, after its upload is finished
+ */
+template<typename VertexType, typename IndexType>
+class ArenaMesh {
+public:
+  using Arena = GeometryArena<VertexType, IndexType>;
+
+  ArenaMesh(
+    Arena &arena,
+    TransferThread &transferThread,
+    const std::vector<VertexType> &vertices,
+    const std::vector<IndexType> &indices
+  ) : m_arena(arena) {
+    ZoneScoped;
+    m_upload = transferThread.makeHandle();
+    m_range = m_arena.add(transferThread, vertices, indices, m_upload);
+    m_upload->seal();
+  }
+
+  ~ArenaMesh() {
+    // Transfer may still write into arena range
+    m_upload->wait();
+    m_arena.free(m_range);
+  }
+
+  ArenaMesh(const ArenaMesh &) = delete;
+
+  ArenaMesh &operator=(const ArenaMesh &) = delete;
+
+  [[nodiscard]] const typename Arena::Range &getRange() const { return m_range; }
+  [[nodiscard]] bool isReady() const { return m_upload->isReady(); }
+
+private:
+  Arena &m_arena;
+  typename Arena::Range m_range{};
+  std::shared_ptr<UploadHandle> m_upload;
+};
+
+#endif //GEOMETRYARENA_H
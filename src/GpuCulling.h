@@ -0,0 +1,199 @@
+#ifndef GPUCULLING_H
+#define GPUCULLING_H
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+#include "vulkan-memory-allocator-hpp/vk_mem_alloc.hpp"
+#include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+#include <tracy/Tracy.hpp>
+
+#include "DescriptorSet.h"
+#include "DrawList.h"
+#include "GpuProfiler.h"
+#include "HiZPyramid.h"
+#include "Pipeline.h"
+#include "Ubo.h"
+
+#define CULL_FLAG_FRUSTUM (1u << 0)
+#define CULL_FLAG_OCCLUSION (1u << 1)
+#define CULL_FLAG_COMPACT (1u << 2)
+
+/**
+ * @remark Matches <code>CullUniforms</code> in cull.cmp.slang (scalar layout)
+ */
+struct alignas(16) CullUniforms {
+  glm::vec4 frustumPlanes[6]; // World space, normals point inside
+  glm::mat4 prevViewProj; // View projection Hi-Z pyramid was rendered with
+  glm::vec2 hizSize; // Mip 0 size in pixels
+  uint32_t drawCount;
+  uint32_t flags; // CULL_FLAG_*
+  uint32_t hizMipLevels;
+};
+
+/**
+ * @brief Compute pass culling draw list against view frustum and previous frame Hi-Z
+ *
+ * Each thread tests bounding sphere of one candidate draw of <code>DrawList</code>
+ * and writes visible ones into culled command buffer. Occlusion test uses depth
+ * pyramid of previous frame, so object which becomes visible is drawn one frame late.
+ * Owns <code>HiZPyramid</code>, both depend on depth buffer and are recreated with swapchain.
+ */
+class GpuCulling {
+public:
+  GpuCulling(
+    const vk::Device device,
+    const vma::Allocator allocator,
+    const vk::DescriptorPool descriptorPool,
+    const DrawList &drawList,
+    const uint32_t frameCount,
+    const vk::ImageView depthView,
+    const vk::Extent2D extent
+  ) : m_device(device) {
+    ZoneScoped;
+    m_hiz = std::make_unique<HiZPyramid>(device, allocator, descriptorPool, depthView, extent);
+
+    std::vector<vk::DescriptorBufferInfo> uniformInfos;
+    for (uint32_t i = 0; i < frameCount; ++i) {
+      m_uniforms.emplace_back(allocator,
+                              vk::MemoryPropertyFlagBits::eHostCoherent | vk::MemoryPropertyFlagBits::eHostVisible);
+      uniformInfos.emplace_back(m_uniforms.back().getBufferInfo());
+    }
+
+    const auto storage = [](const uint32_t binding, const std::vector<vk::DescriptorBufferInfo> &infos) {
+      return DescriptorLayout{
+        .type = vk::DescriptorType::eStorageBuffer,
+        .stage = vk::ShaderStageFlagBits::eCompute,
+        .bindingFlags = {},
+        .shaderBinding = binding,
+        .count = 1,
+        .imageInfos = {},
+        .bufferInfos = infos
+      };
+    };
+
+    m_descriptorSet = DescriptorSet(
+      device, descriptorPool, frameCount,
+      {
+        DescriptorLayout{
+          .type = vk::DescriptorType::eUniformBuffer,
+          .stage = vk::ShaderStageFlagBits::eCompute,
+          .bindingFlags = {},
+          .shaderBinding = 0,
+          .count = 1,
+          .imageInfos = {},
+          .bufferInfos = uniformInfos
+        },
+        storage(1, drawList.getBufferInfos()),
+        storage(2, drawList.getCommandBufferInfos()),
+        storage(3, drawList.getCulledBufferInfos()),
+        storage(4, drawList.getCountBufferInfos()),
+        DescriptorLayout{
+          .type = vk::DescriptorType::eCombinedImageSampler,
+          .stage = vk::ShaderStageFlagBits::eCompute,
+          .bindingFlags = {},
+          .shaderBinding = 5,
+          .count = 1,
+          .imageInfos = {m_hiz->getImageInfo()},
+          .bufferInfos = {}
+        }
+      }, {}, "Culling Descriptor Set");
+
+    m_pipeline = PipelineBuilder(
+      device, nullptr, m_descriptorSet.getPipelineLayout(),
+      "../res/shaders/culling/cull.cmp.slang.spv", "Culling Pipeline"
+    ).buildCompute();
+  }
+
+  ~GpuCulling() {
+    m_device.destroyPipeline(m_pipeline);
+    m_descriptorSet.destroy(m_device);
+  }
+
+  GpuCulling(const GpuCulling &) = delete;
+
+  GpuCulling &operator=(const GpuCulling &) = delete;
+
+  /**
+   * Record culling of filled draw list, must be recorded outside of render pass before geometry pass
+   * @param viewProj current view projection, used as Hi-Z reprojection matrix in next frame
+   */
+  void cmdCull(
+    const vk::CommandBuffer cmd,
+    const GpuProfiler &profiler,
+    const DrawList &drawList,
+    const std::array<glm::vec4, 6> &frustumPlanes,
+    const glm::mat4 &viewProj,
+    const bool frustum,
+    const bool occlusion,
+    const uint32_t frameIndex
+  ) {
+    ZoneScoped;
+    const auto drawCount = drawList.getCount(frameIndex);
+    // Occlusion test is valid only against pyramid built with known matrix
+    const bool testOcclusion = occlusion && m_hiz->isBuilt() && m_prevViewProjValid;
+
+    auto uniforms = CullUniforms{
+      .prevViewProj = m_prevViewProj,
+      .hizSize = glm::vec2(m_hiz->getExtent().width, m_hiz->getExtent().height),
+      .drawCount = drawCount,
+      .flags = (frustum ? CULL_FLAG_FRUSTUM : 0u) | (testOcclusion ? CULL_FLAG_OCCLUSION : 0u) |
+               (drawList.isCompacted() ? CULL_FLAG_COMPACT : 0u),
+      .hizMipLevels = m_hiz->getMipLevels()
+    };
+    std::ranges::copy(frustumPlanes, uniforms.frustumPlanes);
+    m_uniforms[frameIndex].map(uniforms);
+    m_prevViewProj = viewProj;
+    m_prevViewProjValid = true;
+
+    profiler.cmdBegin(cmd, frameIndex, GpuPass::Culling);
+    m_hiz->cmdInitialize(cmd);
+    drawList.cmdResetCount(cmd, frameIndex);
+    const auto resetBarrier = vk::MemoryBarrier2(
+      vk::PipelineStageFlagBits2::eClear, vk::AccessFlagBits2::eTransferWrite,
+      vk::PipelineStageFlagBits2::eComputeShader,
+      vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite);
+    cmd.pipelineBarrier2(vk::DependencyInfo({}, resetBarrier, {}, {}));
+
+    if (drawCount > 0) {
+      cmd.bindPipeline(vk::PipelineBindPoint::eCompute, m_pipeline);
+      m_descriptorSet.bind(cmd, frameIndex, {}, vk::PipelineBindPoint::eCompute);
+      cmd.dispatch((drawCount + 63) / 64, 1, 1);
+    }
+
+    const auto cullBarrier = vk::MemoryBarrier2(
+      vk::PipelineStageFlagBits2::eComputeShader | vk::PipelineStageFlagBits2::eClear,
+      vk::AccessFlagBits2::eShaderStorageWrite | vk::AccessFlagBits2::eTransferWrite,
+      vk::PipelineStageFlagBits2::eDrawIndirect | vk::PipelineStageFlagBits2::eCopy,
+      vk::AccessFlagBits2::eIndirectCommandRead | vk::AccessFlagBits2::eTransferRead);
+    cmd.pipelineBarrier2(vk::DependencyInfo({}, cullBarrier, {}, {}));
+    drawList.cmdReadbackCount(cmd, frameIndex);
+    profiler.cmdEnd(cmd, frameIndex, GpuPass::Culling);
+  }
+
+  /**
+   * Record Hi-Z pyramid build for next frame, must be recorded after render pass
+   */
+  void cmdBuildHiZ(const vk::CommandBuffer cmd, const GpuProfiler &profiler, const vk::Image depthImage,
+                   const uint32_t frameIndex) {
+    profiler.cmdBegin(cmd, frameIndex, GpuPass::HiZ);
+    m_hiz->cmdBuild(cmd, depthImage);
+    profiler.cmdEnd(cmd, frameIndex, GpuPass::HiZ);
+  }
+
+private:
+  vk::Device m_device;
+  std::unique_ptr<HiZPyramid> m_hiz;
+  std::vector<UniformBuffer<CullUniforms> > m_uniforms;
+  DescriptorSet m_descriptorSet;
+  vk::Pipeline m_pipeline;
+
+  glm::mat4 m_prevViewProj = glm::mat4(1.0f);
+  bool m_prevViewProjValid = false;
+};
+
+#endif //GPUCULLING_H
@@ -0,0 +1,200 @@
+#ifndef GPUPROFILER_H
+#define GPUPROFILER_H
+
+#include <vulkan/vulkan.hpp>
+#include <array>
+#include <optional>
+#include <vector>
+
+#include "utils.cpp"
+
+enum class GpuPass : uint32_t {
+  Culling = 0,
+  Clusters,
+  Geometry,
+  Lighting,
+  ImGui,
+  HiZ,
+  Count
+};
+
+constexpr auto GPU_PASS_COUNT = static_cast<uint32_t>(GpuPass::Count);
+
+static const char *gpuPassName(const GpuPass pass) {
+  switch (pass) {
+    case GpuPass::Culling: return "culling";
+    case GpuPass::Clusters: return "clusters";
+    case GpuPass::Geometry: return "geometry";
+    case GpuPass::Lighting: return "lighting";
+    case GpuPass::ImGui: return "imgui";
+    case GpuPass::HiZ: return "hiz";
+    default: return "unknown";
+  }
+}
+
+struct GpuFrameTimings {
+  uint64_t frameNumber = 0;
+  std::array<std::optional<double>, GPU_PASS_COUNT> passMs{}; // std::nullopt if pass was not recorded
+  std::optional<double> frameMs; // First pass begin -> last pass end
+  // std::nullopt if pass was not recorded or pipeline statistics are not supported
+  std::array<std::optional<uint64_t>, GPU_PASS_COUNT> passVertexInvocations{};
+};
+
+/**
+ * @brief Per-pass GPU timings based on timestamp queries
+ *
+ * Holds one begin/end timestamp pair for every pass in every frame slot.
+ * Timestamps can be written inside secondary command buffers, so a pass is
+ * measured exactly inside its subpass. When <code>pipelineStatisticsQuery</code>
+ * feature is enabled, vertex shader invocations are counted per pass as well.
+ *
+ * Usage per frame:
+ * 1. After frame slot fence is signaled call <code>GpuProfiler::collect</code>
+ * to read back timings of the frame which previously used the slot
+ * 2. Call <code>GpuProfiler::beginFrame</code> before recording
+ * 3. Wrap pass commands with <code>GpuProfiler::cmdBegin</code>/<code>GpuProfiler::cmdEnd</code>
+ */
+class GpuProfiler {
+public:
+  GpuProfiler(
+    const vk::Device device,
+    const vk::PhysicalDevice physicalDevice,
+    const uint32_t queueFamily,
+    const uint32_t frameSlots,
+    const bool pipelineStatistics = false
+  ): m_device(device), m_frameSlots(frameSlots) {
+    ZoneScoped;
+    const auto props = physicalDevice.getProperties();
+    const auto queueProps = physicalDevice.getQueueFamilyProperties();
+    m_timestampPeriod = props.limits.timestampPeriod;
+    m_enabled = queueProps.at(queueFamily).timestampValidBits != 0 && m_timestampPeriod > 0.0f;
+    if (!m_enabled) {
+      spdlog::warn("Timestamp queries not supported by graphics queue, GPU timings disabled");
+      return;
+    }
+
+    const auto info = vk::QueryPoolCreateInfo({}, vk::QueryType::eTimestamp, queryCount());
+    m_queryPool = m_device.createQueryPoolUnique(info);
+    setObjectName(m_device, m_queryPool.get(), "GPU profiler query pool");
+    m_device.resetQueryPool(m_queryPool.get(), 0, queryCount());
+    m_slotFrames.resize(frameSlots);
+
+    if (pipelineStatistics) {
+      const auto statsInfo = vk::QueryPoolCreateInfo(
+        {}, vk::QueryType::ePipelineStatistics, frameSlots * GPU_PASS_COUNT,
+        vk::QueryPipelineStatisticFlagBits::eVertexShaderInvocations);
+      m_statsPool = m_device.createQueryPoolUnique(statsInfo);
+      setObjectName(m_device, m_statsPool.get(), "GPU profiler statistics pool");
+      m_device.resetQueryPool(m_statsPool.get(), 0, frameSlots * GPU_PASS_COUNT);
+    }
+  }
+
+  GpuProfiler(const GpuProfiler &) = delete;
+
+  GpuProfiler &operator=(const GpuProfiler &) = delete;
+
+  [[nodiscard]] bool isEnabled() const { return m_enabled; }
+
+  void beginFrame(const uint32_t slot, const uint64_t frameNumber) {
+    if (!m_enabled) return;
+    m_slotFrames[slot] = frameNumber;
+  }
+
+  void cmdBegin(const vk::CommandBuffer cmd, const uint32_t slot, const GpuPass pass) const {
+    if (!m_enabled) return;
+    cmd.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, m_queryPool.get(), queryIndex(slot, pass));
+    if (m_statsPool)
+      cmd.beginQuery(m_statsPool.get(), statsIndex(slot, pass), {});
+  }
+
+  void cmdEnd(const vk::CommandBuffer cmd, const uint32_t slot, const GpuPass pass) const {
+    if (!m_enabled) return;
+    if (m_statsPool)
+      cmd.endQuery(m_statsPool.get(), statsIndex(slot, pass));
+    cmd.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, m_queryPool.get(), queryIndex(slot, pass) + 1);
+  }
+
+  /**
+   * Read back timings of the last frame recorded into slot and reset slot queries
+   * @remark Must be called only after GPU finished the frame (slot fence signaled)
+   * @param slot frame slot
+   * @return timings or std::nullopt if slot was not used since last collect
+   */
+  std::optional<GpuFrameTimings> collect(const uint32_t slot) {
+    ZoneScoped;
+    if (!m_enabled || !m_slotFrames[slot])
+      return std::nullopt;
+
+    constexpr uint32_t queriesPerSlot = GPU_PASS_COUNT * 2;
+    // Every query returns value + availability pair
+    std::array<uint64_t, queriesPerSlot * 2> data{};
+    const auto result = m_device.getQueryPoolResults(
+      m_queryPool.get(), slot * queriesPerSlot, queriesPerSlot,
+      sizeof(data), data.data(), sizeof(uint64_t) * 2,
+      vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWithAvailability);
+    if (result != vk::Result::eSuccess && result != vk::Result::eNotReady)
+      return std::nullopt;
+
+    GpuFrameTimings timings{.frameNumber = *m_slotFrames[slot]};
+    std::optional<uint64_t> first, last;
+    for (uint32_t pass = 0; pass < GPU_PASS_COUNT; ++pass) {
+      const auto begin = data[pass * 4 + 0];
+      const auto beginAvailable = data[pass * 4 + 1] != 0;
+      const auto end = data[pass * 4 + 2];
+      const auto endAvailable = data[pass * 4 + 3] != 0;
+      if (!beginAvailable || !endAvailable || end < begin)
+        continue;
+
+      timings.passMs[pass] = ticksToMs(end - begin);
+      first = first ? std::min(*first, begin) : begin;
+      last = last ? std::max(*last, end) : end;
+    }
+    if (first && last)
+      timings.frameMs = ticksToMs(*last - *first);
+
+    if (m_statsPool) {
+      // Single statistic per query + availability
+      std::array<uint64_t, GPU_PASS_COUNT * 2> stats{};
+      const auto statsResult = m_device.getQueryPoolResults(
+        m_statsPool.get(), slot * GPU_PASS_COUNT, GPU_PASS_COUNT,
+        sizeof(stats), stats.data(), sizeof(uint64_t) * 2,
+        vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWithAvailability);
+      if (statsResult == vk::Result::eSuccess || statsResult == vk::Result::eNotReady) {
+        for (uint32_t pass = 0; pass < GPU_PASS_COUNT; ++pass) {
+          if (stats[pass * 2 + 1] != 0)
+            timings.passVertexInvocations[pass] = stats[pass * 2];
+        }
+      }
+      m_device.resetQueryPool(m_statsPool.get(), slot * GPU_PASS_COUNT, GPU_PASS_COUNT);
+    }
+
+    m_device.resetQueryPool(m_queryPool.get(), slot * queriesPerSlot, queriesPerSlot);
+    m_slotFrames[slot].reset();
+    return timings;
+  }
+
+private:
+  vk::Device m_device = nullptr;
+  vk::UniqueQueryPool m_queryPool;
+  vk::UniqueQueryPool m_statsPool; // Optional, vertex shader invocations per pass
+  uint32_t m_frameSlots = 0;
+  float m_timestampPeriod = 0.0f; // ns per tick
+  bool m_enabled = false;
+  std::vector<std::optional<uint64_t> > m_slotFrames;
+
+  [[nodiscard]] uint32_t queryCount() const { return m_frameSlots * GPU_PASS_COUNT * 2; }
+
+  [[nodiscard]] static uint32_t queryIndex(const uint32_t slot, const GpuPass pass) {
+    return (slot * GPU_PASS_COUNT + static_cast<uint32_t>(pass)) * 2;
+  }
+
+  [[nodiscard]] static uint32_t statsIndex(const uint32_t slot, const GpuPass pass) {
+    return slot * GPU_PASS_COUNT + static_cast<uint32_t>(pass);
+  }
+
+  [[nodiscard]] double ticksToMs(const uint64_t ticks) const {
+    return static_cast<double>(ticks) * m_timestampPeriod / 1'000'000.0;
+  }
+};
+
+#endif //GPUPROFILER_H
@@ -0,0 +1,217 @@
+#ifndef HIZPYRAMID_H
+#define HIZPYRAMID_H
+
+#include <algorithm>
+#include <bit>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+#include "vulkan-memory-allocator-hpp/vk_mem_alloc.hpp"
+#include <glm/vec2.hpp>
+#include <tracy/Tracy.hpp>
+
+#include "DescriptorSet.h"
+#include "Pipeline.h"
+#include "utils.cpp"
+
+struct HiZPushConsts {
+  glm::uvec2 srcSize;
+  glm::uvec2 dstSize;
+};
+
+/**
+ * @brief Hierarchical depth pyramid built from depth buffer
+ *
+ * Mip 0 has depth buffer resolution, every next mip keeps farthest depth
+ * (minimum, depth is reverse-Z) of covered texels, so a single sample gives
+ * conservative occluder depth for screen region. Pyramid is built at the end of
+ * frame and used for occlusion culling in the next one, it stays in General layout.
+ */
+class HiZPyramid {
+public:
+  HiZPyramid(
+    const vk::Device device,
+    const vma::Allocator allocator,
+    const vk::DescriptorPool descriptorPool,
+    const vk::ImageView depthView,
+    const vk::Extent2D extent
+  ) : m_device(device), m_extent(extent) {
+    ZoneScoped;
+    m_mipLevels = std::bit_width(std::max(extent.width, extent.height));
+    std::tie(m_image, m_imageAlloc) = createImageUnique(
+      allocator, extent.width, extent.height, m_mipLevels,
+      vk::SampleCountFlagBits::e1, vk::Format::eR32Sfloat, vk::ImageTiling::eOptimal,
+      vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eTransferDst,
+      vk::MemoryPropertyFlagBits::eDeviceLocal
+    );
+    setObjectName(device, m_image.get(), "Hi-Z pyramid");
+
+    const auto fullRange = vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, m_mipLevels, 0, 1);
+    m_view = device.createImageViewUnique(
+      vk::ImageViewCreateInfo({}, m_image.get(), vk::ImageViewType::e2D, vk::Format::eR32Sfloat, {}, fullRange));
+    for (uint32_t mip = 0; mip < m_mipLevels; ++mip) {
+      m_mipViews.emplace_back(createImageViewUnique(
+        device, m_image.get(), vk::Format::eR32Sfloat, vk::ImageAspectFlagBits::eColor, mip));
+    }
+
+    auto samplerInfo = vk::SamplerCreateInfo();
+    samplerInfo.setMagFilter(vk::Filter::eNearest)
+        .setMinFilter(vk::Filter::eNearest)
+        .setMipmapMode(vk::SamplerMipmapMode::eNearest)
+        .setAddressModeU(vk::SamplerAddressMode::eClampToEdge)
+        .setAddressModeV(vk::SamplerAddressMode::eClampToEdge)
+        .setAddressModeW(vk::SamplerAddressMode::eClampToEdge)
+        .setMinLod(0.0f)
+        .setMaxLod(vk::LodClampNone);
+    m_sampler = device.createSamplerUnique(samplerInfo);
+    setObjectName(device, m_sampler.get(), "Hi-Z sampler");
+
+    // Set i reduces mip i - 1 (or depth buffer) into mip i
+    std::vector<vk::DescriptorImageInfo> srcInfos, dstInfos;
+    for (uint32_t mip = 0; mip < m_mipLevels; ++mip) {
+      srcInfos.emplace_back(
+        m_sampler.get(),
+        mip == 0 ? depthView : m_mipViews[mip - 1].get(),
+        mip == 0 ? vk::ImageLayout::eDepthStencilReadOnlyOptimal : vk::ImageLayout::eGeneral);
+      dstInfos.emplace_back(nullptr, m_mipViews[mip].get(), vk::ImageLayout::eGeneral);
+    }
+
+    m_descriptorSet = DescriptorSet(
+      device, descriptorPool, m_mipLevels,
+      {
+        DescriptorLayout{
+          .type = vk::DescriptorType::eCombinedImageSampler,
+          .stage = vk::ShaderStageFlagBits::eCompute,
+          .bindingFlags = {},
+          .shaderBinding = 0,
+          .count = 1,
+          .imageInfos = srcInfos,
+          .bufferInfos = {}
+        },
+        DescriptorLayout{
+          .type = vk::DescriptorType::eStorageImage,
+          .stage = vk::ShaderStageFlagBits::eCompute,
+          .bindingFlags = {},
+          .shaderBinding = 1,
+          .count = 1,
+          .imageInfos = dstInfos,
+          .bufferInfos = {}
+        }
+      }, {
+        vk::PushConstantRange(vk::ShaderStageFlagBits::eCompute, 0, sizeof(HiZPushConsts))
+      }, "Hi-Z Descriptor Set");
+
+    m_pipeline = PipelineBuilder(
+      device, nullptr, m_descriptorSet.getPipelineLayout(),
+      "../res/shaders/culling/hiz.cmp.slang.spv", "Hi-Z Pipeline"
+    ).buildCompute();
+  }
+
+  ~HiZPyramid() {
+    m_device.destroyPipeline(m_pipeline);
+    m_descriptorSet.destroy(m_device);
+  }
+
+  HiZPyramid(const HiZPyramid &) = delete;
+
+  HiZPyramid &operator=(const HiZPyramid &) = delete;
+
+  /**
+   * Clear pyramid to far depth once, so culling may read it before first build (nothing is occluded)
+   */
+  void cmdInitialize(const vk::CommandBuffer cmd) {
+    if (m_initialized)
+      return;
+
+    const auto range = vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, m_mipLevels, 0, 1);
+    const auto toTransfer = vk::ImageMemoryBarrier2(
+      vk::PipelineStageFlagBits2::eNone, vk::AccessFlagBits2::eNone,
+      vk::PipelineStageFlagBits2::eClear, vk::AccessFlagBits2::eTransferWrite,
+      vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal,
+      vk::QueueFamilyIgnored, vk::QueueFamilyIgnored, m_image.get(), range);
+    cmd.pipelineBarrier2(vk::DependencyInfo({}, {}, {}, toTransfer));
+    cmd.clearColorImage(m_image.get(), vk::ImageLayout::eTransferDstOptimal,
+                        vk::ClearColorValue(0.0f, 0.0f, 0.0f, 0.0f), range);
+    const auto toGeneral = vk::ImageMemoryBarrier2(
+      vk::PipelineStageFlagBits2::eClear, vk::AccessFlagBits2::eTransferWrite,
+      vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderSampledRead,
+      vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eGeneral,
+      vk::QueueFamilyIgnored, vk::QueueFamilyIgnored, m_image.get(), range);
+    cmd.pipelineBarrier2(vk::DependencyInfo({}, {}, {}, toGeneral));
+    m_initialized = true;
+  }
+
+  /**
+   * Record pyramid build from depth buffer
+   * @remark Must be recorded after render pass, depth is expected in DepthStencilReadOnlyOptimal layout
+   */
+  void cmdBuild(const vk::CommandBuffer cmd, const vk::Image depthImage) {
+    ZoneScoped;
+    const std::array barriers = {
+      vk::ImageMemoryBarrier2(
+        vk::PipelineStageFlagBits2::eLateFragmentTests, vk::AccessFlagBits2::eDepthStencilAttachmentWrite,
+        vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderSampledRead,
+        vk::ImageLayout::eDepthStencilReadOnlyOptimal, vk::ImageLayout::eDepthStencilReadOnlyOptimal,
+        vk::QueueFamilyIgnored, vk::QueueFamilyIgnored, depthImage,
+        vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eDepth, 0, 1, 0, 1)),
+      // Previous pyramid is discarded, wait for culling reads of it
+      vk::ImageMemoryBarrier2(
+        vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderSampledRead,
+        vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageWrite,
+        vk::ImageLayout::eUndefined, vk::ImageLayout::eGeneral,
+        vk::QueueFamilyIgnored, vk::QueueFamilyIgnored, m_image.get(),
+        vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, m_mipLevels, 0, 1)),
+    };
+    cmd.pipelineBarrier2(vk::DependencyInfo({}, {}, {}, barriers));
+
+    cmd.bindPipeline(vk::PipelineBindPoint::eCompute, m_pipeline);
+    auto srcSize = glm::uvec2(m_extent.width, m_extent.height);
+    for (uint32_t mip = 0; mip < m_mipLevels; ++mip) {
+      const auto dstSize = glm::uvec2(std::max(m_extent.width >> mip, 1u), std::max(m_extent.height >> mip, 1u));
+      const auto push = HiZPushConsts{.srcSize = srcSize, .dstSize = dstSize};
+      m_descriptorSet.bind(cmd, mip, {}, vk::PipelineBindPoint::eCompute);
+      cmd.pushConstants(m_descriptorSet.getPipelineLayout(), vk::ShaderStageFlagBits::eCompute, 0, sizeof(push), &push);
+      cmd.dispatch((dstSize.x + 7) / 8, (dstSize.y + 7) / 8, 1);
+
+      // Next mip reduction and next frame culling read this mip
+      const auto mipBarrier = vk::ImageMemoryBarrier2(
+        vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageWrite,
+        vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderSampledRead,
+        vk::ImageLayout::eGeneral, vk::ImageLayout::eGeneral,
+        vk::QueueFamilyIgnored, vk::QueueFamilyIgnored, m_image.get(),
+        vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, mip, 1, 0, 1));
+      cmd.pipelineBarrier2(vk::DependencyInfo({}, {}, {}, mipBarrier));
+      srcSize = dstSize;
+    }
+    m_initialized = true;
+    m_built = true;
+  }
+
+  [[nodiscard]] vk::DescriptorImageInfo getImageInfo() const {
+    return {m_sampler.get(), m_view.get(), vk::ImageLayout::eGeneral};
+  }
+
+  /**
+   * @return true when pyramid build was recorded at least once, so it can be used for culling
+   */
+  [[nodiscard]] bool isBuilt() const { return m_built; }
+  [[nodiscard]] vk::Extent2D getExtent() const { return m_extent; }
+  [[nodiscard]] uint32_t getMipLevels() const { return m_mipLevels; }
+
+private:
+  vk::Device m_device;
+  vk::Extent2D m_extent;
+  uint32_t m_mipLevels = 1;
+  bool m_initialized = false;
+  bool m_built = false;
+
+  vma::UniqueImage m_image;
+  vma::UniqueAllocation m_imageAlloc;
+  vk::UniqueImageView m_view;
+  std::vector<vk::UniqueImageView> m_mipViews;
+  vk::UniqueSampler m_sampler;
+
+  DescriptorSet m_descriptorSet;
+  vk::Pipeline m_pipeline;
+};
+
+#endif //HIZPYRAMID_H
@@ -0,0 +1,295 @@
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <format>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+#include <spdlog/spdlog.h>
+#include <tracy/Tracy.hpp>
+
+enum class JobPriority : uint32_t {
+  High, // Frame work, render thread waits for it
+  Normal, // Texture loads and mesh conversion
+  Low, // Long background work, e.g. model import
+  Count
+};
+
+/**
+ * Number of unfinished jobs of a group, see <code>JobSystem::wait</code> and <code>JobSystem::submitAfter</code>
+ * @remark Must outlive its jobs and continuations, release it only after <code>JobSystem::wait</code> returned
+ */
+class JobCounter {
+public:
+  JobCounter() = default;
+
+  JobCounter(const JobCounter &) = delete;
+
+  JobCounter &operator=(const JobCounter &) = delete;
+
+  [[nodiscard]] bool isDone() const { return m_pending.load() == 0; }
+
+private:
+  friend class JobSystem;
+
+  struct Continuation {
+    std::function<void()> fn;
+    JobPriority priority;
+    JobCounter *counter;
+  };
+
+  std::atomic_uint32_t m_pending = 0;
+  std::mutex m_mutex; // Plain mutex, counters are created per job group and would flood Tracy lock list
+  std::vector<Continuation> m_continuations; // Submitted when counter reaches zero
+};
+
+/**
+ * @brief Work-stealing job scheduler shared by all subsystems
+ *
+ * Every worker has own deque per priority, jobs submitted from worker go into its deques and are taken
+ * from back (newest first, data is still in cache), idle workers steal from front of other deques.
+ * Jobs submitted from other threads go into shared injection deques. Worker always takes the most urgent
+ * job it can find, so frame work overtakes queued loads on every core.
+ *
+ * Jobs may block (file reads, staging buffer allocation), waiting on <code>JobCounter</code> runs other
+ * jobs instead, so jobs waiting for child jobs never starve the pool.
+ *
+ * Multi-step work can be written as coroutine (see <code>Task</code> in Async.h) resumed on workers.
+ *
+ * Exception thrown from job is logged and job counts as finished.
+ * Queued jobs are dropped on destruction, owners wait for their counters before that.
+ */
+class JobSystem {
+public:
+  explicit JobSystem(const uint32_t workerCount) {
+    ZoneScoped;
+    // Last queue is injection one, filled by non-worker threads
+    const auto count = std::max(workerCount, 1u);
+    for (uint32_t i = 0; i <= count; ++i)
+      m_queues.push_back(std::make_unique<Queue>());
+    for (uint32_t i = 0; i < count; ++i)
+      m_workers.emplace_back([this, i] { workerLoop(i); });
+    spdlog::info(std::format("Job system started with {} workers", count));
+  }
+
+  ~JobSystem() {
+    m_stop = true;
+    {
+      std::lock_guard lock(m_sleepMutex);
+    }
+    m_sleepCv.notify_all();
+    for (auto &worker: m_workers) {
+      if (worker.joinable())
+        worker.join();
+    }
+  }
+
+  JobSystem(const JobSystem &) = delete;
+
+  JobSystem &operator=(const JobSystem &) = delete;
+
+  [[nodiscard]] uint32_t getWorkerCount() const { return static_cast<uint32_t>(m_workers.size()); }
+
+  /**
+   * Queue job, it runs on any worker
+   * @param counter optional, incremented now and decremented when job finishes
+   */
+  void submit(std::function<void()> fn, const JobPriority priority = JobPriority::Normal, JobCounter *counter = nullptr) {
+    if (counter)
+      ++counter->m_pending;
+    push(Job{std::move(fn), priority, counter});
+  }
+
+  /**
+   * Queue job once all jobs of dependency are finished
+   * @param counter optional, incremented now, so it also covers time job waits for dependency
+   */
+  void submitAfter(
+    JobCounter &dependency,
+    std::function<void()> fn,
+    const JobPriority priority = JobPriority::Normal,
+    JobCounter *counter = nullptr
+  ) {
+    if (counter)
+      ++counter->m_pending;
+    {
+      std::lock_guard lock(dependency.m_mutex);
+      if (dependency.m_pending.load() > 0) {
+        dependency.m_continuations.push_back({std::move(fn), priority, counter});
+        return;
+      }
+    }
+    push(Job{std::move(fn), priority, counter});
+  }
+
+  /**
+   * Count work which does not run as single job (e.g. suspended coroutine, see <code>spawn</code>) into counter
+   * @remark Must be paired with <code>JobSystem::release</code>
+   */
+  void retain(JobCounter &counter) { ++counter.m_pending; }
+
+  /**
+   * Finish work counted by <code>JobSystem::retain</code>, submits continuations of counter when it reaches zero
+   */
+  void release(JobCounter &counter) { finish(counter); }
+
+  /**
+   * Block until every job of counter is finished, other jobs are run meanwhile.
+   * Worker runs jobs of any priority, other threads (render thread) run only high priority ones,
+   * so background loads never land on them.
+   */
+  void wait(JobCounter &counter) {
+    ZoneScoped;
+    const auto helpPriority = t_system == this ? JobPriority::Low : JobPriority::High;
+    const auto self = t_system == this ? t_workerIndex : injectionQueue();
+    while (!counter.isDone()) {
+      if (auto job = takeJob(self, helpPriority)) {
+        execute(*job);
+        continue;
+      }
+      std::this_thread::yield();
+    }
+    // Finishing thread may still hold counter mutex, counter can be released after it unlocks
+    std::lock_guard lock(counter.m_mutex);
+  }
+
+  /**
+   * Run fn(begin, end) over [0, count) split into ranges of grain elements,
+   * calling thread takes first range and helps with the rest
+   */
+  template<typename Fn>
+  void parallelFor(const uint32_t count, const uint32_t grain, Fn &&fn, const JobPriority priority = JobPriority::High) {
+    ZoneScoped;
+    const auto step = std::max(grain, 1u);
+    if (count <= step) {
+      fn(0u, count);
+      return;
+    }
+    JobCounter counter;
+    for (uint32_t begin = step; begin < count; begin += step) {
+      submit([&fn, begin, end = std::min(begin + step, count)] { fn(begin, end); }, priority, &counter);
+    }
+    fn(0u, step);
+    wait(counter);
+  }
+
+private:
+  struct Job {
+    std::function<void()> fn;
+    JobPriority priority = JobPriority::Normal;
+    JobCounter *counter = nullptr;
+  };
+
+  struct Queue {
+    TracyLockableN(std::mutex, mutex, "Job Queue Mutex");
+    std::array<std::deque<Job>, static_cast<size_t>(JobPriority::Count)> deques;
+  };
+
+  inline static thread_local JobSystem *t_system = nullptr;
+  inline static thread_local uint32_t t_workerIndex = 0;
+
+  std::vector<std::unique_ptr<Queue> > m_queues; // Per worker, then injection queue
+  std::vector<std::thread> m_workers;
+  std::atomic_bool m_stop = false;
+  std::atomic_uint32_t m_queuedJobs = 0;
+  std::atomic_uint32_t m_sleepingWorkers = 0;
+  TracyLockableN(std::mutex, m_sleepMutex, "Job Sleep Mutex");
+  std::condition_variable_any m_sleepCv;
+
+  [[nodiscard]] uint32_t injectionQueue() const { return static_cast<uint32_t>(m_queues.size() - 1); }
+
+  void push(Job job) {
+    const auto index = t_system == this ? t_workerIndex : injectionQueue();
+    ++m_queuedJobs; // Counted before it is visible, so count never underflows
+    {
+      auto &queue = *m_queues[index];
+      std::lock_guard lock(queue.mutex);
+      queue.deques[static_cast<size_t>(job.priority)].push_back(std::move(job));
+    }
+    if (m_sleepingWorkers.load() > 0) {
+      // Sleeping worker checks queued count under this mutex, so wake up is never lost
+      {
+        std::lock_guard lock(m_sleepMutex);
+      }
+      m_sleepCv.notify_one();
+    }
+  }
+
+  /**
+   * Take the most urgent job up to maxPriority: own deque back first, then front of other deques
+   * @param self queue of calling thread
+   */
+  std::optional<Job> takeJob(const uint32_t self, const JobPriority maxPriority) {
+    if (m_queuedJobs.load() == 0)
+      return std::nullopt;
+    const auto queueCount = static_cast<uint32_t>(m_queues.size());
+    for (size_t p = 0; p <= static_cast<size_t>(maxPriority); ++p) {
+      for (uint32_t i = 0; i < queueCount; ++i) {
+        const auto index = (self + i) % queueCount;
+        auto &queue = *m_queues[index];
+        std::lock_guard lock(queue.mutex);
+        auto &deque = queue.deques[p];
+        if (deque.empty())
+          continue;
+        auto job = std::optional<Job>();
+        if (index == self) {
+          job = std::move(deque.back());
+          deque.pop_back();
+        } else {
+          job = std::move(deque.front());
+          deque.pop_front();
+        }
+        --m_queuedJobs;
+        return job;
+      }
+    }
+    return std::nullopt;
+  }
+
+  void execute(Job &job) {
+    try {
+      job.fn();
+    } catch (const std::exception &e) {
+      spdlog::error(std::format("Job failed: {}", e.what()));
+    }
+    if (job.counter)
+      finish(*job.counter);
+  }
+
+  void finish(JobCounter &counter) {
+    std::vector<JobCounter::Continuation> continuations; {
+      std::lock_guard lock(counter.m_mutex);
+      if (--counter.m_pending > 0)
+        return;
+      continuations.swap(counter.m_continuations);
+    }
+    for (auto &continuation: continuations)
+      push(Job{std::move(continuation.fn), continuation.priority, continuation.counter});
+  }
+
+  void workerLoop(const uint32_t workerIndex) {
+    t_system = this;
+    t_workerIndex = workerIndex;
+    tracy::SetThreadNameWithHint(std::format("Job Worker {}", workerIndex).c_str(), UINT8_MAX);
+    while (!m_stop.load()) {
+      if (auto job = takeJob(workerIndex, JobPriority::Low)) {
+        execute(*job);
+        continue;
+      }
+      std::unique_lock lock(m_sleepMutex);
+      ++m_sleepingWorkers;
+      m_sleepCv.wait(lock, [this] { return m_stop.load() || m_queuedJobs.load() > 0; });
+      --m_sleepingWorkers;
+    }
+  }
+};
+
+#endif //JOBSYSTEM_H
@@ -3,7 +3,10 @@
 
 #include "utils.cpp"
 
-#define MAX_LIGHTS 64
+#include <random>
+
+#define MAX_LIGHTS 4096
+#define RANDOM_LIGHTS_BATCH 256
 
 enum class LightType {
   SPOT = -1,
@@ -18,22 +21,18 @@ struct alignas(16) LightData {
   glm::vec4 info; // .x/.y = inner/outer cone angle (for spotlights), .z = linear attenuation, .w = exp attenuation
 };
 
-struct alignas(16) LightPushConsts {
-  uint32_t lightCount;
-};
-
 class LightManager {
 public:
   LightManager() = default;
 
-  LightManager(const vma::Allocator allocator, const size_t imageCount) : m_allocator(allocator) {
+  LightManager(const vma::Allocator allocator, const size_t frameCount) : m_allocator(allocator) {
     constexpr auto bufferSize = sizeof(LightData) * MAX_LIGHTS;
-    m_ssboBuffers.resize(imageCount);
-    m_ssboAllocations.resize(imageCount);
-    m_ssboMappings.resize(imageCount);
-    m_bufferInfos.resize(imageCount);
+    m_ssboBuffers.resize(frameCount);
+    m_ssboAllocations.resize(frameCount);
+    m_ssboMappings.resize(frameCount);
+    m_bufferInfos.resize(frameCount);
 
-    for (int i = 0; i < imageCount; ++i) {
+    for (int i = 0; i < frameCount; ++i) {
       std::tie(m_ssboBuffers[i], m_ssboAllocations[i]) = createBufferUnique(
         allocator, bufferSize, vk::BufferUsageFlagBits::eStorageBuffer,
         vma::MemoryUsage::eAuto, vma::AllocationCreateFlagBits::eMapped | vma::AllocationCreateFlagBits::eHostAccessSequentialWrite);
@@ -61,9 +60,17 @@ public:
   [[nodiscard]] std::vector<LightData> getLights() const { return m_lights; }
   [[nodiscard]] std::vector<std::string> getNames() const { return m_lightsNames; }
 
-  void addLight(const LightData &light, const std::string &name = "Light") {
+  /**
+   * @return false when light limit is reached, light is dropped
+   */
+  bool addLight(const LightData &light, const std::string &name = "Light") {
+    if (m_lights.size() >= MAX_LIGHTS) {
+      spdlog::warn(std::format("Light limit ({}) reached, light {} is dropped", MAX_LIGHTS, name));
+      return false;
+    }
     m_lights.emplace_back(light);
     m_lightsNames.emplace_back(name);
+    return true;
   }
 
   void editLight(const uint32_t idx, const LightData &light) {
@@ -72,8 +79,8 @@ public:
     }
   }
 
-  void map(const uint32_t imageIndex) {
-    std::ranges::copy(m_lights, m_ssboMappings[imageIndex]);
+  void map(const uint32_t frameIndex) {
+    std::ranges::copy(m_lights, m_ssboMappings[frameIndex]);
   }
 
   void renderImGui() {
@@ -86,13 +93,20 @@ public:
         light.info = glm::vec4(0.0f, 0.0f, 0.35f, 0.44f);
         addLight(light, std::format("Light {}", m_lights.size()));
       }
+      ImGui::SameLine();
+      if (ImGui::Button(std::format("Add {} random lights", RANDOM_LIGHTS_BATCH).c_str()))
+        addRandomLights(RANDOM_LIGHTS_BATCH);
+      ImGui::Text("Lights: %u / %u", getCount(), MAX_LIGHTS);
       ImGui::Separator();
 
       for (size_t i = 0; i < m_lights.size(); ++i) {
         LightData &light = m_lights[i];
         ImGui::PushID(static_cast<int>(i));
+        if (!ImGui::TreeNode(m_lightsNames[i].c_str())) {
+          ImGui::PopID();
+          continue;
+        }
 
-        ImGui::Text(m_lightsNames[i].c_str());
         int type = static_cast<int>(light.position.w);
         ImGui::Text("Type: ");
         ImGui::SameLine();
@@ -134,7 +148,7 @@ public:
           --i;
         }
 
-        ImGui::Separator();
+        ImGui::TreePop();
         ImGui::PopID();
       }
     }
@@ -142,7 +156,26 @@ public:
   }
 
 private:
+  /**
+   * Scatter small point lights over scene area for clustered lighting stress test
+   */
+  void addRandomLights(const uint32_t count) {
+    std::uniform_real_distribution position(-10.0f, 10.0f);
+    std::uniform_real_distribution height(0.0f, 5.0f);
+    std::uniform_real_distribution color(0.2f, 1.0f);
+    for (uint32_t i = 0; i < count; ++i) {
+      LightData light{};
+      light.position = glm::vec4(position(m_random), height(m_random), position(m_random), LightType::POINT);
+      light.color = glm::vec4(color(m_random), color(m_random), color(m_random), 1.0f);
+      light.direction = glm::vec4(0.0f, -1.0f, 0.0f, 1.0f);
+      light.info = glm::vec4(0.0f, 0.0f, 1.0f, 16.0f); // ~4 units range at full intensity
+      if (!addLight(light, std::format("Light {}", m_lights.size())))
+        break;
+    }
+  }
+
   vma::Allocator m_allocator;
+  std::mt19937 m_random{42};
   std::vector<LightData> m_lights = {};
   std::vector<std::string> m_lightsNames = {};
   bool m_uiOpen = true;
@@ -0,0 +1,190 @@
+#ifndef LIGHTCLUSTERS_H
+#define LIGHTCLUSTERS_H
+
+#include <format>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+#include "vulkan-memory-allocator-hpp/vk_mem_alloc.hpp"
+#include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <tracy/Tracy.hpp>
+
+#include "BufferUtils.cpp"
+#include "Camera.h"
+#include "DescriptorSet.h"
+#include "GpuProfiler.h"
+#include "Pipeline.h"
+#include "Ubo.h"
+
+#define CLUSTER_GRID_X 16
+#define CLUSTER_GRID_Y 9
+#define CLUSTER_GRID_Z 24
+#define CLUSTER_COUNT (CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z)
+#define MAX_LIGHTS_PER_CLUSTER 256
+
+/**
+ * @remark Matches <code>ClusterUniforms</code> in clusters.cmp.slang and light.ep.slang (scalar layout)
+ */
+struct alignas(16) ClusterUniforms {
+  glm::mat4 view;
+  glm::vec4 frustumCorners; // See Camera::getFrustumCorners
+  glm::vec2 screenSize;
+  float zNear;
+  float zFar;
+  glm::uvec3 gridSize;
+  uint32_t maxLightsPerCluster;
+  uint32_t lightCount;
+};
+
+/**
+ * @brief Clustered light assignment for deferred lighting
+ *
+ * View frustum is split into screen tiles and exponential depth slices, compute pass
+ * (clusters.cmp.slang) writes indices of lights whose range touches each cluster,
+ * lighting subpass shades pixel with lights of its cluster only. Every cluster holds
+ * up to <code>MAX_LIGHTS_PER_CLUSTER</code> lights, extra lights are dropped.
+ * Buffers live for whole app, descriptor set and pipeline are recreated with descriptor pool.
+ */
+class LightClusters {
+public:
+  LightClusters(
+    const vk::Device device,
+    const vma::Allocator allocator,
+    const uint32_t frameCount
+  ) : m_device(device) {
+    ZoneScoped;
+    constexpr auto clusterBufferSize = sizeof(uint32_t) * CLUSTER_COUNT * (MAX_LIGHTS_PER_CLUSTER + 1);
+    m_clusterBuffers.resize(frameCount);
+    m_clusterAllocs.resize(frameCount);
+    for (uint32_t i = 0; i < frameCount; ++i) {
+      m_uniforms.emplace_back(allocator,
+                              vk::MemoryPropertyFlagBits::eHostCoherent | vk::MemoryPropertyFlagBits::eHostVisible);
+      std::tie(m_clusterBuffers[i], m_clusterAllocs[i]) = createBufferUnique(
+        allocator, clusterBufferSize, vk::BufferUsageFlagBits::eStorageBuffer, vma::MemoryUsage::eGpuOnly);
+      setObjectName(device, m_clusterBuffers[i].get(), std::format("Light clusters {}", i));
+    }
+  }
+
+  ~LightClusters() {
+    destroyPipeline();
+  }
+
+  LightClusters(const LightClusters &) = delete;
+
+  LightClusters &operator=(const LightClusters &) = delete;
+
+  /**
+   * Create compute descriptor set and pipeline
+   * @param lightInfos per-frame light buffers of <code>LightManager</code>
+   */
+  void createPipeline(const vk::DescriptorPool descriptorPool, const std::vector<vk::DescriptorBufferInfo> &lightInfos) {
+    ZoneScoped;
+    m_descriptorSet = DescriptorSet(
+      m_device, descriptorPool, static_cast<uint32_t>(m_uniforms.size()),
+      {
+        DescriptorLayout{
+          .type = vk::DescriptorType::eUniformBuffer,
+          .stage = vk::ShaderStageFlagBits::eCompute,
+          .bindingFlags = {},
+          .shaderBinding = 0,
+          .count = 1,
+          .imageInfos = {},
+          .bufferInfos = getUniformInfos()
+        },
+        DescriptorLayout{
+          .type = vk::DescriptorType::eStorageBuffer,
+          .stage = vk::ShaderStageFlagBits::eCompute,
+          .bindingFlags = {},
+          .shaderBinding = 1,
+          .count = 1,
+          .imageInfos = {},
+          .bufferInfos = lightInfos
+        },
+        DescriptorLayout{
+          .type = vk::DescriptorType::eStorageBuffer,
+          .stage = vk::ShaderStageFlagBits::eCompute,
+          .bindingFlags = {},
+          .shaderBinding = 2,
+          .count = 1,
+          .imageInfos = {},
+          .bufferInfos = getClusterInfos()
+        }
+      }, {}, "Light Clusters Descriptor Set");
+
+    m_pipeline = PipelineBuilder(
+      m_device, nullptr, m_descriptorSet.getPipelineLayout(),
+      "../res/shaders/deferred/clusters.cmp.slang.spv", "Light Clusters Pipeline"
+    ).buildCompute();
+  }
+
+  void destroyPipeline() {
+    if (!m_pipeline)
+      return;
+    m_device.destroyPipeline(m_pipeline);
+    m_descriptorSet.destroy(m_device);
+    m_pipeline = nullptr;
+  }
+
+  /**
+   * Record light assignment, must be recorded outside of render pass before lighting subpass
+   */
+  void cmdBuild(
+    const vk::CommandBuffer cmd,
+    const GpuProfiler &profiler,
+    const Camera &camera,
+    const vk::Extent2D extent,
+    const uint32_t lightCount,
+    const uint32_t frameIndex
+  ) {
+    ZoneScoped;
+    m_uniforms[frameIndex].map(ClusterUniforms{
+      .view = camera.getView(),
+      .frustumCorners = camera.getFrustumCorners(),
+      .screenSize = glm::vec2(extent.width, extent.height),
+      .zNear = camera.getZNear(),
+      .zFar = camera.getZFar(),
+      .gridSize = glm::uvec3(CLUSTER_GRID_X, CLUSTER_GRID_Y, CLUSTER_GRID_Z),
+      .maxLightsPerCluster = MAX_LIGHTS_PER_CLUSTER,
+      .lightCount = lightCount
+    });
+
+    profiler.cmdBegin(cmd, frameIndex, GpuPass::Clusters);
+    cmd.bindPipeline(vk::PipelineBindPoint::eCompute, m_pipeline);
+    m_descriptorSet.bind(cmd, frameIndex, {}, vk::PipelineBindPoint::eCompute);
+    cmd.dispatch((CLUSTER_COUNT + 63) / 64, 1, 1);
+
+    const auto barrier = vk::BufferMemoryBarrier2(
+      vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageWrite,
+      vk::PipelineStageFlagBits2::eFragmentShader, vk::AccessFlagBits2::eShaderStorageRead,
+      vk::QueueFamilyIgnored, vk::QueueFamilyIgnored, m_clusterBuffers[frameIndex].get(), 0, vk::WholeSize);
+    cmd.pipelineBarrier2(vk::DependencyInfo({}, {}, barrier, {}));
+    profiler.cmdEnd(cmd, frameIndex, GpuPass::Clusters);
+  }
+
+  [[nodiscard]] std::vector<vk::DescriptorBufferInfo> getUniformInfos() const {
+    std::vector<vk::DescriptorBufferInfo> infos;
+    for (const auto &uniform: m_uniforms)
+      infos.emplace_back(uniform.getBufferInfo());
+    return infos;
+  }
+
+  [[nodiscard]] std::vector<vk::DescriptorBufferInfo> getClusterInfos() const {
+    std::vector<vk::DescriptorBufferInfo> infos;
+    for (const auto &buffer: m_clusterBuffers)
+      infos.emplace_back(buffer.get(), 0, vk::WholeSize);
+    return infos;
+  }
+
+private:
+  vk::Device m_device;
+  std::vector<UniformBuffer<ClusterUniforms> > m_uniforms;
+  std::vector<vma::UniqueBuffer> m_clusterBuffers; // Per cluster: light count, then MAX_LIGHTS_PER_CLUSTER indices
+  std::vector<vma::UniqueAllocation> m_clusterAllocs;
+
+  DescriptorSet m_descriptorSet;
+  vk::Pipeline m_pipeline = nullptr;
+};
+
+#endif //LIGHTCLUSTERS_H
@@ -0,0 +1,125 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <stdexcept>
+#include <tracy/Tracy.hpp>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief Read-only memory mapping of whole asset file
+ *
+ * Decoders read file through page cache without <code>read()</code> copies.
+ * <code>MappedFile::prefetch</code> starts asynchronous read-ahead, so file mapped when its
+ * load is queued is usually resident when worker decodes it and disk I/O overlaps with decode.
+ * @throws std::runtime_error when file can not be opened or mapped
+ */
+class MappedFile {
+public:
+  explicit MappedFile(const std::filesystem::path &path) {
+    ZoneScoped;
+#ifdef _WIN32
+    m_file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                         FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (m_file == INVALID_HANDLE_VALUE)
+      throw std::runtime_error("Failed to open file: " + path.string());
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_file, &size)) {
+      CloseHandle(m_file);
+      throw std::runtime_error("Failed to get file size: " + path.string());
+    }
+    m_size = static_cast<size_t>(size.QuadPart);
+    if (m_size > 0) {
+      m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      m_data = m_mapping ? static_cast<const uint8_t *>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+      if (!m_data) {
+        if (m_mapping)
+          CloseHandle(m_mapping);
+        CloseHandle(m_file);
+        throw std::runtime_error("Failed to map file: " + path.string());
+      }
+    }
+#else
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+      throw std::runtime_error("Failed to open file: " + path.string());
+    struct stat st{};
+    if (fstat(fd, &st) != 0) {
+      close(fd);
+      throw std::runtime_error("Failed to get file size: " + path.string());
+    }
+    m_size = static_cast<size_t>(st.st_size);
+    if (m_size > 0) {
+      void *data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data == MAP_FAILED) {
+        close(fd);
+        throw std::runtime_error("Failed to map file: " + path.string());
+      }
+      m_data = static_cast<const uint8_t *>(data);
+      madvise(data, m_size, MADV_SEQUENTIAL);
+    }
+    close(fd); // Mapping keeps file alive
+#endif
+  }
+
+  ~MappedFile() {
+#ifdef _WIN32
+    if (m_data)
+      UnmapViewOfFile(m_data);
+    if (m_mapping)
+      CloseHandle(m_mapping);
+    CloseHandle(m_file);
+#else
+    if (m_data)
+      munmap(const_cast<uint8_t *>(m_data), m_size);
+#endif
+  }
+
+  MappedFile(const MappedFile &) = delete;
+
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  /**
+   * Start asynchronous read of whole file into page cache, returns immediately
+   */
+  void prefetch() const {
+    if (!m_data)
+      return;
+    ZoneScoped;
+#ifdef _WIN32
+    auto range = WIN32_MEMORY_RANGE_ENTRY{const_cast<uint8_t *>(m_data), m_size};
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+    madvise(const_cast<uint8_t *>(m_data), m_size, MADV_WILLNEED);
+#endif
+  }
+
+  [[nodiscard]] std::span<const uint8_t> data() const { return {m_data, m_size}; }
+  [[nodiscard]] size_t size() const { return m_size; }
+
+private:
+  const uint8_t *m_data = nullptr;
+  size_t m_size = 0;
+#ifdef _WIN32
+  HANDLE m_file = INVALID_HANDLE_VALUE;
+  HANDLE m_mapping = nullptr;
+#endif
+};
+
+#endif //MAPPEDFILE_H
@@ -1,5 +1,139 @@
 #include "Model.h"
 
+#include <assimp/config.h>
+#include <assimp/DefaultIOSystem.h>
+#include <assimp/IOStream.hpp>
+#include <assimp/ProgressHandler.hpp>
+
+#include "MappedFile.h"
+
+/**
+ * Report Assimp import progress into model and abort import on cancel
+ * @remark Owned and destroyed by Assimp::Importer
+ */
+class ModelImportProgressHandler final : public Assimp::ProgressHandler {
+public:
+  ModelImportProgressHandler(std::atomic<float> &progress, const std::atomic_bool &cancelled)
+    : m_progress(progress), m_cancelled(cancelled) {
+  }
+
+  bool Update(const float percentage) override {
+    if (percentage >= 0.0f)
+      m_progress = std::clamp(percentage, 0.0f, 1.0f);
+    return !m_cancelled.load();
+  }
+
+private:
+  std::atomic<float> &m_progress;
+  const std::atomic_bool &m_cancelled;
+};
+
+/**
+ * Read-only Assimp stream over memory mapped file
+ */
+class MappedIOStream final : public Assimp::IOStream {
+public:
+  explicit MappedIOStream(std::unique_ptr<MappedFile> file) : m_file(std::move(file)) {
+  }
+
+  size_t Read(void *buffer, const size_t size, const size_t count) override {
+    if (size == 0)
+      return 0;
+    const auto available = (m_file->size() - m_position) / size;
+    const auto read = std::min(count, available);
+    memcpy(buffer, m_file->data().data() + m_position, read * size);
+    m_position += read * size;
+    return read;
+  }
+
+  size_t Write(const void *, size_t, size_t) override { return 0; }
+
+  aiReturn Seek(const size_t offset, const aiOrigin origin) override {
+    // End origin counts offset back from file end, same as Assimp memory stream
+    const auto size = m_file->size();
+    if (origin == aiOrigin_END) {
+      if (offset > size)
+        return aiReturn_FAILURE;
+      m_position = size - offset;
+      return aiReturn_SUCCESS;
+    }
+    const auto base = origin == aiOrigin_CUR ? m_position : 0;
+    if (base + offset > size)
+      return aiReturn_FAILURE;
+    m_position = base + offset;
+    return aiReturn_SUCCESS;
+  }
+
+  [[nodiscard]] size_t Tell() const override { return m_position; }
+  [[nodiscard]] size_t FileSize() const override { return m_file->size(); }
+
+  void Flush() override {
+  }
+
+private:
+  std::unique_ptr<MappedFile> m_file;
+  size_t m_position = 0;
+};
+
+/**
+ * Assimp file system reading model and its external buffers through memory mappings,
+ * file is prefetched on open so its read overlaps with parsing of previously opened ones
+ * @remark Owned and destroyed by Assimp::Importer
+ */
+class MappedIOSystem final : public Assimp::DefaultIOSystem {
+public:
+  Assimp::IOStream *Open(const char *file, const char *mode) override {
+    if (std::string_view(mode).find_first_of("wa+") != std::string_view::npos)
+      return DefaultIOSystem::Open(file, mode);
+    try {
+      auto mapped = std::make_unique<MappedFile>(file);
+      mapped->prefetch();
+      return new MappedIOStream(std::move(mapped));
+    } catch (const std::runtime_error &) {
+      return nullptr; // Missing file, Assimp reports it
+    }
+  }
+};
+
+// Post-transform cache size used for Tipsify reorder and ACMR simulation
+constexpr uint32_t VERTEX_CACHE_SIZE = 32;
+// Draws written by one job in Model::fillDrawList
+constexpr uint32_t DRAW_FILL_GRAIN = 256;
+
+static bool hasTriangles(const aiMesh *mesh) {
+  return (mesh->mPrimitiveTypes & aiPrimitiveType_TRIANGLE) != 0;
+}
+
+static uint32_t countSubmeshes(const aiScene *scene, const aiNode *node) {
+  uint32_t count = 0;
+  for (unsigned int m = 0; m < node->mNumMeshes; ++m)
+    count += hasTriangles(scene->mMeshes[node->mMeshes[m]]) ? 1 : 0;
+  for (unsigned int i = 0; i < node->mNumChildren; ++i)
+    count += countSubmeshes(scene, node->mChildren[i]);
+  return count;
+}
+
+/**
+ * Simulate FIFO post-transform vertex cache over triangle list
+ * @return cache misses, i.e. vertex shader invocations
+ */
+static uint64_t simulateVertexCacheMisses(
+  const std::vector<uint32_t> &indices,
+  const size_t vertexCount,
+  const uint32_t cacheSize = VERTEX_CACHE_SIZE
+) {
+  ZoneScoped;
+  uint64_t misses = 0;
+  std::vector<uint64_t> enteredAt(vertexCount, UINT64_MAX); // Miss counter value when vertex entered cache
+  for (const auto index: indices) {
+    if (enteredAt[index] == UINT64_MAX || misses - enteredAt[index] >= cacheSize) {
+      enteredAt[index] = misses;
+      ++misses;
+    }
+  }
+  return misses;
+}
+
 static std::optional<std::string> getMaterialAlbedoTextureFile(
   aiMaterial *material
 ) {
@@ -40,47 +174,185 @@ static std::optional<std::string> getMaterialNormalTextureFile(
 
 Model::Model(
   const vk::Device device,
-  const vk::Queue graphicsQueue,
-  const vk::CommandPool commandPool,
-  vma::Allocator allocator,
-  TextureManager &textureManager,
-  LightManager &lightManager,
-  const std::filesystem::path &modelPath
-): m_device(device), m_graphicsQueue(graphicsQueue), m_commandPool(commandPool), m_allocator(allocator) {
+  TransferThread &transferThread,
+  ModelGeometryArena &geometryArena,
+  const std::filesystem::path &modelPath,
+  const ModelImportOptions importOptions
+): m_name(modelPath.filename().string()), m_path(modelPath), m_importOptions(importOptions), m_device(device),
+   m_transferThread(&transferThread), m_geometryArena(&geometryArena) {
+}
+
+void Model::importScene(JobSystem &jobSystem, TextureManager &textureManager) {
   ZoneScoped;
-  spdlog::info(std::format("Loading model from: {}", modelPath.string()));
-  Assimp::Importer importer;
+  try {
+    processScene(jobSystem, textureManager);
+  } catch (const std::exception &e) {
+    spdlog::error(std::format("Failed to load model {}: {}", m_path.string(), e.what()));
+    m_state = ModelLoadState::Failed;
+  }
+}
 
-  const aiScene *scene = importer.ReadFile(
-    modelPath.string(),
-    aiProcess_Triangulate
-    | aiProcess_JoinIdenticalVertices
-    | aiProcess_GenNormals
-    | aiProcess_CalcTangentSpace
-  );
+void Model::processScene(JobSystem &jobSystem, TextureManager &textureManager) {
+  ZoneScoped;
+  if (m_cancelled.load()) {
+    m_state = ModelLoadState::Cancelled;
+    return;
+  }
+  spdlog::info(std::format("Loading model from: {}", m_path.string()));
+  m_state = ModelLoadState::Importing;
+  Assimp::Importer importer;
+  importer.SetProgressHandler(new ModelImportProgressHandler(m_importProgress, m_cancelled));
+  importer.SetIOHandler(new MappedIOSystem());
+  importer.SetPropertyInteger(AI_CONFIG_PP_ICL_PTCACHE_SIZE, VERTEX_CACHE_SIZE);
+
+  unsigned int flags = aiProcess_Triangulate
+                       | aiProcess_SortByPType
+                       | aiProcess_JoinIdenticalVertices
+                       | aiProcess_GenNormals
+                       | aiProcess_CalcTangentSpace
+                       | aiProcess_GenBoundingBoxes; // Bounding spheres for GPU culling
+  if (m_importOptions.optimizeVertexCache)
+    flags |= aiProcess_ImproveCacheLocality;
+
+  const aiScene *scene = importer.ReadFile(m_path.string(), flags);
+  if (m_cancelled.load()) {
+    m_state = ModelLoadState::Cancelled;
+    return;
+  }
   if (!scene)
-    throw std::runtime_error("Import of model failed");
+    throw std::runtime_error(std::format("Import of model failed: {}", importer.GetErrorString()));
+
+  m_importProgress = 1.0f;
+  m_totalSubmeshes = countSubmeshes(scene, scene->mRootNode);
+  m_state = ModelLoadState::Processing;
 
-  const auto modelParent = modelPath.parent_path();
+  const auto modelParent = m_path.parent_path();
   processMaterials(textureManager, scene, modelParent);
-  processLight(lightManager, scene);
-  processNode(lightManager, scene->mRootNode, scene, glm::mat4(1.0f));
-  m_name = std::string(scene->mRootNode->mName.C_Str());
+  processLight(m_sceneLights, scene);
+  std::vector<MeshInstance> instances;
+  processNode(m_sceneLights, instances, scene->mRootNode, scene, glm::mat4(1.0f));
+  processMeshes(jobSystem, scene, instances);
+
+  m_state = m_cancelled.load() ? ModelLoadState::Cancelled : ModelLoadState::Done;
+  const auto stats = getGeometryStats();
+  spdlog::info(std::format(
+    "Model {} imported: {} submeshes, {} vertices, {} indices, {:.2f} MB, ACMR {:.3f}{}",
+    m_name, m_processedSubmeshes.load(), stats.vertices, stats.indices,
+    static_cast<double>(stats.vertexBytes + stats.indexBytes) / (1024.0 * 1024.0), stats.acmr,
+    m_importOptions.optimizeVertexCache ? " (vertex cache optimized)" : ""));
+}
+
+void Model::streamIn(LightManager &lightManager) {
+  ZoneScoped;
+  Submesh submesh;
+  while (m_streamQueue.try_dequeue(submesh)) {
+    m_incoming.push_back(std::move(submesh));
+  }
+
+  // Keep import order, so submesh indices in inspector are stable
+  const auto firstPending = std::ranges::find_if(
+    m_incoming, [](const Submesh &sub) { return !sub.mesh->isReady(); });
+  std::move(m_incoming.begin(), firstPending, std::back_inserter(m_submeshes));
+  m_incoming.erase(m_incoming.begin(), firstPending);
+
+  if (!m_lightsApplied && m_state.load() == ModelLoadState::Done) {
+    const auto lights = m_sceneLights.getLights();
+    const auto names = m_sceneLights.getNames();
+    for (size_t i = 0; i < lights.size(); ++i) {
+      lightManager.addLight(lights[i], names[i]);
+    }
+    m_lightsApplied = true;
+  }
+}
+
+void Model::cancelTextureLoads(TextureManager &textureManager) const {
+  ZoneScoped;
+  for (const auto &mat: m_materials) {
+    textureManager.cancelLoad(mat.albedoTexture);
+    textureManager.cancelLoad(mat.normalTexture);
+  }
+}
+
+void Model::updateTexturePriorities(const Camera &camera, TextureManager &textureManager) const {
+  ZoneScoped;
+  if (!textureManager.hasPendingLoads())
+    return;
+
+  // Angular size of bounding sphere, camera inside sphere gets the largest one
+  const auto modelMat = m_transform.toMat4();
+  const auto viewPos = camera.getViewPos();
+  std::unordered_map<uint32_t, float> materialPriority;
+  const auto visit = [&](const Submesh &sub) {
+    const auto world = modelMat * sub.transform;
+    const auto center = glm::vec3(world * glm::vec4(glm::vec3(sub.boundingSphere), 1.0f));
+    const auto scale = std::max({
+      glm::length(glm::vec3(world[0])), glm::length(glm::vec3(world[1])), glm::length(glm::vec3(world[2]))
+    });
+    const auto radius = sub.boundingSphere.w * scale;
+    const auto distance = glm::length(center - viewPos);
+    const auto priority = distance > radius ? radius / distance : 1.0f;
+    auto &current = materialPriority[sub.materialIndex];
+    current = std::max(current, priority);
+  };
+  std::ranges::for_each(m_submeshes, visit);
+  std::ranges::for_each(m_incoming, visit);
+
+  for (const auto &[materialIndex, priority]: materialPriority) {
+    const auto &mat = m_materials[materialIndex];
+    textureManager.setLoadPriority(mat.albedoTexture, priority);
+    textureManager.setLoadPriority(mat.normalTexture, priority);
+  }
+}
+
+ModelLoadProgress Model::getProgress() const {
+  return ModelLoadProgress{
+    .state = m_state.load(),
+    .importProgress = m_importProgress.load(),
+    .totalSubmeshes = m_totalSubmeshes.load(),
+    .processedSubmeshes = m_processedSubmeshes.load(),
+    .residentSubmeshes = static_cast<uint32_t>(m_submeshes.size())
+  };
+}
+
+ModelGeometryStats Model::getGeometryStats() const {
+  const auto vertices = m_vertexCount.load();
+  const auto indices = m_indexCount.load();
+  const auto triangles = indices / 3;
+  return ModelGeometryStats{
+    .vertices = vertices,
+    .indices = indices,
+    .vertexBytes = vertices * sizeof(Vertex),
+    .indexBytes = indices * sizeof(uint32_t),
+    .acmr = triangles > 0 ? static_cast<double>(m_cacheMisses.load()) / static_cast<double>(triangles) : 0.0
+  };
+}
+
+bool Model::isFullyResident() const {
+  const auto progress = getProgress();
+  if (!progress.isFinished())
+    return false;
+  if (progress.state != ModelLoadState::Done)
+    return true;
+  return m_lightsApplied && progress.residentSubmeshes == progress.processedSubmeshes;
 }
 
 void Model::processNode(
-  LightManager &lightManager,
+  LightManager &sceneLights,
+  std::vector<MeshInstance> &instances,
   const aiNode *node,
   const aiScene *scene,
   const glm::mat4 &parentTransform
 ) {
   ZoneScoped;
+  if (m_cancelled.load())
+    return;
+
   auto nodeTransform = aiMatrix4x4ToGlm(node->mTransformation);
   auto globalTransform = parentTransform * nodeTransform;
 
   std::string nodeName(node->mName.C_Str());
-  const auto lightNames = lightManager.getNames();
-  const auto lights = lightManager.getLights();
+  const auto lightNames = sceneLights.getNames();
+  const auto lights = sceneLights.getLights();
   for (uint32_t i = 0; i < lightNames.size(); ++i) {
     if (lightNames[i] == nodeName) {
       LightData light = lights[i];
@@ -90,24 +362,69 @@ void Model::processNode(
       light.position.y = position.y;
       light.position.z = position.z;
 
-      lightManager.editLight(i, light);
+      sceneLights.editLight(i, light);
       break;
     }
   }
 
   for (unsigned int m = 0; m < node->mNumMeshes; ++m) {
-    aiMesh *mesh = scene->mMeshes[node->mMeshes[m]];
-    auto gpuMesh = createMesh(mesh, scene, globalTransform);
-    m_submeshes.push_back({
-      .mesh = std::move(gpuMesh),
+    // Points and lines are split into own meshes by aiProcess_SortByPType
+    if (hasTriangles(scene->mMeshes[node->mMeshes[m]]))
+      instances.push_back({node->mMeshes[m], globalTransform});
+  }
+
+  for (unsigned int i = 0; i < node->mNumChildren; ++i)
+    processNode(sceneLights, instances, node->mChildren[i], scene, globalTransform);
+}
+
+void Model::processMeshes(JobSystem &jobSystem, const aiScene *scene, const std::vector<MeshInstance> &instances) {
+  ZoneScoped;
+  // Instanced aiMesh is built and uploaded once, its transform goes into per-draw data
+  std::vector<std::shared_ptr<ModelMesh> > meshes(scene->mNumMeshes);
+  std::vector<JobCounter> meshJobs(scene->mNumMeshes);
+  std::vector<bool> submitted(scene->mNumMeshes, false);
+  for (const auto &instance: instances) {
+    if (submitted[instance.meshIndex])
+      continue;
+    submitted[instance.meshIndex] = true;
+    jobSystem.submit([this, scene, &meshes, meshIndex = instance.meshIndex] {
+      if (!m_cancelled.load())
+        meshes[meshIndex] = createMesh(scene->mMeshes[meshIndex]);
+      m_transferThread->releaseStagingChunk();
+    }, JobPriority::Normal, &meshJobs[meshIndex]);
+  }
+
+  // Stream in node order, so submesh indices in inspector are stable
+  bool failed = false;
+  for (const auto &instance: instances) {
+    if (m_cancelled.load())
+      break;
+    jobSystem.wait(meshJobs[instance.meshIndex]);
+    const auto &gpuMesh = meshes[instance.meshIndex];
+    if (!gpuMesh) {
+      failed = !m_cancelled.load(); // Job failure is already logged
+      break;
+    }
+
+    const aiMesh *mesh = scene->mMeshes[instance.meshIndex];
+    const auto aabbMin = glm::vec3(mesh->mAABB.mMin.x, mesh->mAABB.mMin.y, mesh->mAABB.mMin.z);
+    const auto aabbMax = glm::vec3(mesh->mAABB.mMax.x, mesh->mAABB.mMax.y, mesh->mAABB.mMax.z);
+    m_streamQueue.enqueue({
+      .mesh = gpuMesh,
       .materialIndex = mesh->mMaterialIndex,
-      .transform = globalTransform,
+      .boundingSphere = glm::vec4((aabbMin + aabbMax) * 0.5f, glm::length(aabbMax - aabbMin) * 0.5f),
+      .transform = instance.transform,
+      .normalTransform = glm::transpose(glm::inverse(instance.transform)),
       .name = mesh->mName.C_Str()
     });
+    ++m_processedSubmeshes;
   }
 
-  for (unsigned int i = 0; i < node->mNumChildren; ++i)
-    processNode(lightManager, node->mChildren[i], scene, globalTransform);
+  // Jobs write into local meshes, every one must finish before return
+  for (auto &counter: meshJobs)
+    jobSystem.wait(counter);
+  if (failed)
+    throw std::runtime_error("Failed to build model meshes");
 }
 
 void Model::processMaterials(
@@ -122,13 +439,13 @@ void Model::processMaterials(
   for (unsigned int matIdx = 0; matIdx < scene->mNumMaterials; ++matIdx) {
     aiMaterial *material = scene->mMaterials[matIdx];
     Material mat;
-    if (const auto albedo = getMaterialAlbedoTextureFile(material))
-      mat.albedoTexIdx = textureManager.loadTextureFromFile(absoluteModelParent, *albedo);
-
     if (const auto normal = getMaterialNormalTextureFile(material))
-      mat.normalTexIdx = textureManager.loadTextureFromFile(absoluteModelParent, *normal);
+      mat.normalTexture = textureManager.loadTextureFromFile(absoluteModelParent, *normal, TextureKind::Normal);
 
-    if (aiColor3D aiDiffuseColor; material->Get(AI_MATKEY_COLOR_DIFFUSE, aiDiffuseColor) == AI_SUCCESS) {
+    // Albedo texture replaces diffuse color
+    if (const auto albedo = getMaterialAlbedoTextureFile(material)) {
+      mat.albedoTexture = textureManager.loadTextureFromFile(absoluteModelParent, *albedo);
+    } else if (aiColor3D aiDiffuseColor; material->Get(AI_MATKEY_COLOR_DIFFUSE, aiDiffuseColor) == AI_SUCCESS) {
       mat.diffuseColor = glm::vec4(aiDiffuseColor.r, aiDiffuseColor.g, aiDiffuseColor.b, 1.0f);
     }
 
@@ -186,76 +503,102 @@ void Model::processLight(LightManager &lightManager, const aiScene *scene) {
   }
 }
 
-std::unique_ptr<Mesh<Vertex, uint32_t> > Model::createMesh(
-  const aiMesh *mesh,
-  const aiScene *scene,
-  const glm::mat4 &transform
-) {
+std::shared_ptr<ModelMesh> Model::createMesh(const aiMesh *mesh) {
   ZoneScoped;
 
+  const auto texCords = mesh->HasTextureCoords(0) ? mesh->mTextureCoords[0] : nullptr;
+
+  // Keep vertices shared by aiProcess_JoinIdenticalVertices
   std::vector<Vertex> vertices;
-  std::vector<uint32_t> indices;
+  vertices.reserve(mesh->mNumVertices);
+  for (unsigned int v = 0; v < mesh->mNumVertices; ++v) {
+    const auto pos = mesh->mVertices[v];
+    const auto normal = mesh->HasNormals() ? mesh->mNormals[v] : aiVector3D(0, 0, 1.0);
+    const auto texCord = texCords ? texCords[v] : aiVector3D(0, 0, 0);
+
+    vertices.push_back(Vertex::make(
+      glm::vec3(pos.x, pos.y, pos.z),
+      glm::normalize(glm::vec3(normal.x, normal.y, normal.z)),
+      glm::vec2(texCord.x, 1.0f - texCord.y)));
+  }
 
-  auto texCords = mesh->HasTextureCoords(0) ? mesh->mTextureCoords[0] : nullptr;
+  std::vector<uint32_t> indices;
+  indices.reserve(static_cast<size_t>(mesh->mNumFaces) * 3);
   for (unsigned int f = 0; f < mesh->mNumFaces; ++f) {
-    aiFace &face = mesh->mFaces[f];
-    for (unsigned int i = 0; i < face.mNumIndices; ++i) {
-      auto vertexIndex = face.mIndices[i];
-      auto pos = mesh->mVertices[vertexIndex];
-      auto normal = mesh->HasNormals() ? mesh->mNormals[vertexIndex] : aiVector3D(0, 0, 1.0);
-      auto texCord = texCords ? texCords[vertexIndex] : aiVector3D(0, 0, 0);
-      auto mat = m_materials[mesh->mMaterialIndex];
-
-      glm::vec4 transformedPos = transform * glm::vec4(pos.x, pos.y, pos.z, 1.0f);
-      auto normalMat = glm::mat3(glm::transpose(glm::inverse(transform)));
-      auto N = glm::normalize(normalMat * glm::vec3(normal.x, normal.y, normal.z));
-
-      vertices.push_back({
-        .Position = transformedPos,
-        .Normal = N,
-        .UV = glm::vec2(texCord.x, 1.0f - texCord.y),
-        .Color = mat.diffuseColor,
-        .TextureIdx = mat.albedoTexIdx,
-        .NormalTextureIdx = mat.normalTexIdx
-      });
-
-      //indices.push_back(baseIndex + static_cast<uint32_t>(vertices.size() - baseIndex - 1));
-      indices.push_back(static_cast<uint32_t>(indices.size()));
-    }
+    const aiFace &face = mesh->mFaces[f];
+    if (face.mNumIndices != 3)
+      continue;
+    indices.insert(indices.end(), face.mIndices, face.mIndices + 3);
   }
 
-  return std::make_unique<Mesh<Vertex, uint32_t> >(
-    m_allocator, m_device, m_graphicsQueue, m_commandPool, vertices, indices
-  );
+  m_vertexCount += vertices.size();
+  m_indexCount += indices.size();
+  m_cacheMisses += simulateVertexCacheMisses(indices, vertices.size());
+
+  return std::make_shared<ModelMesh>(*m_geometryArena, *m_transferThread, vertices, indices);
 }
 
 void Model::createCommandBuffers(
   const vk::Device device,
   const vk::CommandPool commandPool,
-  const uint32_t imagesCount
+  const uint32_t frameCount
 ) {
   ZoneScoped;
   const auto info = vk::CommandBufferAllocateInfo(
-    commandPool, vk::CommandBufferLevel::eSecondary, imagesCount
+    commandPool, vk::CommandBufferLevel::eSecondary, frameCount
   );
   m_commandBuffers = device.allocateCommandBuffersUnique(info);
 }
 
-inline ModelPushConsts Model::calcPushConsts(const glm::mat4 &transform) const {
-  return ModelPushConsts{
-    .model = m_transform.toMat4() * transform
-  };
+void Model::fillDrawList(JobSystem &jobSystem, DrawList &drawList, const uint32_t frameIndex) {
+  ZoneScoped;
+  const auto modelMat = m_transform.toMat4();
+  const auto modelNormalMat = glm::transpose(glm::inverse(modelMat));
+  drawList.reset(frameIndex);
+  m_drawSubmeshes.clear();
+  for (uint32_t i = 0; i < m_submeshes.size(); ++i) {
+    if (m_submeshes[i].enabled)
+      m_drawSubmeshes.push_back(i);
+  }
+
+  const auto [firstDraw, drawCount] = drawList.reserve(frameIndex, static_cast<uint32_t>(m_drawSubmeshes.size()));
+  if (drawCount < m_drawSubmeshes.size()) {
+    if (!m_drawListOverflowReported)
+      spdlog::warn(std::format("Draw list is full, {} of {} submeshes drawn",
+                               drawCount, m_drawSubmeshes.size()));
+    m_drawListOverflowReported = true;
+  }
+
+  jobSystem.parallelFor(drawCount, DRAW_FILL_GRAIN, [&](const uint32_t begin, const uint32_t end) {
+    ZoneScopedN("Fill Draws");
+    for (uint32_t i = begin; i < end; ++i) {
+      const auto &sub = m_submeshes[m_drawSubmeshes[i]];
+      const auto &mat = m_materials[sub.materialIndex];
+      const auto &range = sub.mesh->getRange();
+      const auto data = DrawData{
+        .model = modelMat * sub.transform,
+        .normal = modelNormalMat * sub.normalTransform,
+        .color = mat.diffuseColor,
+        .boundingSphere = sub.boundingSphere,
+        .albedoTexIdx = TextureRegistry::slotOf(mat.albedoTexture),
+        .normalTexIdx = TextureRegistry::slotOf(mat.normalTexture)
+      };
+      drawList.write(frameIndex, firstDraw + i, data, range.indexCount, range.firstIndex, range.vertexOffset);
+    }
+  });
 }
 
 vk::CommandBuffer Model::cmdDraw(
   tracy::VkCtx &tracyCtx,
+  const GpuProfiler &profiler,
   const vk::Framebuffer framebuffer,
   const vk::RenderPass renderPass,
   const vk::Pipeline pipeline,
   const Swapchain &swapchain,
   const DescriptorSet &descriptorSet,
+  const DrawList &drawList,
   const uint32_t subpass,
-  const uint32_t imageIndex
+  const uint32_t frameIndex
 ) {
   ZoneScoped;
   const auto inheritanceInfo = vk::CommandBufferInheritanceInfo(renderPass, subpass, framebuffer);
@@ -264,28 +607,20 @@ vk::CommandBuffer Model::cmdDraw(
     &inheritanceInfo
   );
 
-  const auto cmdBuf = m_commandBuffers[imageIndex].get();
+  const auto cmdBuf = m_commandBuffers[frameIndex].get();
 
   cmdBuf.reset();
   cmdBuf.begin(beginInfo);
+  profiler.cmdBegin(cmdBuf, frameIndex, GpuPass::Geometry);
 
   swapchain.cmdSetViewport(cmdBuf);
   swapchain.cmdSetScissor(cmdBuf);
   cmdBuf.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
+  m_geometryArena->cmdBind(cmdBuf);
+  descriptorSet.bind(cmdBuf, frameIndex, {});
+  drawList.cmdDraw(cmdBuf, frameIndex);
 
-  for (const auto &sub: m_submeshes) {
-    if (!sub.enabled) {
-      continue;
-    }
-    const auto push_consts = calcPushConsts(sub.transform);
-    cmdBuf.bindVertexBuffers(0, sub.mesh->getVertexBuffer(), {0});
-    cmdBuf.bindIndexBuffer(sub.mesh->getIndicesBuffer(), 0, vk::IndexType::eUint32);
-    descriptorSet.bind(cmdBuf, imageIndex, {});
-    cmdBuf.pushConstants(descriptorSet.getPipelineLayout(), vk::ShaderStageFlagBits::eVertex,
-                         0, sizeof(push_consts), &push_consts);
-
-    cmdBuf.drawIndexed(sub.mesh->getIndicesCount(), 1, 0, 0, 0);
-  }
+  profiler.cmdEnd(cmdBuf, frameIndex, GpuPass::Geometry);
   cmdBuf.end();
 
   return cmdBuf;
@@ -296,6 +631,18 @@ void Model::drawUI() {
     ImGui::Text("Model: %s", m_name.c_str());
     ImGui::Separator();
 
+    if (ImGui::CollapsingHeader("Geometry")) {
+      const auto stats = getGeometryStats();
+      ImGui::Text("Vertices: %llu", static_cast<unsigned long long>(stats.vertices));
+      ImGui::Text("Triangles: %llu", static_cast<unsigned long long>(stats.indices / 3));
+      ImGui::Text("VRAM: %.2f MB (vertices %.2f MB, indices %.2f MB)",
+                  static_cast<double>(stats.vertexBytes + stats.indexBytes) / (1024.0 * 1024.0),
+                  static_cast<double>(stats.vertexBytes) / (1024.0 * 1024.0),
+                  static_cast<double>(stats.indexBytes) / (1024.0 * 1024.0));
+      ImGui::Text("ACMR (FIFO %u): %.3f", VERTEX_CACHE_SIZE, stats.acmr);
+      ImGui::Text("Vertex cache optimization: %s", m_importOptions.optimizeVertexCache ? "on" : "off");
+    }
+
     if (ImGui::CollapsingHeader("Transform", ImGuiTreeNodeFlags_DefaultOpen)) {
       ImGui::DragFloat3("Position", &m_transform.position.x, 0.05f);
 
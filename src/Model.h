@@ -2,9 +2,11 @@
 #define MODEL_H
 
 #define GLM_ENABLE_EXPERIMENTAL
+#include <atomic>
 #include <filesystem>
 #include <map>
 #include <string>
+#include <unordered_map>
 
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
@@ -12,61 +14,177 @@
 #include <glm/ext/matrix_float4x4.hpp>
 #include <glm/gtx/transform.hpp>
 
+#include "Camera.h"
 #include "DescriptorSet.h"
-#include "Mesh.h"
+#include "DrawList.h"
+#include "GeometryArena.h"
+#include "GpuProfiler.h"
+#include "JobSystem.h"
 #include "Swapchain.h"
 #include "Texture.h"
 #include "TextureManager.h"
 #include "Light.h"
 #include "Vertex.h"
 #include "Transform.h"
+#include "TransferThread.h"
 #include "utils.cpp"
 #include <tracy/TracyVulkan.hpp>
+#include "concurrentqueue/concurrentqueue.h"
 
-struct alignas(16) ModelPushConsts {
-  glm::mat4 model;
-};
+using ModelGeometryArena = GeometryArena<Vertex, uint32_t>;
+using ModelMesh = ArenaMesh<Vertex, uint32_t>;
 
 struct Submesh {
-  std::unique_ptr<Mesh<Vertex, uint32_t> > mesh;
+  std::shared_ptr<ModelMesh> mesh; // Shared by all nodes referencing same aiMesh
   bool enabled = true;
   uint32_t materialIndex;
+  glm::vec4 boundingSphere = glm::vec4(0.0f); // Mesh space, .xyz = center, .w = radius
   glm::mat4 transform = glm::mat4(1.0f);
+  glm::mat4 normalTransform = glm::mat4(1.0f); // Inverse transpose of transform
   std::string name;
 };
 
+struct MeshInstance {
+  uint32_t meshIndex; // Into aiScene::mMeshes
+  glm::mat4 transform = glm::mat4(1.0f); // Node global transform
+};
+
 struct Material {
-  uint32_t albedoTexIdx = 99;
-  uint32_t normalTexIdx = 99;
-  glm::vec4 diffuseColor = glm::vec4(1.0f);
+  TextureHandle albedoTexture = TEXTURE_NULL_HANDLE;
+  TextureHandle normalTexture = TEXTURE_FLAT_NORMAL_HANDLE;
+  glm::vec4 diffuseColor = glm::vec4(1.0f); // Multiplies albedo texture, white when material has one
+};
+
+
+struct ModelImportOptions {
+  bool optimizeVertexCache = true; // Tipsify triangle reorder (aiProcess_ImproveCacheLocality)
+};
+
+struct ModelGeometryStats {
+  uint64_t vertices = 0;
+  uint64_t indices = 0;
+  uint64_t vertexBytes = 0;
+  uint64_t indexBytes = 0;
+  double acmr = 0.0; // Average cache miss ratio: simulated vertex shader invocations per triangle
 };
 
+enum class ModelLoadState : uint32_t {
+  Queued,
+  Importing, // Assimp reading file
+  Processing, // Building and uploading submeshes
+  Done,
+  Failed,
+  Cancelled
+};
+
+struct ModelLoadProgress {
+  ModelLoadState state = ModelLoadState::Queued;
+  float importProgress = 0.0f; // 0..1, Assimp import stage
+  uint32_t totalSubmeshes = 0;
+  uint32_t processedSubmeshes = 0; // Built on worker, upload may be in flight
+  uint32_t residentSubmeshes = 0; // Uploaded and drawn
+
+  [[nodiscard]] bool isFinished() const {
+    return state == ModelLoadState::Done || state == ModelLoadState::Failed || state == ModelLoadState::Cancelled;
+  }
+
+  [[nodiscard]] float fraction() const {
+    if (state == ModelLoadState::Queued || state == ModelLoadState::Importing)
+      return importProgress * 0.5f;
+    if (totalSubmeshes == 0)
+      return isFinished() ? 1.0f : 0.5f;
+    return 0.5f + 0.5f * static_cast<float>(residentSubmeshes) / static_cast<float>(totalSubmeshes);
+  }
+};
 
+/**
+ * @brief Model streamed from file in background
+ *
+ * Loading lifecycle:
+ * 1. Construct empty model and call <code>Model::createCommandBuffers</code> on render thread
+ * 2. Job (see <code>ModelLoader</code>) calls <code>Model::importScene</code>, meshes are built
+ * by parallel jobs, every built submesh starts its upload and is queued for render thread in node order
+ * 3. Render thread calls <code>Model::streamIn</code> every frame to take submeshes
+ * whose data is GPU-resident, so model is drawn progressively while it loads
+ */
 class Model {
 public:
   Model() = default;
 
   Model(
     vk::Device device,
-    vk::Queue graphicsQueue,
-    vk::CommandPool commandPool,
-    vma::Allocator allocator,
-    TextureManager &textureManager,
-    LightManager &lightManager,
-    const std::filesystem::path &modelPath
+    TransferThread &transferThread,
+    ModelGeometryArena &geometryArena,
+    const std::filesystem::path &modelPath,
+    ModelImportOptions importOptions = {}
   );
 
-  void createCommandBuffers(vk::Device device, vk::CommandPool commandPool, uint32_t imagesCount);
+  Model(const Model &) = delete;
+
+  Model &operator=(const Model &) = delete;
+
+  /**
+   * Import scene, load materials and build submeshes
+   * @remark Runs on job worker thread, must be called once
+   */
+  void importScene(JobSystem &jobSystem, TextureManager &textureManager);
+
+  /**
+   * Take submeshes finished by worker and GPU, apply scene lights when import is done
+   * @remark Render thread only
+   */
+  void streamIn(LightManager &lightManager);
 
+  /**
+   * Request import stop, worker stops at next submesh or Assimp progress update
+   */
+  void cancel() { m_cancelled = true; }
+
+  /**
+   * Cancel loads of model textures which are not loaded yet
+   * @remark Render thread only, after import is finished or stopped (see <code>ModelLoader::waitIdle</code>)
+   */
+  void cancelTextureLoads(TextureManager &textureManager) const;
+
+  /**
+   * Prioritize queued textures by screen-space size of resident submeshes using them
+   * @remark Render thread only
+   */
+  void updateTexturePriorities(const Camera &camera, TextureManager &textureManager) const;
+
+  [[nodiscard]] ModelLoadProgress getProgress() const;
+
+  [[nodiscard]] bool isFullyResident() const;
+
+  /**
+   * @return geometry totals of submeshes built so far
+   */
+  [[nodiscard]] ModelGeometryStats getGeometryStats() const;
+
+  [[nodiscard]] const std::filesystem::path &getPath() const { return m_path; }
+
+  void createCommandBuffers(vk::Device device, vk::CommandPool commandPool, uint32_t frameCount);
+
+  /**
+   * Write enabled submeshes into draw list frame slot, must be done before culling pass.
+   * Draws are written by parallel high priority jobs.
+   */
+  void fillDrawList(JobSystem &jobSystem, DrawList &drawList, uint32_t frameIndex);
+
+  /**
+   * Record geometry pass drawing culled draw list
+   */
   vk::CommandBuffer cmdDraw(
     tracy::VkCtx &tracyCtx,
+    const GpuProfiler &profiler,
     vk::Framebuffer framebuffer,
     vk::RenderPass renderPass,
     vk::Pipeline pipeline,
     const Swapchain &swapchain,
     const DescriptorSet &descriptorSet,
+    const DrawList &drawList,
     uint32_t subpass,
-    uint32_t imageIndex
+    uint32_t frameIndex
   );
 
   void drawUI();
@@ -74,13 +192,21 @@ public:
   ~Model() = default;
 
 private:
+  void processScene(JobSystem &jobSystem, TextureManager &textureManager);
+
   void processNode(
-    LightManager &lightManager,
+    LightManager &sceneLights,
+    std::vector<MeshInstance> &instances,
     const aiNode *node,
     const aiScene *scene,
     const glm::mat4 &parentTransform
   );
 
+  /**
+   * Build every referenced mesh once in parallel jobs and stream instances in node order
+   */
+  void processMeshes(JobSystem &jobSystem, const aiScene *scene, const std::vector<MeshInstance> &instances);
+
   void processMaterials(
     TextureManager &textureManager,
     const aiScene *scene,
@@ -92,23 +218,34 @@ private:
     const aiScene *scene
   );
 
-  std::unique_ptr<Mesh<Vertex, uint32_t> > createMesh(
-    const aiMesh *mesh,
-    const aiScene *scene,
-    const glm::mat4 &transform
-  );
-
-  [[nodiscard]] ModelPushConsts calcPushConsts(const glm::mat4 &transform) const;
+  std::shared_ptr<ModelMesh> createMesh(const aiMesh *mesh);
 
   std::string m_name;
+  std::filesystem::path m_path;
+  ModelImportOptions m_importOptions;
   Transform m_transform;
-  std::vector<Submesh> m_submeshes;
+  std::vector<Submesh> m_submeshes; // Render thread only, GPU-resident
+  std::vector<Submesh> m_incoming; // Render thread only, upload in flight
+  moodycamel::ConcurrentQueue<Submesh> m_streamQueue; // Worker -> render thread
+  LightManager m_sceneLights; // Filled by worker, applied once import is done
+  bool m_lightsApplied = false;
+  bool m_drawListOverflowReported = false;
+  std::vector<uint32_t> m_drawSubmeshes; // Render thread only, enabled submesh indices of current frame
+
+  std::atomic<ModelLoadState> m_state = ModelLoadState::Queued;
+  std::atomic<float> m_importProgress = 0.0f;
+  std::atomic_uint32_t m_totalSubmeshes = 0;
+  std::atomic_uint32_t m_processedSubmeshes = 0;
+  std::atomic_bool m_cancelled = false;
+  std::atomic_uint64_t m_vertexCount = 0;
+  std::atomic_uint64_t m_indexCount = 0;
+  std::atomic_uint64_t m_cacheMisses = 0;
+
   std::vector<Material> m_materials;
   std::vector<vk::UniqueCommandBuffer> m_commandBuffers;
 
   vk::Device m_device = nullptr;
-  vk::Queue m_graphicsQueue = nullptr;
-  vk::CommandPool m_commandPool = nullptr;
-  vma::Allocator m_allocator = nullptr;
+  TransferThread *m_transferThread = nullptr;
+  ModelGeometryArena *m_geometryArena = nullptr;
 };
 #endif //MODEL_H
@@ -0,0 +1,76 @@
+#ifndef MODELLOADER_H
+#define MODELLOADER_H
+
+#include <memory>
+
+#include "Async.h"
+#include "JobSystem.h"
+#include "Model.h"
+#include "TextureManager.h"
+
+struct ModelLoadJob {
+  std::shared_ptr<Model> model;
+};
+
+/**
+ * @brief Background model import on <code>JobSystem</code>
+ *
+ * Loading lifecycle:
+ * 1. Create empty <code>Model</code> on render thread and pass it into
+ * <code>ModelLoader::pushJob</code>
+ * 2. Low priority job imports scene, requests textures from <code>TextureManager</code>
+ * and builds submeshes by parallel jobs, their uploads goes through <code>TransferThread</code>
+ * 3. Render thread calls <code>Model::streamIn</code> each frame and tracks
+ * <code>Model::getProgress</code> until load is finished
+ *
+ * Before releasing model which is still loading call <code>Model::cancel</code>
+ * and <code>ModelLoader::waitIdle</code>, so model is never destroyed on worker.
+ *
+ * Coroutines may import model directly by awaiting <code>ModelLoader::importModel</code>.
+ */
+class ModelLoader {
+public:
+  ModelLoader(JobSystem &jobSystem, TextureManager &textureManager)
+    : m_jobSystem(jobSystem), m_textureManager(textureManager) {
+  }
+
+  ~ModelLoader() {
+    waitIdle();
+  }
+
+  ModelLoader(const ModelLoader &) = delete;
+
+  ModelLoader &operator=(const ModelLoader &) = delete;
+
+  void pushJob(const ModelLoadJob &job) {
+    ZoneScoped;
+    // Task releases model on worker before it counts as finished
+    spawn(m_jobSystem, importModel(job.model), JobPriority::Low, &m_jobs);
+  }
+
+  /**
+   * Import model as low priority job, e.g. <code>const auto state = co_await modelLoader.importModel(model)</code>
+   * @return final load state, see <code>Model::getProgress</code>
+   */
+  Task<ModelLoadState> importModel(const std::shared_ptr<Model> model) {
+    co_await schedule(m_jobSystem, JobPriority::Low); {
+      ZoneScopedN("Model Import");
+      model->importScene(m_jobSystem, m_textureManager);
+    }
+    co_return model->getProgress().state;
+  }
+
+  /**
+   * Block calling thread until every pushed job is finished and released by worker
+   */
+  void waitIdle() {
+    m_jobSystem.wait(m_jobs);
+  }
+
+private:
+  JobSystem &m_jobSystem;
+  TextureManager &m_textureManager;
+  JobCounter m_jobs;
+};
+
+#endif //MODELLOADER_H
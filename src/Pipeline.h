@@ -31,6 +31,16 @@ public:
     return *this;
   }
 
+  /**
+   * Single interleaved vertex buffer with layout described by VertexType (see <code>BasicVertex</code>)
+   */
+  template<typename VertexType>
+  PipelineBuilder &withVertexLayout() {
+    m_bindingDescriptions = {VertexType::GetBindingDescription()};
+    m_attributeDescriptions = VertexType::GetAttributeDescriptions();
+    return *this;
+  }
+
   PipelineBuilder &withColorBlendAttachments(
     const std::vector<vk::PipelineColorBlendAttachmentState> &colorBlendAttachments) {
     m_colorBlendAttachments = colorBlendAttachments;
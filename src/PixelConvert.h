@@ -0,0 +1,428 @@
+#ifndef PIXELCONVERT_H
+#define PIXELCONVERT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define PIXEL_CONVERT_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define PIXEL_CONVERT_TARGET(isa)
+#else
+#define PIXEL_CONVERT_TARGET(isa) __attribute__((target(isa)))
+#endif
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define PIXEL_CONVERT_NEON
+#include <arm_neon.h>
+#endif
+
+/**
+ * Instruction set of pixel conversion kernels, x86 one is selected at runtime
+ */
+enum class PixelIsa : uint32_t {
+  Scalar,
+  Sse4, // SSSE3 byte shuffles and SSE4.1
+  Avx2, // AVX2 and F16C (every AVX2 CPU has F16C)
+  Neon
+};
+
+static const char *pixelIsaName(const PixelIsa isa) {
+  switch (isa) {
+    case PixelIsa::Sse4: return "sse4";
+    case PixelIsa::Avx2: return "avx2";
+    case PixelIsa::Neon: return "neon";
+    default: return "scalar";
+  }
+}
+
+static PixelIsa detectPixelIsa() {
+#if defined(PIXEL_CONVERT_X86)
+#if defined(_MSC_VER) && !defined(__clang__)
+  int info[4];
+  __cpuid(info, 0);
+  const auto maxLeaf = info[0];
+  __cpuid(info, 1);
+  const bool sse41 = info[2] & (1 << 19);
+  const bool avxUsable = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+  bool avx2 = false;
+  if (maxLeaf >= 7 && avxUsable) {
+    __cpuidex(info, 7, 0);
+    avx2 = info[1] & (1 << 5);
+  }
+#else
+  __builtin_cpu_init();
+  const bool sse41 = __builtin_cpu_supports("sse4.1");
+  const bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+  return avx2 ? PixelIsa::Avx2 : sse41 ? PixelIsa::Sse4 : PixelIsa::Scalar;
+#elif defined(PIXEL_CONVERT_NEON)
+  return PixelIsa::Neon;
+#else
+  return PixelIsa::Scalar;
+#endif
+}
+
+/**
+ * @return best instruction set of this CPU, detected once
+ */
+static PixelIsa pixelIsa() {
+  static const auto isa = detectPixelIsa();
+  return isa;
+}
+
+/**
+ * Scalar float to half conversion, round to nearest even, NaN stays NaN
+ */
+static uint16_t floatToHalf(const float value) {
+  uint32_t x;
+  memcpy(&x, &value, sizeof(x));
+  const auto sign = static_cast<uint16_t>((x >> 16) & 0x8000);
+  x &= 0x7fffffff;
+  if (x >= 0x7f800000) // Inf or NaN
+    return sign | 0x7c00 | (x > 0x7f800000 ? 0x200 : 0);
+  if (x >= 0x477ff000) // Rounds above max half
+    return sign | 0x7c00;
+  if (x < 0x38800000) { // Half subnormal or zero
+    if (x < 0x33000000)
+      return sign;
+    const auto shift = 126 - (x >> 23);
+    const auto mantissa = (x & 0x7fffff) | 0x800000;
+    auto half = mantissa >> shift;
+    const auto rest = mantissa & ((1u << shift) - 1);
+    const auto tie = 1u << (shift - 1);
+    if (rest > tie || (rest == tie && (half & 1)))
+      ++half;
+    return static_cast<uint16_t>(sign | half);
+  }
+  auto half = (x - 0x38000000) >> 13; // Rebias exponent 127 -> 15
+  const auto rest = x & 0x1fff;
+  if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+    ++half; // Carry into exponent is correct rounding
+  return static_cast<uint16_t>(sign | half);
+}
+
+// Scalar kernels, also handle tails of vector ones
+
+static void rgb8ToRgba8Scalar(const uint8_t *src, uint8_t *dst, const size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    dst[i * 4 + 0] = src[i * 3 + 0];
+    dst[i * 4 + 1] = src[i * 3 + 1];
+    dst[i * 4 + 2] = src[i * 3 + 2];
+    dst[i * 4 + 3] = 0xff;
+  }
+}
+
+static void grey8ToRgba8Scalar(const uint8_t *src, uint8_t *dst, const size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    dst[i * 4 + 0] = dst[i * 4 + 1] = dst[i * 4 + 2] = src[i];
+    dst[i * 4 + 3] = 0xff;
+  }
+}
+
+static void greyAlpha8ToRgba8Scalar(const uint8_t *src, uint8_t *dst, const size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    dst[i * 4 + 0] = dst[i * 4 + 1] = dst[i * 4 + 2] = src[i * 2];
+    dst[i * 4 + 3] = src[i * 2 + 1];
+  }
+}
+
+static void rgb16ToRgba16Scalar(const uint16_t *src, uint16_t *dst, const size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    dst[i * 4 + 0] = src[i * 3 + 0];
+    dst[i * 4 + 1] = src[i * 3 + 1];
+    dst[i * 4 + 2] = src[i * 3 + 2];
+    dst[i * 4 + 3] = 0xffff;
+  }
+}
+
+static void floatToHalfScalar(const float *src, uint16_t *dst, const size_t count) {
+  for (size_t i = 0; i < count; ++i)
+    dst[i] = floatToHalf(src[i]);
+}
+
+#if defined(PIXEL_CONVERT_X86)
+// Vector loads may read up to 4 bytes past last converted pixel, loops stop early enough
+// to stay inside source and let scalar kernels finish the tail
+
+PIXEL_CONVERT_TARGET("sse4.1")
+static size_t rgb8ToRgba8Sse4(const uint8_t *src, uint8_t *dst, const size_t count) {
+  const auto mask = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+  const auto alpha = _mm_set1_epi32(static_cast<int>(0xff000000));
+  size_t i = 0;
+  for (; i + 6 <= count; i += 4) {
+    const auto pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 3));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 4), _mm_or_si128(_mm_shuffle_epi8(pixels, mask), alpha));
+  }
+  return i;
+}
+
+PIXEL_CONVERT_TARGET("avx2")
+static size_t rgb8ToRgba8Avx2(const uint8_t *src, uint8_t *dst, const size_t count) {
+  const auto mask = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                                     0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+  const auto alpha = _mm256_set1_epi32(static_cast<int>(0xff000000));
+  size_t i = 0;
+  for (; i + 10 <= count; i += 8) {
+    const auto lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 3));
+    const auto hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 3 + 12));
+    const auto pixels = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i * 4),
+                        _mm256_or_si256(_mm256_shuffle_epi8(pixels, mask), alpha));
+  }
+  return i;
+}
+
+PIXEL_CONVERT_TARGET("sse4.1")
+static size_t grey8ToRgba8Sse4(const uint8_t *src, uint8_t *dst, const size_t count) {
+  const auto alpha = _mm_set1_epi32(static_cast<int>(0xff000000));
+  const auto spread = _mm_set1_epi32(0x00010101);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    int32_t grey;
+    memcpy(&grey, src + i, sizeof(grey));
+    const auto wide = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(grey));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 4), _mm_or_si128(_mm_mullo_epi32(wide, spread), alpha));
+  }
+  return i;
+}
+
+PIXEL_CONVERT_TARGET("avx2")
+static size_t grey8ToRgba8Avx2(const uint8_t *src, uint8_t *dst, const size_t count) {
+  const auto alpha = _mm256_set1_epi32(static_cast<int>(0xff000000));
+  const auto spread = _mm256_set1_epi32(0x00010101);
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const auto wide = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + i)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i * 4),
+                        _mm256_or_si256(_mm256_mullo_epi32(wide, spread), alpha));
+  }
+  return i;
+}
+
+PIXEL_CONVERT_TARGET("sse4.1")
+static size_t greyAlpha8ToRgba8Sse4(const uint8_t *src, uint8_t *dst, const size_t count) {
+  const auto maskLo = _mm_setr_epi8(0, 0, 0, 1, 2, 2, 2, 3, 4, 4, 4, 5, 6, 6, 6, 7);
+  const auto maskHi = _mm_setr_epi8(8, 8, 8, 9, 10, 10, 10, 11, 12, 12, 12, 13, 14, 14, 14, 15);
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const auto pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 2));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 4), _mm_shuffle_epi8(pixels, maskLo));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 4 + 16), _mm_shuffle_epi8(pixels, maskHi));
+  }
+  return i;
+}
+
+PIXEL_CONVERT_TARGET("avx2")
+static size_t greyAlpha8ToRgba8Avx2(const uint8_t *src, uint8_t *dst, const size_t count) {
+  const auto mask = _mm256_setr_epi8(0, 0, 0, 1, 2, 2, 2, 3, 4, 4, 4, 5, 6, 6, 6, 7,
+                                     8, 8, 8, 9, 10, 10, 10, 11, 12, 12, 12, 13, 14, 14, 14, 15);
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const auto pixels = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 2)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i * 4), _mm256_shuffle_epi8(pixels, mask));
+  }
+  return i;
+}
+
+PIXEL_CONVERT_TARGET("sse4.1")
+static size_t rgb16ToRgba16Sse4(const uint16_t *src, uint16_t *dst, const size_t count) {
+  const auto mask = _mm_setr_epi8(0, 1, 2, 3, 4, 5, -1, -1, 6, 7, 8, 9, 10, 11, -1, -1);
+  const auto alpha = _mm_set1_epi64x(static_cast<int64_t>(0xffff000000000000ull));
+  size_t i = 0;
+  for (; i + 3 <= count; i += 2) {
+    const auto pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 3));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 4), _mm_or_si128(_mm_shuffle_epi8(pixels, mask), alpha));
+  }
+  return i;
+}
+
+PIXEL_CONVERT_TARGET("avx2")
+static size_t rgb16ToRgba16Avx2(const uint16_t *src, uint16_t *dst, const size_t count) {
+  const auto mask = _mm256_setr_epi8(0, 1, 2, 3, 4, 5, -1, -1, 6, 7, 8, 9, 10, 11, -1, -1,
+                                     0, 1, 2, 3, 4, 5, -1, -1, 6, 7, 8, 9, 10, 11, -1, -1);
+  const auto alpha = _mm256_set1_epi64x(static_cast<int64_t>(0xffff000000000000ull));
+  size_t i = 0;
+  for (; i + 5 <= count; i += 4) {
+    const auto lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 3));
+    const auto hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 3 + 6));
+    const auto pixels = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i * 4),
+                        _mm256_or_si256(_mm256_shuffle_epi8(pixels, mask), alpha));
+  }
+  return i;
+}
+
+PIXEL_CONVERT_TARGET("avx2,f16c")
+static size_t floatToHalfAvx2(const float *src, uint16_t *dst, const size_t count) {
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const auto halves = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), halves);
+  }
+  return i;
+}
+#endif
+
+#if defined(PIXEL_CONVERT_NEON)
+static size_t rgb8ToRgba8Neon(const uint8_t *src, uint8_t *dst, const size_t count) {
+  size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    const auto rgb = vld3q_u8(src + i * 3);
+    vst4q_u8(dst + i * 4, uint8x16x4_t{{rgb.val[0], rgb.val[1], rgb.val[2], vdupq_n_u8(0xff)}});
+  }
+  return i;
+}
+
+static size_t grey8ToRgba8Neon(const uint8_t *src, uint8_t *dst, const size_t count) {
+  size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    const auto grey = vld1q_u8(src + i);
+    vst4q_u8(dst + i * 4, uint8x16x4_t{{grey, grey, grey, vdupq_n_u8(0xff)}});
+  }
+  return i;
+}
+
+static size_t greyAlpha8ToRgba8Neon(const uint8_t *src, uint8_t *dst, const size_t count) {
+  size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    const auto ga = vld2q_u8(src + i * 2);
+    vst4q_u8(dst + i * 4, uint8x16x4_t{{ga.val[0], ga.val[0], ga.val[0], ga.val[1]}});
+  }
+  return i;
+}
+
+static size_t rgb16ToRgba16Neon(const uint16_t *src, uint16_t *dst, const size_t count) {
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const auto rgb = vld3q_u16(src + i * 3);
+    vst4q_u16(dst + i * 4, uint16x8x4_t{{rgb.val[0], rgb.val[1], rgb.val[2], vdupq_n_u16(0xffff)}});
+  }
+  return i;
+}
+
+static size_t floatToHalfNeon(const float *src, uint16_t *dst, const size_t count) {
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4)
+    vst1_u16(dst + i, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(src + i))));
+  return i;
+}
+#endif
+
+/**
+ * Expand tightly packed RGB8 pixels into RGBA8 with opaque alpha
+ * @param count pixel count
+ */
+static void convertRgb8ToRgba8(const uint8_t *src, uint8_t *dst, const size_t count, const PixelIsa isa = pixelIsa()) {
+  size_t done = 0;
+#if defined(PIXEL_CONVERT_X86)
+  if (isa == PixelIsa::Avx2) done = rgb8ToRgba8Avx2(src, dst, count);
+  else if (isa == PixelIsa::Sse4) done = rgb8ToRgba8Sse4(src, dst, count);
+#elif defined(PIXEL_CONVERT_NEON)
+  if (isa == PixelIsa::Neon) done = rgb8ToRgba8Neon(src, dst, count);
+#endif
+  rgb8ToRgba8Scalar(src + done * 3, dst + done * 4, count - done);
+}
+
+/**
+ * Replicate grey into RGB with opaque alpha
+ */
+static void convertGrey8ToRgba8(const uint8_t *src, uint8_t *dst, const size_t count, const PixelIsa isa = pixelIsa()) {
+  size_t done = 0;
+#if defined(PIXEL_CONVERT_X86)
+  if (isa == PixelIsa::Avx2) done = grey8ToRgba8Avx2(src, dst, count);
+  else if (isa == PixelIsa::Sse4) done = grey8ToRgba8Sse4(src, dst, count);
+#elif defined(PIXEL_CONVERT_NEON)
+  if (isa == PixelIsa::Neon) done = grey8ToRgba8Neon(src, dst, count);
+#endif
+  grey8ToRgba8Scalar(src + done, dst + done * 4, count - done);
+}
+
+/**
+ * Replicate grey into RGB, keep alpha
+ */
+static void convertGreyAlpha8ToRgba8(const uint8_t *src, uint8_t *dst, const size_t count,
+                                     const PixelIsa isa = pixelIsa()) {
+  size_t done = 0;
+#if defined(PIXEL_CONVERT_X86)
+  if (isa == PixelIsa::Avx2) done = greyAlpha8ToRgba8Avx2(src, dst, count);
+  else if (isa == PixelIsa::Sse4) done = greyAlpha8ToRgba8Sse4(src, dst, count);
+#elif defined(PIXEL_CONVERT_NEON)
+  if (isa == PixelIsa::Neon) done = greyAlpha8ToRgba8Neon(src, dst, count);
+#endif
+  greyAlpha8ToRgba8Scalar(src + done * 2, dst + done * 4, count - done);
+}
+
+/**
+ * Expand tightly packed RGB16 pixels into RGBA16 with opaque alpha
+ */
+static void convertRgb16ToRgba16(const uint16_t *src, uint16_t *dst, const size_t count,
+                                 const PixelIsa isa = pixelIsa()) {
+  size_t done = 0;
+#if defined(PIXEL_CONVERT_X86)
+  if (isa == PixelIsa::Avx2) done = rgb16ToRgba16Avx2(src, dst, count);
+  else if (isa == PixelIsa::Sse4) done = rgb16ToRgba16Sse4(src, dst, count);
+#elif defined(PIXEL_CONVERT_NEON)
+  if (isa == PixelIsa::Neon) done = rgb16ToRgba16Neon(src, dst, count);
+#endif
+  rgb16ToRgba16Scalar(src + done * 3, dst + done * 4, count - done);
+}
+
+/**
+ * Convert floats into half floats, round to nearest even
+ * @param count float count (not pixels)
+ * @remark SSE4 level has no F16C, it uses scalar kernel
+ */
+static void convertFloatToHalf(const float *src, uint16_t *dst, const size_t count, const PixelIsa isa = pixelIsa()) {
+  size_t done = 0;
+#if defined(PIXEL_CONVERT_X86)
+  if (isa == PixelIsa::Avx2) done = floatToHalfAvx2(src, dst, count);
+#elif defined(PIXEL_CONVERT_NEON)
+  if (isa == PixelIsa::Neon) done = floatToHalfNeon(src, dst, count);
+#endif
+  floatToHalfScalar(src + done, dst + done, count - done);
+}
+
+/**
+ * Convert 8-bit image rows with 1..4 channels into RGBA8
+ */
+static void convertToRgba8(const uint8_t *src, uint8_t *dst, const size_t count, const int channels,
+                           const PixelIsa isa = pixelIsa()) {
+  switch (channels) {
+    case 1: convertGrey8ToRgba8(src, dst, count, isa);
+      break;
+    case 2: convertGreyAlpha8ToRgba8(src, dst, count, isa);
+      break;
+    case 3: convertRgb8ToRgba8(src, dst, count, isa);
+      break;
+    default: memcpy(dst, src, count * 4);
+  }
+}
+
+/**
+ * Convert 16-bit image rows with 1..4 channels into RGBA16, grey ones are rare and use scalar path
+ */
+static void convertToRgba16(const uint16_t *src, uint16_t *dst, const size_t count, const int channels,
+                            const PixelIsa isa = pixelIsa()) {
+  switch (channels) {
+    case 1:
+      for (size_t i = 0; i < count; ++i) {
+        dst[i * 4 + 0] = dst[i * 4 + 1] = dst[i * 4 + 2] = src[i];
+        dst[i * 4 + 3] = 0xffff;
+      }
+      break;
+    case 2:
+      for (size_t i = 0; i < count; ++i) {
+        dst[i * 4 + 0] = dst[i * 4 + 1] = dst[i * 4 + 2] = src[i * 2];
+        dst[i * 4 + 3] = src[i * 2 + 1];
+      }
+      break;
+    case 3: convertRgb16ToRgba16(src, dst, count, isa);
+      break;
+    default: memcpy(dst, src, count * 8);
+  }
+}
+
+#endif //PIXELCONVERT_H
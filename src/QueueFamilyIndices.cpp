@@ -8,6 +8,7 @@ struct QueueFamilyIndices {
   uint32_t graphics;
   uint32_t present;
   uint32_t transfer;
+  uint32_t transferQueueIndex; // 1 when transfer family is shared with graphics or present queue
 
   QueueFamilyIndices() = default;
 
@@ -18,21 +19,34 @@ struct QueueFamilyIndices {
     auto props = physical_device.getQueueFamilyProperties();
 
     graphics = present = transfer = UINT32_MAX;
+    bool transferOnly = false;
 
     for (uint32_t i = 0; i < props.size(); ++i) {
       if (props[i].queueFlags & vk::QueueFlagBits::eGraphics) {
         if (graphics == UINT32_MAX) graphics = i;
       }
-      if (physical_device.getSurfaceSupportKHR(i, surface)) {
+      if (surface && physical_device.getSurfaceSupportKHR(i, surface)) {
         if (present == UINT32_MAX) present = i;
       }
-      if (props[i].queueFlags & vk::QueueFlagBits::eTransfer) {
-        if (transfer == UINT32_MAX) transfer = i;
+      // Prefer family without graphics, transfer-only one is usually a DMA engine
+      const auto flags = props[i].queueFlags;
+      if ((flags & vk::QueueFlagBits::eTransfer) && !(flags & vk::QueueFlagBits::eGraphics)) {
+        const bool dma = !(flags & vk::QueueFlagBits::eCompute);
+        if (transfer == UINT32_MAX || (dma && !transferOnly)) {
+          transfer = i;
+          transferOnly = dma;
+        }
       }
     }
 
+    // Headless mode: nothing to present, keep single graphics queue family
+    if (!surface) {
+      present = graphics;
+    }
+
     if (transfer == UINT32_MAX) {
       transfer = graphics;
     }
+    transferQueueIndex = transfer == graphics || transfer == present ? 1 : 0;
   }
 };
@@ -3,11 +3,21 @@
 #ifndef STAGINGBUFF_H
 #define STAGINGBUFF_H
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
 #include <vulkan/vulkan.hpp>
 #include "vulkan-memory-allocator-hpp/vk_mem_alloc.hpp"
 
 #include "BufferUtils.cpp"
 
+#define STAGING_RING_CHUNK_SIZE (4 * 1024 * 1024)
+
+enum class StagingAllocMode : uint32_t {
+  VirtualBlock, // VMA virtual block guarded by mutex
+  Ring // Lock-free ring of chunks reserved per thread
+};
+
 /**
  * @brief StagingBuffer providing a CPU-accessible buffer for
  * uploading GPU resources (vertex/index buffers, textures, etc.)
@@ -26,6 +36,15 @@
  * as "in-flight" and associate it with the next timeline value
  * 5. After GPU work completes, <code>StagingBuffer::pollReclaimed</code>
  * free the allocation for reuse
+ *
+ * In <code>StagingAllocMode::Ring</code> buffer is split into chunks of
+ * <code>STAGING_RING_CHUNK_SIZE</code>. Every allocating thread reserves a chunk and
+ * bump-allocates from it without locks, full chunk is sealed and becomes free again once
+ * timeline reaches the largest value of its allocations. Chunks are reserved in ring order,
+ * allocation larger than chunk takes several adjacent chunks.
+ * Ranges are reused only when whole chunk is done. Thread gives its chunk up by
+ * <code>StagingBuffer::releaseThreadChunk</code> at the end of its allocation burst, so chunks
+ * are never held by idle threads while others wait.
  */
 class StagingBuffer {
 public:
@@ -35,13 +54,15 @@ public:
     vma::VirtualAllocation handle = nullptr;
     void *mapped = nullptr;
     uint64_t timelineValue = 0;
+    uint32_t chunk = UINT32_MAX; // Ring mode only
   };
 
   StagingBuffer(
     const vk::Device device,
     const vma::Allocator allocator,
-    const vk::DeviceSize bufferSize
-  ): m_device(device), m_allocator(allocator), m_bufferSize(bufferSize) {
+    const vk::DeviceSize bufferSize,
+    const StagingAllocMode mode = StagingAllocMode::VirtualBlock
+  ): m_device(device), m_allocator(allocator), m_bufferSize(bufferSize), m_mode(mode) {
     ZoneScoped;
     std::tie(m_buffer, m_bufferAlloc) = createBufferUnique(
       allocator,
@@ -54,7 +75,13 @@ public:
     m_mapped = allocator.mapMemory(m_bufferAlloc.get());
     if (!m_mapped) throw std::runtime_error("Failed to map staging memory");
 
-    m_virtualBlock = vma::createVirtualBlockUnique(vma::VirtualBlockCreateInfo(bufferSize));
+    if (mode == StagingAllocMode::Ring) {
+      m_chunkSize = std::min<vk::DeviceSize>(STAGING_RING_CHUNK_SIZE, bufferSize);
+      m_chunkCount = static_cast<uint32_t>(bufferSize / m_chunkSize);
+      m_chunks = std::make_unique<RingChunk[]>(m_chunkCount);
+    } else {
+      m_virtualBlock = vma::createVirtualBlockUnique(vma::VirtualBlockCreateInfo(bufferSize));
+    }
 
     const auto semaTypeInfo = vk::SemaphoreTypeCreateInfo(vk::SemaphoreType::eTimeline);
     const auto semaInfo = vk::SemaphoreCreateInfo({}, &semaTypeInfo);
@@ -93,6 +120,8 @@ public:
     ZoneScoped;
     if (size > m_bufferSize)
       throw std::runtime_error("Try to allocate size > staging buffer size");
+    if (m_mode == StagingAllocMode::Ring)
+      return tryAllocateRing(size, std::max<vk::DeviceSize>(alignment, 1));
 
     const auto vci = vma::VirtualAllocationCreateInfo(size, alignment);
     vma::VirtualAllocation virtualAlloc = nullptr;
@@ -130,6 +159,20 @@ public:
    */
   Allocation allocateBlocking(const vk::DeviceSize size, const vk::DeviceSize alignment = 256) {
     ZoneScoped;
+    if (m_mode == StagingAllocMode::Ring) {
+      while (true) {
+        if (const auto alloc = tryAllocate(size, alignment)) {
+          return *alloc;
+        }
+
+        // Any finished batch may release a sealed chunk, wait for next timeline value
+        const auto completed = m_device.getSemaphoreCounterValue(m_timeline.get());
+        const auto waitInfo = vk::SemaphoreWaitInfo({}, m_timeline.get(), completed + 1);
+        auto _ = m_device.waitSemaphores(waitInfo, 1'000'000); // 1 ms, nothing may be in flight yet
+        pollReclaimed();
+      }
+    }
+
     while (true) {
       if (const auto alloc = tryAllocate(size, alignment)) {
         return *alloc;
@@ -155,6 +198,20 @@ public:
     }
   }
 
+  /**
+   * Seal chunk reserved by calling thread (ring mode, no-op otherwise), it becomes free once its transfers are done.
+   * Call it when thread finished its allocation burst (e.g. at the end of load job).
+   */
+  void releaseThreadChunk() {
+    if (m_mode != StagingAllocMode::Ring)
+      return;
+    auto &local = threadChunk();
+    if (local.bufferId != m_id || local.chunk == UINT32_MAX)
+      return;
+    sealChunk(local.chunk);
+    local.chunk = UINT32_MAX;
+  }
+
   /**
    * Starting tracking allocation
    * @remark Must be called after Queue submit with allocation semaphore value
@@ -162,6 +219,10 @@ public:
    */
   void trackAlloc(Allocation &alloc) {
     ZoneScoped;
+    if (m_mode == StagingAllocMode::Ring) {
+      trackAllocRing(alloc);
+      return;
+    }
     std::lock_guard lock(m_mutex);
 
     const auto it = std::ranges::find_if(
@@ -181,6 +242,10 @@ public:
    */
   void pollReclaimed() {
     ZoneScoped;
+    if (m_mode == StagingAllocMode::Ring) {
+      pollReclaimedRing();
+      return;
+    }
     std::lock_guard lock(m_mutex);
     const auto completed = m_device.getSemaphoreCounterValue(m_timeline.get());
 
@@ -200,11 +265,214 @@ public:
   }
 
   [[nodiscard]] vk::Buffer getBuffer() const { return m_buffer.get(); }
+  [[nodiscard]] vk::Semaphore getTimeline() const { return m_timeline.get(); }
+  [[nodiscard]] StagingAllocMode getMode() const { return m_mode; }
 
 private:
+  enum class ChunkState : uint64_t {
+    Free,
+    Owned, // Thread allocates from it
+    Sealed, // No new allocations, waits for transfers
+    Continuation // Covered by allocation started in previous chunk
+  };
+
+  /**
+   * Chunk state word is <code>generation << 8 | ChunkState</code>, generation grows on
+   * every reservation, so reclaim CAS never succeeds on chunk reused in between
+   */
+  struct RingChunk {
+    std::atomic_uint64_t state = 0;
+    std::atomic_uint32_t span = 1; // Chunks covered by allocation, > 1 only for allocation larger than chunk
+    std::atomic_uint32_t allocCount = 0; // Written by owner, final once sealed
+    std::atomic_uint32_t trackedCount = 0;
+    std::atomic_uint64_t maxTimeline = 0;
+  };
+
+  struct ThreadChunk {
+    uint64_t bufferId = 0;
+    uint32_t chunk = UINT32_MAX;
+    vk::DeviceSize used = 0;
+  };
+
+  static constexpr uint64_t packState(const uint64_t generation, const ChunkState state) {
+    return generation << 8 | static_cast<uint64_t>(state);
+  }
+
+  static constexpr ChunkState stateOf(const uint64_t word) { return static_cast<ChunkState>(word & 0xFF); }
+  static constexpr uint64_t generationOf(const uint64_t word) { return word >> 8; }
+
+  static constexpr vk::DeviceSize alignUp(const vk::DeviceSize value, const vk::DeviceSize alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+  }
+
+  static ThreadChunk &threadChunk() {
+    static thread_local ThreadChunk local;
+    return local;
+  }
+
+  std::optional<Allocation> tryAllocateRing(const vk::DeviceSize size, const vk::DeviceSize alignment) {
+    const auto maxPadding = alignment - 1;
+    if (size + maxPadding > m_chunkSize) {
+      const auto span = static_cast<uint32_t>((size + maxPadding + m_chunkSize - 1) / m_chunkSize);
+      if (span > m_chunkCount)
+        throw std::runtime_error("Try to allocate size > staging ring capacity");
+      const auto first = acquireChunks(span);
+      if (!first)
+        return std::nullopt;
+
+      // Dedicated chunks, sealed at once
+      auto &chunk = m_chunks[*first];
+      chunk.allocCount.store(1, std::memory_order_relaxed);
+      const auto alloc = makeAllocation(alignUp(*first * m_chunkSize, alignment), size, *first);
+      chunk.state.store(packState(generationOf(chunk.state.load(std::memory_order_relaxed)), ChunkState::Sealed),
+                        std::memory_order_release);
+      return alloc;
+    }
+
+    auto &local = threadChunk();
+    if (local.bufferId != m_id)
+      local = ThreadChunk{.bufferId = m_id};
+
+    if (local.chunk != UINT32_MAX) {
+      if (const auto alloc = bumpAllocate(local, size, alignment))
+        return alloc;
+
+      // Chunk is full: start over in place if all its transfers are done, hand it to reclaim otherwise
+      auto &chunk = m_chunks[local.chunk];
+      if (chunk.trackedCount.load(std::memory_order_acquire) == chunk.allocCount.load(std::memory_order_relaxed) &&
+          chunk.maxTimeline.load(std::memory_order_relaxed) <= m_device.getSemaphoreCounterValue(m_timeline.get())) {
+        local.used = 0;
+        chunk.allocCount.store(0, std::memory_order_relaxed);
+        chunk.trackedCount.store(0, std::memory_order_relaxed);
+        chunk.maxTimeline.store(0, std::memory_order_relaxed);
+        return bumpAllocate(local, size, alignment);
+      }
+      sealChunk(local.chunk);
+      local.chunk = UINT32_MAX;
+    }
+
+    const auto chunk = acquireChunks(1);
+    if (!chunk)
+      return std::nullopt;
+    local.chunk = *chunk;
+    local.used = 0;
+    return bumpAllocate(local, size, alignment);
+  }
+
+  std::optional<Allocation> bumpAllocate(ThreadChunk &local, const vk::DeviceSize size,
+                                         const vk::DeviceSize alignment) {
+    const auto base = local.chunk * m_chunkSize;
+    const auto offset = alignUp(base + local.used, alignment);
+    if (offset + size > base + m_chunkSize)
+      return std::nullopt;
+
+    local.used = offset + size - base;
+    m_chunks[local.chunk].allocCount.fetch_add(1, std::memory_order_relaxed);
+    return makeAllocation(offset, size, local.chunk);
+  }
+
+  [[nodiscard]] Allocation makeAllocation(const vk::DeviceSize offset, const vk::DeviceSize size,
+                                          const uint32_t chunk) const {
+    Allocation allocation;
+    allocation.size = size;
+    allocation.offset = offset;
+    allocation.mapped = static_cast<char *>(m_mapped) + offset;
+    allocation.chunk = chunk;
+    return allocation;
+  }
+
+  /**
+   * Reserve <code>span</code> adjacent free chunks starting from ring cursor
+   * @return index of first chunk, it is left Owned, others are Continuation
+   */
+  std::optional<uint32_t> acquireChunks(const uint32_t span) {
+    const auto start = m_ringCursor.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < m_chunkCount; ++i) {
+      const auto first = (start + i) % m_chunkCount;
+      if (first + span > m_chunkCount)
+        continue;
+
+      uint32_t acquired = 0;
+      for (; acquired < span; ++acquired) {
+        auto &state = m_chunks[first + acquired].state;
+        auto word = state.load(std::memory_order_relaxed);
+        const auto desired = acquired == 0 ? ChunkState::Owned : ChunkState::Continuation;
+        if (stateOf(word) != ChunkState::Free ||
+            !state.compare_exchange_strong(word, packState(generationOf(word) + 1, desired),
+                                           std::memory_order_acq_rel))
+          break;
+      }
+
+      if (acquired == span) {
+        auto &chunk = m_chunks[first];
+        chunk.span.store(span, std::memory_order_relaxed);
+        chunk.allocCount.store(0, std::memory_order_relaxed);
+        chunk.trackedCount.store(0, std::memory_order_relaxed);
+        chunk.maxTimeline.store(0, std::memory_order_relaxed);
+        m_ringCursor.store((first + span) % m_chunkCount, std::memory_order_relaxed);
+        return first;
+      }
+
+      for (uint32_t j = 0; j < acquired; ++j) {
+        auto &state = m_chunks[first + j].state;
+        state.store(packState(generationOf(state.load(std::memory_order_relaxed)), ChunkState::Free),
+                    std::memory_order_release);
+      }
+    }
+    return std::nullopt;
+  }
+
+  void sealChunk(const uint32_t index) {
+    auto &chunk = m_chunks[index];
+    const auto generation = generationOf(chunk.state.load(std::memory_order_relaxed));
+    const auto state = chunk.allocCount.load(std::memory_order_relaxed) == 0 ? ChunkState::Free : ChunkState::Sealed;
+    chunk.state.store(packState(generation, state), std::memory_order_release);
+  }
+
+  void trackAllocRing(Allocation &alloc) {
+    if (alloc.chunk >= m_chunkCount)
+      throw std::runtime_error("Tried to track allocation does not exist");
+
+    const auto value = ++m_nextTimelineValue;
+    alloc.timelineValue = value;
+    auto &chunk = m_chunks[alloc.chunk];
+    auto prev = chunk.maxTimeline.load(std::memory_order_relaxed);
+    while (prev < value && !chunk.maxTimeline.compare_exchange_weak(prev, value, std::memory_order_relaxed)) {
+    }
+    chunk.trackedCount.fetch_add(1, std::memory_order_release);
+  }
+
+  void pollReclaimedRing() {
+    const auto completed = m_device.getSemaphoreCounterValue(m_timeline.get());
+    for (uint32_t i = 0; i < m_chunkCount; ++i) {
+      auto &chunk = m_chunks[i];
+      auto word = chunk.state.load(std::memory_order_acquire);
+      if (stateOf(word) != ChunkState::Sealed)
+        continue;
+
+      const auto span = chunk.span.load(std::memory_order_relaxed);
+      if (chunk.trackedCount.load(std::memory_order_acquire) != chunk.allocCount.load(std::memory_order_relaxed) ||
+          chunk.maxTimeline.load(std::memory_order_relaxed) > completed)
+        continue;
+
+      if (!chunk.state.compare_exchange_strong(word, packState(generationOf(word), ChunkState::Free),
+                                               std::memory_order_acq_rel))
+        continue;
+      for (uint32_t j = 1; j < span; ++j) {
+        auto &state = m_chunks[i + j].state;
+        state.store(packState(generationOf(state.load(std::memory_order_relaxed)), ChunkState::Free),
+                    std::memory_order_release);
+      }
+    }
+  }
+
+  static inline std::atomic_uint64_t s_nextId = 0;
+
   const vk::Device m_device = nullptr;
   const vma::Allocator m_allocator = nullptr;
   const vk::DeviceSize m_bufferSize = 0;
+  const StagingAllocMode m_mode = StagingAllocMode::VirtualBlock;
+  const uint64_t m_id = ++s_nextId; // Keys thread-local chunk reservations
 
   vma::UniqueBuffer m_buffer;
   vma::UniqueAllocation m_bufferAlloc;
@@ -215,6 +483,11 @@ private:
   std::vector<Allocation> m_pending;
   std::vector<Allocation> m_transferring;
 
+  std::unique_ptr<RingChunk[]> m_chunks;
+  vk::DeviceSize m_chunkSize = 0;
+  uint32_t m_chunkCount = 0;
+  std::atomic_uint32_t m_ringCursor = 0;
+
   vk::UniqueSemaphore m_timeline;
   uint64_t m_nextTimelineValue = 0;
 };
@@ -8,7 +8,7 @@ vk::SurfaceFormatKHR get_swapchain_surface_format(
   const auto formats = physical_device.getSurfaceFormatsKHR(surface);
 
   for (const auto format: formats) {
-    if (format.format == vk::Format::eB8G8R8A8Unorm
+    if (format.format == SWAPCHAIN_COLOR_FORMAT
         && format.colorSpace == vk::ColorSpaceKHR::eSrgbNonlinear) {
       return format;
     }
@@ -118,6 +118,38 @@ Swapchain::Swapchain(
   imageViews = create_swapchain_image_views(device, images, format);
 }
 
+/**
+ * Create offscreen "swapchain" for headless rendering: a set of device local
+ * color images which can be used as final color attachment and copied out
+ */
+Swapchain::Swapchain(
+  const vk::Device &device,
+  const vma::Allocator allocator,
+  const vk::Extent2D extent,
+  const uint32_t imageCount,
+  const vk::Format format
+) {
+  ZoneScoped;
+  this->format = format;
+  this->extent = extent;
+  this->swapchain = nullptr;
+
+  for (uint32_t i = 0; i < imageCount; ++i) {
+    auto [image, alloc] = createImageUnique(
+      allocator,
+      extent.width, extent.height, 1,
+      vk::SampleCountFlagBits::e1, format, vk::ImageTiling::eOptimal,
+      vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc,
+      vk::MemoryPropertyFlagBits::eDeviceLocal
+    );
+    setObjectName(device, image.get(), std::format("Offscreen image {}", i));
+    images.push_back(image.get());
+    m_offscreenImages.push_back(std::move(image));
+    m_offscreenAllocs.push_back(std::move(alloc));
+  }
+  imageViews = create_swapchain_image_views(device, images, format);
+}
+
 void Swapchain::cmdSetViewport(const vk::CommandBuffer cmdBuffer) const {
   const auto viewport = vk::Viewport(0, 0, extent.width, extent.height, 0, 1);
   cmdBuffer.setViewport(0, viewport);
@@ -132,5 +164,13 @@ void Swapchain::destroy(const vk::Device &device) {
   for (auto image_view: imageViews) {
     device.destroyImageView(image_view);
   }
+  imageViews.clear();
+  images.clear();
+
+  if (isOffscreen()) {
+    m_offscreenImages.clear();
+    m_offscreenAllocs.clear();
+    return;
+  }
   device.destroySwapchainKHR(swapchain);
 }
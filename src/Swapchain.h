@@ -10,6 +10,8 @@
 #ifndef SWAPCHAIN_H
 #define SWAPCHAIN_H
 
+#define SWAPCHAIN_COLOR_FORMAT vk::Format::eB8G8R8A8Unorm // Picked with sRGB nonlinear color space, also offscreen one
+
 class Swapchain {
 public:
   Swapchain();
@@ -18,15 +20,26 @@ public:
     const vk::Device &device,
     const vk::PhysicalDevice &physical_device,
     GLFWwindow *window);
+  Swapchain(
+    const vk::Device &device,
+    vma::Allocator allocator,
+    vk::Extent2D extent,
+    uint32_t imageCount,
+    vk::Format format = SWAPCHAIN_COLOR_FORMAT);
   void cmdSetViewport(vk::CommandBuffer cmdBuffer) const;
   void cmdSetScissor(vk::CommandBuffer cmdBuffer) const;
   void destroy(const vk::Device &device);
+  [[nodiscard]] bool isOffscreen() const { return !m_offscreenImages.empty(); }
 
   vk::Format format;
   vk::Extent2D extent;
   vk::SwapchainKHR swapchain;
   std::vector<vk::Image> images;
   std::vector<vk::ImageView> imageViews;
+
+private:
+  std::vector<vma::UniqueImage> m_offscreenImages;
+  std::vector<vma::UniqueAllocation> m_offscreenAllocs;
 };
 
 #endif //SWAPCHAIN_H
@@ -16,8 +16,6 @@
 #include <cmath>
 #include <algorithm>
 
-#define MAX_TEXTURE_PER_DESCRIPTOR 64
-
 class Texture {
 public:
   Texture(
@@ -30,7 +28,9 @@ public:
     vk::ImageAspectFlags aspects,
     vk::ImageUsageFlags usage,
     bool useSampler = false,
-    const std::string &name = "Texture"
+    const std::string &name = "Texture",
+    uint32_t arrayLayers = 1,
+    bool cube = false
   );
 
   ~Texture() {
@@ -51,15 +51,28 @@ public:
   }
 
   vk::Image getImage() { return m_image.get(); };
+  /**
+   * @return view of single mip of first layer
+   */
   vk::ImageView getImageView(const uint32_t mipLevel = 0) { return m_imageViews.at(mipLevel).get(); };
+  /**
+   * @return 2D view of whole mip chain of first layer, used for material sampling
+   */
+  vk::ImageView getSampledView() { return m_sampledView.get(); };
+  /**
+   * @return 2D array or cube view of all layers and mips, nullptr for single layer texture
+   */
+  vk::ImageView getLayeredView() { return m_layeredView.get(); };
   vk::Sampler getSampler() { return m_sampler.get(); };
   ImTextureID getImGuiID() { return reinterpret_cast<ImTextureID>(static_cast<VkDescriptorSet>(m_imguiDS.get())); };
-  const uint32_t width, height, mipLevels;
+  const uint32_t width, height, mipLevels, arrayLayers;
 
 private:
   vma::UniqueImage m_image;
   vma::UniqueAllocation m_imageAlloc;
   std::vector<vk::UniqueImageView> m_imageViews;
+  vk::UniqueImageView m_sampledView;
+  vk::UniqueImageView m_layeredView;
   vk::UniqueDescriptorSet m_imguiDS;
 
   bool m_useSampler = false;
@@ -76,14 +89,17 @@ inline Texture::Texture(
   const vk::ImageAspectFlags aspects,
   const vk::ImageUsageFlags usage,
   const bool useSampler,
-  const std::string &name
-): width(width), height(height), mipLevels(mipLevels) {
+  const std::string &name,
+  const uint32_t arrayLayers,
+  const bool cube
+): width(width), height(height), mipLevels(mipLevels), arrayLayers(arrayLayers) {
   ZoneScoped;
   std::tie(m_image, m_imageAlloc) = createImageUnique(
     allocator,
     width, height, mipLevels,
     samples, format, vk::ImageTiling::eOptimal,
-    usage, vk::MemoryPropertyFlagBits::eDeviceLocal
+    usage, vk::MemoryPropertyFlagBits::eDeviceLocal,
+    arrayLayers, cube ? vk::ImageCreateFlagBits::eCubeCompatible : vk::ImageCreateFlags()
   );
   setObjectName(device, m_image.get(), std::format("{} ", name));
   auto info = allocator.getAllocationInfo(m_imageAlloc.get());
@@ -93,6 +109,19 @@ inline Texture::Texture(
     m_imageViews.emplace_back(createImageViewUnique(device, m_image.get(), format, aspects, mip));
     setObjectName(device, getImageView(mip), std::format("{} view (mip = {})", name, mip));
   }
+  m_sampledView = device.createImageViewUnique(vk::ImageViewCreateInfo(
+    {}, m_image.get(), vk::ImageViewType::e2D, format, {},
+    vk::ImageSubresourceRange(aspects, 0, mipLevels, 0, 1)));
+  setObjectName(device, getSampledView(), std::format("{} view", name));
+  if (arrayLayers > 1) {
+    m_layeredView = device.createImageViewUnique(vk::ImageViewCreateInfo(
+      {}, m_image.get(),
+      cube ? (arrayLayers > 6 ? vk::ImageViewType::eCubeArray : vk::ImageViewType::eCube)
+           : vk::ImageViewType::e2DArray,
+      format, {},
+      vk::ImageSubresourceRange(aspects, 0, mipLevels, 0, arrayLayers)));
+    setObjectName(device, getLayeredView(), std::format("{} layered view", name));
+  }
 
   if (useSampler) {
     m_sampler = createSamplerUnique(device);
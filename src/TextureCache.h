@@ -0,0 +1,173 @@
+#ifndef TEXTURECACHE_H
+#define TEXTURECACHE_H
+
+#include <algorithm>
+#include <filesystem>
+#include <format>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <spdlog/spdlog.h>
+#include <tracy/Tracy.hpp>
+
+#include <ktx.h>
+
+#define TEXTURE_CACHE_VERSION 1 // Bump when encoding changes, old entries are never hit again and get evicted
+
+enum class TextureKind : uint32_t {
+  Color, // Encoded as BC7 RGBA
+  Normal // Tangent-space XY encoded as BC5 RG, Z is reconstructed in shader
+};
+
+/**
+ * @brief Persistent cache of block-compressed KTX2 textures transcoded from generic images
+ *
+ * Entry is keyed by source file content hash and texture kind, so edited source gets
+ * a new key and outdated entry is never hit again. Entries over size cap are evicted
+ * in least recently used order (entry write time is refreshed on hit).
+ * Entry is written into temporary file and renamed, so concurrent readers never see partial file.
+ * @remark Thread safe, used by all texture workers
+ */
+class TextureCache {
+public:
+  TextureCache(std::filesystem::path directory, const uint64_t maxBytes)
+    : m_directory(std::move(directory)), m_maxBytes(maxBytes) {
+    ZoneScoped;
+    std::filesystem::create_directories(m_directory);
+    removeStaleTemporaries();
+    spdlog::info(std::format("Texture cache at {} (limit {} MB)", m_directory.string(), m_maxBytes / (1024 * 1024)));
+  }
+
+  TextureCache(const TextureCache &) = delete;
+
+  TextureCache &operator=(const TextureCache &) = delete;
+
+  /**
+   * @return cache key of file content, encoded image kind and cache version
+   */
+  static std::string makeKey(const std::span<const uint8_t> content, const TextureKind kind) {
+    ZoneScoped;
+    // FNV-1a 64
+    uint64_t hash = 14695981039346656037ull;
+    for (const auto byte: content) {
+      hash ^= byte;
+      hash *= 1099511628211ull;
+    }
+    return std::format("{:016x}_{}_v{}", hash, kind == TextureKind::Normal ? "bc5" : "bc7", TEXTURE_CACHE_VERSION);
+  }
+
+  /**
+   * @return path of cached KTX2 texture, std::nullopt on miss
+   */
+  std::optional<std::filesystem::path> find(const std::string &key) {
+    ZoneScoped;
+    const auto path = entryPath(key);
+    std::lock_guard lock(m_mutex);
+    std::error_code ec;
+    if (!std::filesystem::is_regular_file(path, ec))
+      return std::nullopt;
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+    return path;
+  }
+
+  /**
+   * Write texture as cache entry and evict oldest entries over size cap
+   */
+  void store(const std::string &key, ktxTexture2 *texture) {
+    ZoneScoped;
+    const auto path = entryPath(key);
+    auto tmpPath = path;
+    tmpPath += std::format(".{}.tmp", std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    if (ktxTexture_WriteToNamedFile(ktxTexture(texture), tmpPath.string().c_str()) != KTX_SUCCESS) {
+      spdlog::warn(std::format("Failed to write texture cache entry {}", path.string()));
+      std::error_code ec;
+      std::filesystem::remove(tmpPath, ec);
+      return;
+    }
+
+    std::lock_guard lock(m_mutex);
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) {
+      spdlog::warn(std::format("Failed to store texture cache entry {}: {}", path.string(), ec.message()));
+      std::filesystem::remove(tmpPath, ec);
+      return;
+    }
+    evict();
+  }
+
+  /**
+   * Drop entry which failed to load
+   */
+  void invalidate(const std::string &key) {
+    std::lock_guard lock(m_mutex);
+    std::error_code ec;
+    std::filesystem::remove(entryPath(key), ec);
+    spdlog::warn(std::format("Texture cache entry {} invalidated", key));
+  }
+
+private:
+  std::filesystem::path m_directory;
+  uint64_t m_maxBytes;
+  TracyLockableN(std::mutex, m_mutex, "Texture Cache Mutex");
+
+  [[nodiscard]] std::filesystem::path entryPath(const std::string &key) const {
+    return m_directory / (key + ".ktx2");
+  }
+
+  /**
+   * Remove temporary files left by <code>TextureCache::store</code> of crashed run, evict() sees entries only
+   */
+  void removeStaleTemporaries() const {
+    std::error_code ec;
+    for (const auto &file: std::filesystem::directory_iterator(m_directory, ec)) {
+      if (file.path().extension() == ".tmp" && file.is_regular_file(ec))
+        std::filesystem::remove(file.path(), ec);
+    }
+  }
+
+  /**
+   * Remove least recently used entries until cache fits size cap
+   * @remark Caller holds m_mutex
+   */
+  void evict() {
+    ZoneScoped;
+    struct Entry {
+      std::filesystem::path path;
+      uint64_t size;
+      std::filesystem::file_time_type time;
+    };
+    std::vector<Entry> entries;
+    uint64_t total = 0;
+    std::error_code ec;
+    for (const auto &file: std::filesystem::directory_iterator(m_directory, ec)) {
+      if (!file.is_regular_file(ec) || file.path().extension() != ".ktx2")
+        continue;
+      // Entry removed meanwhile (e.g. invalidated), failed size would be uintmax_t(-1)
+      const auto size = file.file_size(ec);
+      if (ec)
+        continue;
+      const auto time = file.last_write_time(ec);
+      if (ec)
+        continue;
+      entries.push_back({file.path(), size, time});
+      total += size;
+    }
+    if (total <= m_maxBytes)
+      return;
+
+    std::ranges::sort(entries, {}, &Entry::time);
+    for (const auto &entry: entries) {
+      if (total <= m_maxBytes)
+        break;
+      if (std::filesystem::remove(entry.path, ec))
+        total -= entry.size;
+    }
+  }
+};
+
+#endif //TEXTURECACHE_H
@@ -5,79 +5,184 @@ TextureManager::TextureManager(
   const vk::Queue graphicsQueue,
   const vk::CommandPool commandPool,
   TextureWorkerPool &workerPool,
+  TransferThread &transferThread,
   DescriptorSet &descriptorSet,
-  const uint32_t shaderBinding
-): m_device(device), m_graphicsQueue(graphicsQueue), m_commandPool(commandPool), m_descriptorSet(&descriptorSet),
-   m_workerPool(&workerPool), m_shaderBinding(shaderBinding) {
+  const uint32_t shaderBinding,
+  const uint32_t capacity
+): m_registry(capacity), m_device(device), m_graphicsQueue(graphicsQueue), m_commandPool(commandPool),
+   m_descriptorSet(&descriptorSet), m_workerPool(&workerPool), m_transferThread(&transferThread),
+   m_shaderBinding(shaderBinding) {
+  ZoneScoped;
   m_sampler = createSamplerUnique(device);
+  createNullTexture(TEXTURE_NULL_SLOT, {1.0f, 1.0f, 1.0f, 1.0f}, "Null texture");
+  createNullTexture(TEXTURE_FLAT_NORMAL_SLOT, {0.5f, 0.5f, 1.0f, 1.0f}, "Flat normal texture");
+  updateDS(descriptorSet);
+  spdlog::info(std::format("Bindless texture table of {} slots", m_registry.getCapacity()));
+}
+
+void TextureManager::createNullTexture(
+  const uint32_t slot,
+  const std::array<float, 4> &color,
+  const std::string &name
+) {
+  // Single texel, waiting here keeps every slot valid before first frame
+  auto [texture, upload] = m_workerPool->createSolidTexture(color, name);
+  upload->wait();
+  std::lock_guard lock(m_mutex);
+  placeTexture(slot, std::move(texture));
 }
 
-uint32_t TextureManager::loadTextureFromFile(
+TextureHandle TextureManager::loadTextureFromFile(
   const std::filesystem::path &textureParent,
   const std::filesystem::path &filename,
-  const vk::Format format
+  const TextureKind kind
 ) {
   ZoneScoped;
   const auto texturePath = textureParent / filename;
 
+  std::lock_guard lock(m_mutex);
   if (const auto it = m_cache.find(filename.string()); it != m_cache.end()) {
-    spdlog::info(std::format("Reuse texture {} from {}", filename.string(), it->second));
+    spdlog::info(std::format("Reuse texture {} from {}", filename.string(), TextureRegistry::slotOf(it->second)));
     return it->second;
   }
 
-  uint32_t slot = 0;
-  for (; slot < MAX_TEXTURE_PER_DESCRIPTOR; ++slot) {
-    if (!m_textures.contains(slot)) {
-      break;
-    }
-  }
-  spdlog::info(std::format("Push texture loading job: file {} at slot {}", filename.string(), slot));
-
-  if (slot >= MAX_TEXTURE_PER_DESCRIPTOR) {
+  const auto handle = m_registry.allocate();
+  if (!handle) {
     throw std::runtime_error(
-      std::format("Texture store full (limit = {})", MAX_TEXTURE_PER_DESCRIPTOR));
+      std::format("Texture store full (limit = {})", m_registry.getCapacity()));
   }
+  const auto slot = TextureRegistry::slotOf(*handle);
+  spdlog::info(std::format("Push texture loading job: file {} at slot {}", filename.string(), slot));
 
   const auto textureJob = TextureLoadJob{
     .texIndex = slot,
     .filepath = texturePath,
+    .kind = kind,
+    .token = std::make_shared<TextureLoadToken>()
   };
 
   m_workerPool->pushJob(textureJob);
   m_textures[slot] = nullptr;
-  m_cache[filename.string()] = slot;
+  m_cache[filename.string()] = *handle;
+  m_loadTokens[slot] = textureJob.token;
+
+  return *handle;
+}
+
+Task<std::optional<TextureHandle> > TextureManager::loadTexture(
+  JobSystem &jobSystem,
+  const std::filesystem::path textureParent,
+  const std::filesystem::path filename,
+  const TextureKind kind,
+  const JobPriority priority
+) {
+  const auto handle = loadTextureFromFile(textureParent, filename, kind);
+  const bool resident = co_await CompletionAwaiter(jobSystem, priority, [this, handle](CompletionAwaiter::Callback callback) {
+    whenResident(handle, std::move(callback));
+  });
+  co_return resident ? std::optional(handle) : std::nullopt;
+}
+
+void TextureManager::whenResident(const TextureHandle handle, std::function<void(bool)> fn) {
+  std::lock_guard lock(m_mutex);
+  if (!m_registry.isValid(handle)) {
+    fn(false);
+    return;
+  }
+  const auto slot = TextureRegistry::slotOf(handle);
+  if (const auto tex = m_textures.find(slot); tex == m_textures.end() || tex->second != nullptr) {
+    fn(tex != m_textures.end());
+    return;
+  }
+  if (!m_loadTokens.contains(slot)) {
+    fn(false); // Load failed, slot keeps null texture
+    return;
+  }
+  m_residentWaiters[slot].push_back(std::move(fn));
+}
+
+void TextureManager::notifyResident(const uint32_t slot, const bool resident) {
+  const auto waiters = m_residentWaiters.find(slot);
+  if (waiters == m_residentWaiters.end())
+    return;
+  for (const auto &fn: waiters->second)
+    fn(resident);
+  m_residentWaiters.erase(waiters);
+}
 
-  return slot;
+void TextureManager::placeTexture(const uint32_t slot, std::unique_ptr<Texture> texture) {
+  m_textures[slot] = std::move(texture);
+  m_textures[slot]->createImguiView();
+  m_textureDescriptors[slot] = vk::DescriptorImageInfo(
+    m_sampler.get(), m_textures[slot]->getSampledView(), vk::ImageLayout::eShaderReadOnlyOptimal);
+  m_descriptorSet->updateTexture(m_device, m_shaderBinding, slot, m_textureDescriptors[slot]);
 }
 
 void TextureManager::checkTextureLoading() {
-  if (TextureLoadDone loadDone{}; m_workerPool->tryDequeueDone(loadDone)) {
+  for (TextureLoadDone loadDone{}; m_workerPool->tryDequeueDone(loadDone);) {
+    m_uploading.push_back(std::move(loadDone));
+  }
+
+  // Cancelled texture is released only after its upload, so GPU never copies into freed image
+  const auto ready = [](const TextureLoadDone &done) { return !done.upload || done.upload->isReady(); };
+  bool releaseInFlight = false;
+  for (auto &loadDone: m_uploading) {
+    if (!ready(loadDone))
+      continue;
+    if (loadDone.job.token->cancelled.load()) {
+      // Its ownership acquire may be still pending or recorded into frame in flight
+      if (loadDone.texture && m_transferThread->forgetImage(loadDone.texture->getImage()))
+        releaseInFlight = true;
+
+      // Token is still registered when worker failed the load, not when slot was unloaded
+      std::lock_guard lock(m_mutex);
+      const auto slot = loadDone.job.texIndex;
+      if (const auto token = m_loadTokens.find(slot); token != m_loadTokens.end() && token->second == loadDone.job.token) {
+        m_loadTokens.erase(token);
+        notifyResident(slot, false);
+      }
+      continue;
+    }
+
     ZoneScopedN("Loaded texture move");
+    std::lock_guard lock(m_mutex);
     const auto slot = loadDone.job.texIndex;
     if (m_textures[slot] != nullptr)
       spdlog::warn(std::format("Try to move texture {} into occupied slot {}",
                                loadDone.job.filepath.string(), slot));
 
-//TODO: gen mipmaps
-
-    m_textures[slot] = std::move(loadDone.texture);
-    m_textures[slot]->createImguiView();
-    m_textureDescriptors[slot] = vk::DescriptorImageInfo(
-      m_sampler.get(), m_textures[slot]->getImageView(), vk::ImageLayout::eShaderReadOnlyOptimal);
-    m_descriptorSet->updateTexture(m_device, m_shaderBinding, slot, m_textureDescriptors[slot]);
+    placeTexture(slot, std::move(loadDone.texture));
+    m_loadTokens.erase(slot);
+    notifyResident(slot, true);
+  }
+  if (releaseInFlight) {
+    // Cancelled textures are rare, so waiting for frames in flight is cheaper than tracking their fences
+    ZoneScopedN("Wait frames using released textures");
+    m_graphicsQueue.waitIdle();
   }
+  std::erase_if(m_uploading, ready);
+}
+
+bool TextureManager::hasPendingLoads() const {
+  std::lock_guard lock(m_mutex);
+  return !m_loadTokens.empty();
 }
 
 void TextureManager::updateDS(DescriptorSet &descriptorSet) {
+  ZoneScoped;
+  std::lock_guard lock(m_mutex);
   m_descriptorSet = &descriptorSet;
-  for (const auto &slot: m_textures) {
-    if (slot.second == nullptr) continue;
-    m_descriptorSet->updateTexture(m_device, m_shaderBinding, slot.first, m_textureDescriptors.at(slot.first));
-  }
+  auto imageInfos = std::vector(m_registry.getCapacity(), m_textureDescriptors.at(TEXTURE_NULL_SLOT));
+  for (const auto &[slot, imageInfo]: m_textureDescriptors)
+    imageInfos[slot] = imageInfo;
+  m_descriptorSet->updateTextures(m_device, m_shaderBinding, 0, imageInfos);
 }
 
-std::optional<Texture *> TextureManager::getTexture(const uint32_t slot) {
-  if (const auto tex = m_textures.find(slot); tex != m_textures.end()) {
+std::optional<Texture *> TextureManager::getTexture(const TextureHandle handle) {
+  std::lock_guard lock(m_mutex);
+  if (!m_registry.isValid(handle))
+    return std::nullopt;
+  if (const auto tex = m_textures.find(TextureRegistry::slotOf(handle)); tex != m_textures.end()) {
     if (tex->second == nullptr) return std::nullopt;
     return tex->second.get();
   }
@@ -85,13 +190,59 @@ std::optional<Texture *> TextureManager::getTexture(const uint32_t slot) {
   return std::nullopt;
 }
 
-void TextureManager::unloadTexture(const uint32_t slot) {
+std::vector<TextureHandle> TextureManager::getSlots() const {
+  std::lock_guard lock(m_mutex);
+  std::vector<uint32_t> slots;
+  slots.reserve(m_textures.size());
+  for (const auto slot: m_textures | std::views::keys)
+    slots.push_back(slot);
+  std::ranges::sort(slots);
+
+  std::vector<TextureHandle> handles;
+  handles.reserve(slots.size());
+  for (const auto slot: slots)
+    handles.push_back(m_registry.handleOf(slot));
+  return handles;
+}
+
+void TextureManager::setLoadPriority(const TextureHandle handle, const float priority) {
+  std::lock_guard lock(m_mutex);
+  if (!m_registry.isValid(handle))
+    return;
+  if (const auto token = m_loadTokens.find(TextureRegistry::slotOf(handle)); token != m_loadTokens.end())
+    token->second->priority = priority;
+}
+
+void TextureManager::cancelLoad(const TextureHandle handle) {
+  {
+    std::lock_guard lock(m_mutex);
+    if (!m_registry.isValid(handle) || !m_loadTokens.contains(TextureRegistry::slotOf(handle)))
+      return;
+  }
+  spdlog::info(std::format("Cancel texture loading at slot {}", TextureRegistry::slotOf(handle)));
+  unloadTexture(handle);
+}
+
+void TextureManager::unloadTexture(const TextureHandle handle) {
+  std::lock_guard lock(m_mutex);
+  if (TextureRegistry::isReserved(handle) || !m_registry.release(handle))
+    return;
+
+  const auto slot = TextureRegistry::slotOf(handle);
+  if (const auto token = m_loadTokens.find(slot); token != m_loadTokens.end()) {
+    token->second->cancelled = true;
+    m_loadTokens.erase(token);
+  }
+  notifyResident(slot, false);
+
   if (const auto tex = m_textures.find(slot); tex != m_textures.end()) {
     m_textures.erase(tex);
   }
+  if (m_textureDescriptors.erase(slot) > 0)
+    m_descriptorSet->updateTexture(m_device, m_shaderBinding, slot, m_textureDescriptors.at(TEXTURE_NULL_SLOT));
 
   for (auto c = m_cache.begin(); c != m_cache.end(); ++c) {
-    if (c->second == slot) {
+    if (c->second == handle) {
       m_cache.erase(c);
       break;
     }
@@ -1,51 +1,153 @@
 #ifndef TEXTUREMANAGER_H
 #define TEXTUREMANAGER_H
 
+#include <functional>
+#include <mutex>
+
+#include "Async.h"
 #include "DescriptorSet.h"
+#include "TextureRegistry.h"
 #include "TextureWorkersPool.h"
 #include "Swapchain.h"
 #include "Texture.h"
 #include "utils.cpp"
 
+/**
+ * @brief Owns loaded textures and their slots in bindless texture array
+ *
+ * Slots are allocated by <code>TextureRegistry</code>, textures are addressed by generation-tagged
+ * <code>TextureHandle</code>, so call with handle of unloaded texture is no-op instead of touching reused slot.
+ * Slot without resident texture (unused, loading or failed) samples null texture,
+ * reserved <code>TEXTURE_NULL_HANDLE</code> and <code>TEXTURE_FLAT_NORMAL_HANDLE</code> stand for missing maps.
+ *
+ * <code>TextureManager::loadTextureFromFile</code> can be called from any thread
+ * (e.g. model loader worker), other methods are for render thread.
+ * Coroutines use <code>TextureManager::loadTexture</code> to continue once texture is placed into its slot.
+ */
 class TextureManager {
 public:
+  /**
+   * Creates null textures and waits for their upload, fills every slot of descriptor set
+   * @param capacity bindless table size, see <code>TextureRegistry::capacityFromLimits</code>
+   */
   TextureManager(
     vk::Device device,
     vk::Queue graphicsQueue,
     vk::CommandPool commandPool,
     TextureWorkerPool &workerPool,
+    TransferThread &transferThread,
     DescriptorSet &descriptorSet,
-    uint32_t shaderBinding
+    uint32_t shaderBinding,
+    uint32_t capacity
   );
 
   ~TextureManager() = default;
 
-  uint32_t loadTextureFromFile(
+  /**
+   * Start texture load, file already loaded or loading returns its handle
+   * @throws std::runtime_error when every slot is used
+   */
+  TextureHandle loadTextureFromFile(
     const std::filesystem::path &textureParent,
     const std::filesystem::path &filename,
-    vk::Format format = vk::Format::eR8G8B8A8Unorm
+    TextureKind kind = TextureKind::Color
+  );
+
+  /**
+   * Load texture and resume once it is placed into its slot, e.g.
+   * <code>const auto handle = co_await textureManager.loadTexture(jobSystem, parent, filename)</code>
+   * @remark Texture is placed by <code>TextureManager::checkTextureLoading</code>, so render thread must keep calling it
+   * @return handle of resident texture, std::nullopt when load failed or was cancelled
+   */
+  Task<std::optional<TextureHandle> > loadTexture(
+    JobSystem &jobSystem,
+    std::filesystem::path textureParent,
+    std::filesystem::path filename,
+    TextureKind kind = TextureKind::Color,
+    JobPriority priority = JobPriority::Normal
   );
 
+  /**
+   * Call fn(true) once texture is resident, fn(false) when its load failed or was cancelled
+   * or handle is stale. Called immediately when texture is already resolved.
+   * @remark fn must be short (e.g. submit job), it may be called on render thread under manager lock
+   */
+  void whenResident(TextureHandle handle, std::function<void(bool)> fn);
+
+  /**
+   * Take finished loads, texture is placed into its slot once its upload is done on GPU.
+   * Cancelled or failed texture is destroyed once its upload is done and no frame in flight acquires it
+   * (see <code>TransferThread::forgetImage</code>).
+   */
   void checkTextureLoading();
 
-  void updateDS(DescriptorSet& descriptorSet);
+  [[nodiscard]] bool hasPendingLoads() const;
+
+  /**
+   * Write every slot into descriptor set (null texture into unused ones) and use it for later updates
+   */
+  void updateDS(DescriptorSet &descriptorSet);
+
+  std::optional<Texture *> getTexture(TextureHandle handle);
 
-  std::optional<Texture *> getTexture(uint32_t slot);
+  /**
+   * @return snapshot of handles of occupied slots (including loading ones), sorted by slot
+   */
+  [[nodiscard]] std::vector<TextureHandle> getSlots() const;
 
-  void unloadTexture(uint32_t slot);
+  /**
+   * Free texture slot, no-op for stale handle and null textures
+   */
+  void unloadTexture(TextureHandle handle);
+
+  /**
+   * Change priority of texture load which is still queued, no-op for loaded texture
+   * @param priority higher is loaded first, e.g. screen-space size of meshes using texture
+   */
+  void setLoadPriority(TextureHandle handle, float priority);
+
+  /**
+   * Cancel texture load which is still in progress and free its slot, no-op for loaded texture
+   */
+  void cancelLoad(TextureHandle handle);
+
+  [[nodiscard]] uint32_t getCapacity() const { return m_registry.getCapacity(); }
 
-  std::unordered_map<uint32_t, std::unique_ptr<Texture> > m_textures = {};
 private:
+  mutable TracyLockableN(std::mutex, m_mutex, "Texture Manager Mutex");
+  TextureRegistry m_registry;
+  std::unordered_map<uint32_t, std::unique_ptr<Texture> > m_textures = {}; // By slot, nullptr while loading or failed
   vk::Device m_device = nullptr;
   vk::Queue m_graphicsQueue = nullptr;
   vk::CommandPool m_commandPool = nullptr;
   DescriptorSet *m_descriptorSet = nullptr;
   TextureWorkerPool *m_workerPool = nullptr;
+  TransferThread *m_transferThread = nullptr;
   uint32_t m_shaderBinding = 0;
 
-  std::unordered_map<std::string, uint32_t> m_cache = {};
-  std::unordered_map<uint32_t, vk::DescriptorImageInfo> m_textureDescriptors = {};
+  std::unordered_map<std::string, TextureHandle> m_cache = {};
+  std::unordered_map<uint32_t, vk::DescriptorImageInfo> m_textureDescriptors = {}; // By slot, resident only
+  std::unordered_map<uint32_t, std::shared_ptr<TextureLoadToken> > m_loadTokens = {}; // Slots being loaded
+  std::vector<TextureLoadDone> m_uploading = {}; // Render thread only, upload may be in flight
+  std::unordered_map<uint32_t, std::vector<std::function<void(bool)> > > m_residentWaiters = {}; // Slots being loaded
   vk::UniqueSampler m_sampler;
+
+  /**
+   * Create reserved texture of single color and place it once its upload is done
+   */
+  void createNullTexture(uint32_t slot, const std::array<float, 4> &color, const std::string &name);
+
+  /**
+   * Make texture resident in slot and write its descriptor
+   * @remark Caller holds m_mutex
+   */
+  void placeTexture(uint32_t slot, std::unique_ptr<Texture> texture);
+
+  /**
+   * Call and remove waiters of slot
+   * @remark Caller holds m_mutex
+   */
+  void notifyResident(uint32_t slot, bool resident);
 };
 
 
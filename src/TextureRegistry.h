@@ -0,0 +1,113 @@
+#ifndef TEXTUREREGISTRY_H
+#define TEXTUREREGISTRY_H
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#define TEXTURE_REGISTRY_MAX_SLOTS 16384 // Upper bound of bindless texture table, device limits may lower it
+#define TEXTURE_SLOT_BITS 20 // Handle = generation << TEXTURE_SLOT_BITS | slot
+#define TEXTURE_SLOT_MASK ((1u << TEXTURE_SLOT_BITS) - 1)
+#define TEXTURE_NULL_SLOT 0 // White, written into every unused slot, materials without albedo texture use it
+#define TEXTURE_FLAT_NORMAL_SLOT 1 // Tangent-space (0, 0, 1), materials without normal map use it
+#define TEXTURE_RESERVED_SLOTS 2 // Null textures above, never released
+
+/**
+ * Slot in low bits, generation of slot in high bits, shader receives slot only (see <code>TextureRegistry::slotOf</code>)
+ */
+using TextureHandle = uint32_t;
+
+#define TEXTURE_NULL_HANDLE static_cast<TextureHandle>(TEXTURE_NULL_SLOT)
+#define TEXTURE_FLAT_NORMAL_HANDLE static_cast<TextureHandle>(TEXTURE_FLAT_NORMAL_SLOT)
+
+/**
+ * @brief Slot allocator of bindless texture table
+ *
+ * Free slots are kept in LIFO free list, so allocation and release are O(1) and recently
+ * freed slot is reused first. Every release bumps slot generation, handle carries generation
+ * it was allocated with, so handle kept after release is detected as stale instead of
+ * silently addressing texture which reused its slot (generation wraps after 4096 reuses of one slot).
+ * @remark Not thread safe, owner serializes access
+ */
+class TextureRegistry {
+public:
+  TextureRegistry() = default;
+
+  explicit TextureRegistry(const uint32_t capacity)
+    : m_generations(std::max<uint32_t>(capacity, TEXTURE_RESERVED_SLOTS), 0) {
+    // Reversed, so lowest slot is allocated first
+    for (auto slot = static_cast<uint32_t>(m_generations.size()); slot > TEXTURE_RESERVED_SLOTS; --slot)
+      m_freeSlots.push_back(slot - 1);
+  }
+
+  /**
+   * @return table size fitting device update-after-bind descriptor limits and <code>TEXTURE_REGISTRY_MAX_SLOTS</code>
+   */
+  static uint32_t capacityFromLimits(const vk::PhysicalDevice physicalDevice) {
+    const auto props = physicalDevice.getProperties2<
+      vk::PhysicalDeviceProperties2, vk::PhysicalDeviceDescriptorIndexingProperties>()
+        .get<vk::PhysicalDeviceDescriptorIndexingProperties>();
+    return std::min({
+      static_cast<uint32_t>(TEXTURE_REGISTRY_MAX_SLOTS),
+      props.maxDescriptorSetUpdateAfterBindSampledImages,
+      props.maxDescriptorSetUpdateAfterBindSamplers,
+      props.maxPerStageDescriptorUpdateAfterBindSampledImages,
+      props.maxPerStageDescriptorUpdateAfterBindSamplers
+    });
+  }
+
+  static uint32_t slotOf(const TextureHandle handle) { return handle & TEXTURE_SLOT_MASK; }
+
+  static bool isReserved(const TextureHandle handle) { return slotOf(handle) < TEXTURE_RESERVED_SLOTS; }
+
+  /**
+   * @return handle of free slot, std::nullopt when table is full
+   */
+  std::optional<TextureHandle> allocate() {
+    if (m_freeSlots.empty())
+      return std::nullopt;
+    const auto slot = m_freeSlots.back();
+    m_freeSlots.pop_back();
+    return handleOf(slot);
+  }
+
+  /**
+   * Return slot into free list, stale or reserved handle is ignored
+   * @return false when handle was not live
+   */
+  bool release(const TextureHandle handle) {
+    if (!isValid(handle) || isReserved(handle))
+      return false;
+    const auto slot = slotOf(handle);
+    m_generations[slot] = (m_generations[slot] + 1) & (UINT32_MAX >> TEXTURE_SLOT_BITS);
+    m_freeSlots.push_back(slot);
+    return true;
+  }
+
+  /**
+   * @return handle addresses slot in table and its generation is current, i.e. slot was not released since
+   */
+  [[nodiscard]] bool isValid(const TextureHandle handle) const {
+    const auto slot = slotOf(handle);
+    return slot < m_generations.size() && handle == handleOf(slot);
+  }
+
+  /**
+   * @return current handle of slot
+   */
+  [[nodiscard]] TextureHandle handleOf(const uint32_t slot) const {
+    return m_generations[slot] << TEXTURE_SLOT_BITS | slot;
+  }
+
+  [[nodiscard]] uint32_t getCapacity() const { return static_cast<uint32_t>(m_generations.size()); }
+
+  [[nodiscard]] uint32_t getUsedSlots() const { return getCapacity() - static_cast<uint32_t>(m_freeSlots.size()); }
+
+private:
+  std::vector<uint32_t> m_generations; // Per slot
+  std::vector<uint32_t> m_freeSlots; // LIFO
+};
+
+#endif //TEXTUREREGISTRY_H
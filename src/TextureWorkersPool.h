@@ -1,67 +1,175 @@
 #ifndef TEXTUREWORKERSPOOL_H
 #define TEXTUREWORKERSPOOL_H
 
+#include <array>
+#include <atomic>
+#include <bit>
+#include <mutex>
+#include <numeric>
 #include <vulkan/vulkan.hpp>
-#include "concurrentqueue/blockingconcurrentqueue.h"
+#include <vulkan/vulkan_format_traits.hpp>
 #include "concurrentqueue/concurrentqueue.h"
 #include <stb_image.h>
 
 #include <ktx.h>
 #include <ktxvulkan.h>
 
+#include "JobSystem.h"
+#include "MappedFile.h"
+#include "PixelConvert.h"
 #include "StagingBuffer.h"
+#include "TextureCache.h"
 #include "TransferThread.h"
 #include "Texture.h"
 #include <filesystem>
 
+/**
+ * Shared by texture owner and loader, checked by worker before decode and before staging
+ */
+struct TextureLoadToken {
+  std::atomic<float> priority = 0.0f; // Higher is loaded first, may be changed while job is queued
+  std::atomic_bool cancelled = false;
+};
+
 struct TextureLoadJob {
   uint32_t texIndex = UINT32_MAX;
   std::filesystem::path filepath;
+  TextureKind kind = TextureKind::Color;
+  std::shared_ptr<TextureLoadToken> token;
+  std::shared_ptr<MappedFile> file; // Mapped and prefetched by TextureWorkerPool::pushJob
+};
+
+/**
+ * Image data of KTX texture: loaded <code>pData</code> or mapped file copied straight into staging memory
+ */
+struct KtxImageSource {
+  ktxTexture2 *texture;
+  std::span<const uint8_t> file; // Mapped KTX2 file, image data is read from it when set
+  uint64_t dataFileOffset = 0; // File offset of pData start (smallest level is stored first)
+
+  /**
+   * @throws std::runtime_error when size bytes of image data at pData-relative offset are not in source
+   */
+  void checkBounds(const ktx_size_t offset, const vk::DeviceSize size) const {
+    if (file.empty() ? offset + size > texture->dataSize : dataFileOffset + offset + size > file.size())
+      throw std::runtime_error("KTX2 image data is out of file bounds");
+  }
+
+  /**
+   * Write size bytes of image data starting at pData-relative offset into dst
+   */
+  void read(void *dst, const ktx_size_t offset, const vk::DeviceSize size) const {
+    checkBounds(offset, size);
+    if (file.empty()) {
+      memcpy(dst, texture->pData + offset, size);
+      return;
+    }
+    memcpy(dst, file.data() + dataFileOffset + offset, size);
+  }
+};
+
+#define KTX_PARALLEL_TRANSCODE_MIN_SIZE (4 * 1024 * 1024) // UASTC textures with larger base level are transcoded by parts
+
+/**
+ * Block rows of one UASTC image, transcoded as standalone single-level KTX2 texture
+ */
+struct KtxTranscodeBand {
+  uint32_t level;
+  uint32_t layer; // Array layer * face count + face
+  uint32_t firstRow; // In 4x4 blocks
+  uint32_t rowCount;
+  vk::DeviceSize offset; // In staging allocation of part
+};
+
+/**
+ * Bands sharing one staging allocation and upload job of at most <code>TRANSFER_MAX_JOB_SIZE</code>
+ */
+struct KtxTranscodePart {
+  std::vector<KtxTranscodeBand> bands;
+  vk::DeviceSize size = 0;
+};
+
+/**
+ * Large UASTC texture split into parts, which are transcoded into BC7 in parallel by owning job
+ * and helper jobs. Every part is staged by job transcoding it, upload jobs are pushed by owner only,
+ * so first and last job of image keep push order required by <code>TransferThread</code>.
+ * Parts claimed after first failure are skipped.
+ */
+struct KtxTranscodeBatch {
+  KtxImageSource source;
+  std::vector<ktx_size_t> levelOffsets; // pData-relative
+  std::vector<uint32_t> dfd; // Texture DFD with bytesPlane0 of raw UASTC
+  vk::Image image;
+  vk::Format format; // BC7, every band must transcode into it
+  vk::ImageSubresourceRange range;
+  std::shared_ptr<UploadHandle> upload;
+  std::vector<KtxTranscodePart> parts;
+  std::atomic_uint32_t nextPart = 0;
+  std::atomic_uint32_t finishedParts = 0;
+  moodycamel::ConcurrentQueue<TextureUploadJob> staged; // Staged parts waiting for owner to push them
+  TracyLockableN(std::mutex, errorMutex, "KTX Transcode Error Mutex");
+  std::exception_ptr error; // First part failure, rethrown by owner
+  std::atomic_bool failed = false; // Set with error, checked without lock
 };
 
 struct TextureLoadDone {
   TextureLoadJob job;
-  std::unique_ptr<Texture> texture;
+  std::unique_ptr<Texture> texture; // nullptr when job was cancelled before staging
+  std::shared_ptr<UploadHandle> upload; // Texture may be used once upload is ready
 };
 
 /**
- * @brief Thread pool for async loading of textures and place upload jobs
+ * @brief Async loading of textures on <code>JobSystem</code> and place upload jobs
  *
  * Handles generic and KTX/KTX2 textures formats.
  *
  * Loading lifecycle:
  * 1. Fill <code>TextureLoadJob</code> and pass it into
  * <code>TextureWorkerPool::pushJob</code>
- * 2. Next available thread from pool dequeue job, loading by stb_image or
+ * 2. Every pushed load submits one job, which takes queued load with highest token priority
+ * when it starts (priorities change while queued), loading by stb_image or
  * ktx library (depending on the extension), get allocation from staging buffer,
  * copy into staging buffer and place upload job into transfer thread
  * 3. After texture loading completed <code>TextureLoadDone</code> placed at
  * done queue and ready texture can get by call <code>TextureWorkerPool::tryDequeueDone</code>
+ *
+ * Cancelled job is skipped before decode or dropped before staging, it is still
+ * reported as done with empty texture. Job failed after its first upload job was pushed
+ * is reported with its texture, upload and cancelled token, since GPU may still copy into image.
+ *
+ * With <code>TextureCache</code> generic image is encoded once (with CPU-built mip chain)
+ * into BC7 or BC5 KTX2 entry, later loads of same content take KTX path.
+ *
+ * Large UASTC KTX2 texture is transcoded by parts (see <code>KtxTranscodeBatch</code>), helper jobs
+ * on idle workers take its parts, so one texture does not hold single worker for whole transcode.
+ *
+ * Failed load is logged and reported as cancelled one.
  */
 class TextureWorkerPool {
 public:
   TextureWorkerPool(
+    const vk::PhysicalDevice physicalDevice,
     const vk::Device device,
     const vma::Allocator allocator,
     StagingBuffer &stagingBuffer,
     TransferThread &transferThread,
-    const uint32_t threadCount = std::thread::hardware_concurrency() - 2
-  ) : m_device(device), m_allocator(allocator),
-      m_stagingBuffer(stagingBuffer), m_transferThread(transferThread) {
-    ZoneScoped;
-    for (int i = 0; i < threadCount; ++i) {
-      m_threads.emplace_back([this, i] { threadLoop(i); });
+    JobSystem &jobSystem,
+    TextureCache *textureCache = nullptr
+  ) : m_physicalDevice(physicalDevice), m_device(device), m_allocator(allocator), m_stagingBuffer(stagingBuffer),
+      m_transferThread(transferThread), m_jobSystem(jobSystem), m_textureCache(textureCache) {
+    for (const auto format: {
+           vk::Format::eR8G8B8A8Unorm, vk::Format::eR16G16B16A16Unorm, vk::Format::eR16G16B16A16Sfloat
+         }) {
+      if (!canBlitMipmaps(format))
+        spdlog::warn(std::format("Format {} does not support linear blits, its stb textures get single mip level",
+                                 vk::to_string(format)));
     }
   }
 
   ~TextureWorkerPool() {
+    // Queued loads are dropped, running ones finish
     m_stop = true;
-    for (size_t i = 0; i < m_threads.size(); ++i)
-      m_queue.enqueue(TextureLoadJob{});
-    for (auto &tread: m_threads) {
-      if (tread.joinable())
-        tread.join();
-    }
+    m_jobSystem.wait(m_jobs);
   }
 
   TextureWorkerPool(const TextureWorkerPool &) = delete;
@@ -69,12 +177,54 @@ public:
   TextureWorkerPool &operator=(const TextureWorkerPool &) = delete;
 
   /**
-   * Enqueue a texture loading job
+   * Enqueue a texture loading job, file is mapped and its read-ahead is started right away,
+   * so disk reads of queued textures overlap with decode of earlier ones
    * @param job texture loading job
    */
-  void pushJob(const TextureLoadJob &job) {
+  void pushJob(TextureLoadJob job) {
+    ZoneScoped;
+    if (!job.file) {
+      try {
+        job.file = std::make_shared<MappedFile>(job.filepath);
+        job.file->prefetch();
+      } catch (const std::runtime_error &e) {
+        spdlog::warn(e.what()); // Worker maps it again and reports failure
+      }
+    }
+    {
+      std::lock_guard lock(m_queueMutex);
+      m_queue.push_back(std::move(job));
+    }
+    m_jobSystem.submit([this] { runNextJob(); }, JobPriority::Normal, &m_jobs);
+  }
+
+  /**
+   * Create 1x1 RGBA16F texture of color and push its upload, runs on calling thread
+   * @return texture usable once returned upload is ready
+   */
+  std::pair<std::unique_ptr<Texture>, std::shared_ptr<UploadHandle> > createSolidTexture(
+    const std::array<float, 4> &color,
+    const std::string &name
+  ) {
     ZoneScoped;
-    m_queue.enqueue(job);
+    constexpr auto format = vk::Format::eR16G16B16A16Sfloat; // Half float keeps 0.5 exact
+    auto texture = std::make_unique<Texture>(
+      m_device, m_allocator, 1, 1, 1, format,
+      vk::SampleCountFlagBits::e1,
+      vk::ImageAspectFlagBits::eColor,
+      vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst,
+      true,
+      name
+    );
+    auto upload = m_transferThread.makeHandle();
+    const auto range = vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+    stageImageLevel(
+      texture->getImage(), format, range, 0, 0, 1, 1, upload, true, true, false,
+      [&](void *dst, uint32_t, uint32_t) {
+        convertFloatToHalf(color.data(), static_cast<uint16_t *>(dst), color.size());
+      });
+    upload->seal();
+    return {std::move(texture), std::move(upload)};
   }
 
   /**
@@ -87,128 +237,744 @@ public:
   }
 
 private:
+  vk::PhysicalDevice m_physicalDevice = nullptr;
   vk::Device m_device = nullptr;
   vma::Allocator m_allocator = nullptr;
   StagingBuffer &m_stagingBuffer;
   TransferThread &m_transferThread;
+  JobSystem &m_jobSystem;
+  TextureCache *m_textureCache = nullptr; // Optional
 
-  std::atomic_bool m_stop;
-  std::vector<std::thread> m_threads = {};
-  moodycamel::BlockingConcurrentQueue<TextureLoadJob> m_queue;
+  std::atomic_bool m_stop = false;
+  JobCounter m_jobs; // Submitted loads and transcode helpers
+  TracyLockableN(std::mutex, m_queueMutex, "Texture Queue Mutex");
+  std::vector<TextureLoadJob> m_queue; // Unordered, priorities change while queued
   moodycamel::ConcurrentQueue<TextureLoadDone> m_doneQueue;
 
-  void threadLoop(const uint32_t threadIdx) {
-    tracy::SetThreadNameWithHint(std::format("Texture Worker {}", threadIdx).c_str(), UINT8_MAX);
-    while (true) {
-      TextureLoadJob job{};
-      m_queue.wait_dequeue(job);
-      if (m_stop.load()) {
+  static bool isCancelled(const TextureLoadJob &job) {
+    return job.token && job.token->cancelled.load();
+  }
+
+  /**
+   * Take queued load with highest priority, cancelled one is taken first
+   * @return std::nullopt when pool is stopping
+   */
+  std::optional<TextureLoadJob> popJob() {
+    ZoneScoped;
+    std::lock_guard lock(m_queueMutex);
+    if (m_stop.load() || m_queue.empty())
+      return std::nullopt;
+
+    // Linear scan, queue holds at most a few hundred textures
+    const auto priority = [](const TextureLoadJob &job) {
+      return job.token ? job.token->priority.load(std::memory_order_relaxed) : 0.0f;
+    };
+    auto best = m_queue.begin();
+    for (auto it = m_queue.begin(); it != m_queue.end(); ++it) {
+      if (isCancelled(*it)) {
+        best = it;
         break;
-      } {
-        ZoneScoped;
-        if (!job.filepath.has_extension())
-          throw std::invalid_argument("Job filepath must be contains file extension");
-
-        if (job.filepath.extension() == ".ktx" || job.filepath.extension() == ".ktx2") {
-          auto texture = loadKtxTexture(job);
-          m_doneQueue.enqueue({
-            .job = job,
-            .texture = std::move(texture)
-          });
-        } else {
-          auto texture = loadGenericTexture(job);
-          m_doneQueue.enqueue({
-            .job = job,
-            .texture = std::move(texture)
-          });
-        }
       }
+      if (priority(*it) > priority(*best))
+        best = it;
+    }
+    auto job = std::move(*best);
+    *best = std::move(m_queue.back());
+    m_queue.pop_back();
+    return job;
+  }
+
+  /**
+   * Job body, every pushed load submits one
+   */
+  void runNextJob() {
+    auto job = popJob();
+    if (!job)
+      return;
+    ZoneScoped;
+    if (isCancelled(*job)) {
+      m_doneQueue.enqueue({.job = *job});
+      return;
+    }
+    try {
+      if (!job->filepath.has_extension())
+        throw std::invalid_argument("Job filepath must be contains file extension");
+      if (!job->file)
+        job->file = std::make_shared<MappedFile>(job->filepath);
+
+      auto upload = m_transferThread.makeHandle();
+      auto texture = job->filepath.extension() == ".ktx" || job->filepath.extension() == ".ktx2"
+                       ? loadKtxTexture(*job, *job->file, upload)
+                       : m_textureCache
+                       ? loadCachedTexture(*job, upload)
+                       : loadGenericTexture(*job, upload);
+      upload->seal();
+      const bool staged = texture != nullptr;
+      m_doneQueue.enqueue({
+        .job = *job,
+        .texture = std::move(texture),
+        .upload = staged ? upload : nullptr
+      });
+    } catch (const std::exception &e) {
+      // Reported as cancelled, owner still holds token and tells failure from unload by it
+      spdlog::error(std::format("Failed to load texture {}: {}", job->filepath.string(), e.what()));
+      if (job->token)
+        job->token->cancelled = true;
+      m_doneQueue.enqueue({.job = *job});
+    }
+    m_stagingBuffer.releaseThreadChunk();
+  }
+
+  static vk::DeviceSize blockRowPitch(const vk::Format format, const uint32_t width) {
+    const auto blockWidth = vk::blockExtent(format)[0];
+    return static_cast<vk::DeviceSize>((width + blockWidth - 1) / blockWidth) * vk::blockSize(format);
+  }
+
+  /**
+   * Allocate staging memory for copy into image of format. Region buffer offset must be multiple
+   * of texel block size and of 4, which is not power of two for 3 and 6 byte texels (e.g. R8G8B8),
+   * such allocation is padded and its offset and mapped pointer are moved to aligned start.
+   */
+  StagingBuffer::Allocation allocateImageStaging(const vk::Format format, const vk::DeviceSize size) {
+    const auto alignment = std::lcm<vk::DeviceSize>(vk::blockSize(format), 4);
+    if (std::has_single_bit(alignment))
+      return m_stagingBuffer.allocateBlocking(size, std::max<vk::DeviceSize>(alignment, 256));
+
+    auto alloc = m_stagingBuffer.allocateBlocking(size + alignment - 1);
+    const auto padding = (alignment - alloc.offset % alignment) % alignment;
+    alloc.offset += padding;
+    alloc.mapped = static_cast<std::uint8_t *>(alloc.mapped) + padding;
+    return alloc;
+  }
+
+  /**
+   * Stage image level (single array layer) in chunks of whole texel block rows, every chunk is own upload job
+   * of at most <code>TRANSFER_MAX_JOB_SIZE</code> (or one block row), so large image never fills staging buffer
+   * @param firstPart level is first uploaded part of image, its first chunk transitions range
+   * @param lastPart level is last uploaded part of image, its last chunk makes image usable
+   * @param generateMipmaps blit rest of range from this level after last chunk, see <code>TextureUploadJob</code>
+   * @param fill writes <code>rowCount</code> block rows starting at <code>firstRow</code> into mapped staging memory
+   */
+  template<typename Fill>
+  void stageImageLevel(
+    const vk::Image image,
+    const vk::Format format,
+    const vk::ImageSubresourceRange &range,
+    const uint32_t mipLevel,
+    const uint32_t arrayLayer,
+    const uint32_t width,
+    const uint32_t height,
+    const std::shared_ptr<UploadHandle> &upload,
+    const bool firstPart,
+    const bool lastPart,
+    const bool generateMipmaps,
+    Fill &&fill
+  ) {
+    ZoneScoped;
+    const auto blockHeight = vk::blockExtent(format)[1];
+    const auto rowPitch = blockRowPitch(format, width);
+    const auto blockRows = (height + blockHeight - 1) / blockHeight;
+    const auto rowsPerChunk = static_cast<uint32_t>(std::max<vk::DeviceSize>(TRANSFER_MAX_JOB_SIZE / rowPitch, 1));
+
+    for (uint32_t firstRow = 0; firstRow < blockRows; firstRow += rowsPerChunk) {
+      const auto rowCount = std::min(rowsPerChunk, blockRows - firstRow);
+      auto alloc = allocateImageStaging(format, rowCount * rowPitch);
+      fill(alloc.mapped, firstRow, rowCount);
+
+      const auto y = firstRow * blockHeight;
+      m_transferThread.pushJob(TextureUploadJob{
+        .allocation = alloc,
+        .dstImage = image,
+        .subresourceRange = range,
+        .regions = {
+          vk::BufferImageCopy(
+            alloc.offset, 0, 0,
+            vk::ImageSubresourceLayers(range.aspectMask, mipLevel, arrayLayer, 1),
+            vk::Offset3D(0, static_cast<int32_t>(y), 0),
+            vk::Extent3D(width, std::min(rowCount * blockHeight, height - y), 1))
+        },
+        .handle = upload,
+        .firstChunk = firstPart && firstRow == 0,
+        .lastChunk = lastPart && firstRow + rowCount == blockRows,
+        .generateMipmaps = generateMipmaps,
+        .extent = vk::Extent2D(width, height)
+      });
     }
   }
 
-  std::unique_ptr<Texture> loadGenericTexture(const TextureLoadJob &job) {
+  /**
+   * Device can generate mip chain of format by <code>cmdGenerateMipmaps</code> and sample it linearly
+   */
+  /**
+   * Handle staging failure of texture, call it from catch block: rethrows when no upload job was pushed yet,
+   * otherwise logs error and cancels job token, caller returns texture since pushed jobs still copy into image
+   * and owner releases it once upload is ready
+   */
+  static void abandonStartedUpload(const TextureLoadJob &job, const UploadHandle &upload, const std::exception &e) {
+    if (!upload.hasJobs())
+      throw;
+    spdlog::error(std::format("Failed to load texture {} after its upload started: {}", job.filepath.string(), e.what()));
+    if (job.token)
+      job.token->cancelled = true;
+  }
+
+  [[nodiscard]] bool canBlitMipmaps(const vk::Format format) const {
+    constexpr auto required = vk::FormatFeatureFlagBits::eBlitSrc | vk::FormatFeatureFlagBits::eBlitDst
+                              | vk::FormatFeatureFlagBits::eSampledImageFilterLinear;
+    return (m_physicalDevice.getFormatProperties(format).optimalTilingFeatures & required) == required;
+  }
+
+  /**
+   * Decode image by stb_image and upload its level 0, rest of chain is generated by transfer pipeline.
+   * 8-bit images become RGBA8, 16-bit ones RGBA16 and HDR ones RGBA16F, any channel count
+   * is expanded by <code>PixelConvert.h</code> kernels while copying into staging memory.
+   * Format without linear blit support (RGBA16 unorm is optional) gets level 0 only.
+   * @return texture, also when staging failed after first upload job was pushed (job token is cancelled then)
+   */
+  std::unique_ptr<Texture> loadGenericTexture(const TextureLoadJob &job, const std::shared_ptr<UploadHandle> &upload) {
     ZoneScoped;
+    const auto path = job.filepath.string();
+    const auto *fileData = job.file->data().data();
+    const auto fileSize = static_cast<int>(job.file->size());
+    const bool hdr = stbi_is_hdr_from_memory(fileData, fileSize);
+    const bool wide = !hdr && stbi_is_16_bit_from_memory(fileData, fileSize);
     int width, height, channels;
-    stbi_uc *origPixels; {
+    const auto imageFree = [](void *pixels) { stbi_image_free(pixels); };
+    std::unique_ptr<void, decltype(imageFree)> origPixels(nullptr, imageFree); {
       ZoneScopedN("Texture Loading");
-      origPixels = stbi_load(
-        job.filepath.string().c_str(),
-        &width,
-        &height,
-        &channels,
-        0
-      );
+      // HDR is expanded to RGBA by stb, float conversion is the costly part there
+      origPixels.reset(hdr
+                         ? static_cast<void *>(stbi_loadf_from_memory(
+                           fileData, fileSize, &width, &height, &channels, STBI_rgb_alpha))
+                         : wide
+                         ? static_cast<void *>(stbi_load_16_from_memory(
+                           fileData, fileSize, &width, &height, &channels, 0))
+                         : static_cast<void *>(stbi_load_from_memory(
+                           fileData, fileSize, &width, &height, &channels, 0)));
       if (!origPixels) {
-        throw std::runtime_error("Failed to load texture image: " + job.filepath.string());
+        throw std::runtime_error("Failed to load texture image: " + path);
       }
     }
 
-    const vk::DeviceSize targetSize = width * height * 4;
-    const vk::DeviceSize originalSize = width * height * channels;
-    auto mipLevels = static_cast<uint32_t>(
-      std::floor(std::log2(std::max(width, height))) + 1
-    );
+    const auto format = hdr
+                          ? vk::Format::eR16G16B16A16Sfloat
+                          : wide
+                          ? vk::Format::eR16G16B16A16Unorm
+                          : vk::Format::eR8G8B8A8Unorm;
+    // Level 0 is uploaded, rest of chain is generated by transfer pipeline
+    const bool generateMipmaps = canBlitMipmaps(format);
+    const auto mipLevels = generateMipmaps
+                             ? static_cast<uint32_t>(std::bit_width(static_cast<uint32_t>(std::max(width, height))))
+                             : 1u;
 
     auto texture = std::make_unique<Texture>(
       m_device, m_allocator,
       width, height, mipLevels,
-      vk::Format::eR8G8B8A8Unorm,
+      format,
       vk::SampleCountFlagBits::e1,
       vk::ImageAspectFlagBits::eColor,
       vk::ImageUsageFlagBits::eSampled
       | vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst,
       true,
-      job.filepath.string()
+      path
     );
 
-    auto alloc = m_stagingBuffer.allocateBlocking(targetSize); {
+    if (isCancelled(job))
+      return nullptr;
+
+    const auto range = vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, mipLevels, 0, 1);
+    try {
+      stageImageLevel(
+        texture->getImage(), format, range, 0, 0, width, height, upload, true, true, generateMipmaps,
+        [&](void *dst, const uint32_t firstRow, const uint32_t rowCount) {
+          ZoneScopedN("Staging texture data copy");
+          const auto firstPixel = static_cast<size_t>(firstRow) * width;
+          const auto pixelCount = static_cast<size_t>(rowCount) * width;
+          if (hdr) {
+            const auto *src = static_cast<const float *>(origPixels.get()) + firstPixel * 4;
+            convertFloatToHalf(src, static_cast<uint16_t *>(dst), pixelCount * 4);
+          } else if (wide) {
+            const auto *src = static_cast<const uint16_t *>(origPixels.get()) + firstPixel * channels;
+            convertToRgba16(src, static_cast<uint16_t *>(dst), pixelCount, channels);
+          } else {
+            const auto *src = static_cast<const uint8_t *>(origPixels.get()) + firstPixel * channels;
+            convertToRgba8(src, static_cast<uint8_t *>(dst), pixelCount, channels);
+          }
+        });
+    } catch (const std::exception &e) {
+      abandonStartedUpload(job, *upload, e);
+    }
+
+    return texture;
+  }
+
+  /**
+   * Stage all levels, layers and faces of KTX texture
+   *
+   * KTX2 level holds tightly packed images of every layer and face in copy order, so
+   * one region per level covers all of them. Consecutive levels are packed into one staging
+   * allocation and uploaded by single multi-region job of at most <code>TRANSFER_MAX_JOB_SIZE</code>,
+   * level larger than that is chunked by <code>stageImageLevel</code> per layer.
+   * Every byte is written into staging memory once, directly from source.
+   * Offset and size of every level are checked against source before first job is pushed.
+   */
+  void stageKtxLevels(
+    const KtxImageSource &source,
+    const vk::Image image,
+    const vk::Format format,
+    const uint32_t layerCount,
+    const std::shared_ptr<UploadHandle> &upload
+  ) {
+    ZoneScoped;
+    auto *kTexture = source.texture;
+    const auto mipLevels = kTexture->numLevels;
+    const auto range = vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, mipLevels, 0, layerCount);
+    // Region buffer offset must be multiple of texel block size and of 4, group base is aligned by allocateImageStaging
+    const auto regionAlignment = std::lcm<vk::DeviceSize>(vk::blockSize(format), 4);
+    const auto alignUp = [&](const vk::DeviceSize value) {
+      return (value + regionAlignment - 1) / regionAlignment * regionAlignment;
+    };
+
+    std::vector<uint32_t> group; // Levels of next multi-region job
+    vk::DeviceSize groupSize = 0;
+    bool firstJob = true;
+
+    const auto imageSize = [&](const uint32_t level) {
+      return static_cast<vk::DeviceSize>(ktxTexture_GetImageSize(ktxTexture(kTexture), level));
+    };
+    std::vector<ktx_size_t> levelOffsets(mipLevels); // pData-relative
+    for (uint32_t level = 0; level < mipLevels; ++level) {
+      if (ktxTexture_GetImageOffset(ktxTexture(kTexture), level, 0, 0, &levelOffsets[level]) != KTX_SUCCESS) {
+        throw std::runtime_error(std::format("Failed to get KTX2 image offset (level = {})", level));
+      }
+      source.checkBounds(levelOffsets[level], imageSize(level) * layerCount);
+    }
+
+    const auto flushGroup = [&](const bool last) {
+      if (group.empty())
+        return;
       ZoneScopedN("Staging texture data copy");
-      //memcpy(alloc.mapped, pixels.data(), pixels.size());
-      auto *mappedBytes = static_cast<std::uint8_t *>(alloc.mapped);
-
-      if (channels == 4) {
-        memcpy(alloc.mapped, origPixels, originalSize);
-      } else if (channels == 3) {
-        for (int i = 0; i < width * height; ++i) {
-          mappedBytes[i * 4 + 0] = origPixels[i * 3 + 0];
-          mappedBytes[i * 4 + 1] = origPixels[i * 3 + 1];
-          mappedBytes[i * 4 + 2] = origPixels[i * 3 + 2];
-          mappedBytes[i * 4 + 3] = 255;
+      auto alloc = allocateImageStaging(format, groupSize);
+      std::vector<vk::BufferImageCopy> regions;
+      vk::DeviceSize offset = 0;
+      for (const auto level: group) {
+        const auto levelSize = imageSize(level) * layerCount;
+        source.read(static_cast<std::uint8_t *>(alloc.mapped) + offset, levelOffsets[level], levelSize);
+        regions.emplace_back(
+          alloc.offset + offset, 0, 0,
+          vk::ImageSubresourceLayers(range.aspectMask, level, 0, layerCount),
+          vk::Offset3D(0, 0, 0),
+          vk::Extent3D(std::max(kTexture->baseWidth >> level, 1u), std::max(kTexture->baseHeight >> level, 1u), 1));
+        offset = alignUp(offset + levelSize);
+      }
+      m_transferThread.pushJob(TextureUploadJob{
+        .allocation = alloc,
+        .dstImage = image,
+        .subresourceRange = range,
+        .regions = std::move(regions),
+        .handle = upload,
+        .firstChunk = firstJob,
+        .lastChunk = last
+      });
+      firstJob = false;
+      group.clear();
+      groupSize = 0;
+    };
+
+    for (uint32_t level = 0; level < mipLevels; ++level) {
+      const auto size = imageSize(level);
+      const auto levelSize = size * layerCount;
+      if (levelSize > TRANSFER_MAX_JOB_SIZE) {
+        flushGroup(false);
+        const auto width = std::max(kTexture->baseWidth >> level, 1u);
+        const auto height = std::max(kTexture->baseHeight >> level, 1u);
+        const auto rowPitch = blockRowPitch(format, width);
+        const auto levelData = levelOffsets[level];
+        for (uint32_t layer = 0; layer < layerCount; ++layer) {
+          const auto layerData = levelData + layer * size;
+          stageImageLevel(
+            image, format, range, level, layer, width, height, upload,
+            firstJob, level + 1 == mipLevels && layer + 1 == layerCount, false,
+            [&](void *dst, const uint32_t firstRow, const uint32_t rowCount) {
+              ZoneScopedN("Staging texture data copy");
+              source.read(dst, layerData + firstRow * rowPitch, rowCount * rowPitch);
+            });
+          firstJob = false;
         }
+        continue;
       }
+
+      if (groupSize + levelSize > TRANSFER_MAX_JOB_SIZE)
+        flushGroup(false);
+      group.push_back(level);
+      groupSize = alignUp(groupSize + levelSize);
+    }
+    flushGroup(true);
+  }
+
+  /**
+   * Transcode UASTC texture into BC7 by parts and stage them, idle workers take parts of batch
+   * while this worker transcodes its own ones, so texture is finished by whole pool.
+   *
+   * Every level and layer is cut into bands of whole block rows (UASTC and BC7 blocks are both 4x4 and
+   * 16 bytes, so band of block rows is standalone UASTC image), bands are packed into parts like
+   * in <code>stageKtxLevels</code>. Staged parts are pushed by this worker in finish order,
+   * first pushed one transitions image and last pushed one makes it usable.
+   * Source range of every level is checked before any part is transcoded. Parts staged before
+   * a failure are still pushed (they own staging memory), so image must outlive upload even then.
+   */
+  void transcodeKtxParts(
+    const KtxImageSource &source,
+    const vk::Image image,
+    const vk::Format format,
+    const uint32_t layerCount,
+    const std::shared_ptr<UploadHandle> &upload
+  ) {
+    ZoneScoped;
+    auto *kTexture = source.texture;
+    const auto mipLevels = kTexture->numLevels;
+    auto batch = std::make_shared<KtxTranscodeBatch>();
+    batch->source = source;
+    batch->image = image;
+    batch->format = format;
+    batch->range = vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, mipLevels, 0, layerCount);
+    batch->upload = upload;
+    batch->dfd.assign(kTexture->pDfd, kTexture->pDfd + kTexture->pDfd[0] / sizeof(uint32_t));
+    // Supercompressed texture keeps 0 there, bands are stored raw
+    KHR_DFDSETVAL(batch->dfd.data() + 1, BYTESPLANE0, 16);
+
+    KtxTranscodePart part;
+    for (uint32_t level = 0; level < mipLevels; ++level) {
+      ktx_size_t offset;
+      if (ktxTexture_GetImageOffset(ktxTexture(kTexture), level, 0, 0, &offset) != KTX_SUCCESS) {
+        throw std::runtime_error(std::format("Failed to get KTX2 image offset (level = {})", level));
+      }
+      batch->levelOffsets.push_back(offset);
+
+      const auto width = std::max(kTexture->baseWidth >> level, 1u);
+      const auto height = std::max(kTexture->baseHeight >> level, 1u);
+      const auto rowPitch = blockRowPitch(format, width);
+      const auto blockRows = (height + 3) / 4;
+      const auto rowsPerChunk = static_cast<uint32_t>(std::max<vk::DeviceSize>(TRANSFER_MAX_JOB_SIZE / rowPitch, 1));
+      source.checkBounds(offset, rowPitch * blockRows * layerCount); // UASTC blocks are 16 bytes as BC7 ones
+      for (uint32_t layer = 0; layer < layerCount; ++layer) {
+        for (uint32_t firstRow = 0; firstRow < blockRows; firstRow += rowsPerChunk) {
+          const auto rowCount = std::min(rowsPerChunk, blockRows - firstRow);
+          const auto bandSize = rowCount * rowPitch;
+          if (!part.bands.empty() && part.size + bandSize > TRANSFER_MAX_JOB_SIZE)
+            batch->parts.push_back(std::exchange(part, {}));
+          part.bands.push_back({level, layer, firstRow, rowCount, part.size});
+          part.size += bandSize; // Multiple of 16, keeps region offsets aligned
+        }
+      }
+    }
+    batch->parts.push_back(std::move(part));
+    const auto partCount = static_cast<uint32_t>(batch->parts.size());
+
+    // Helpers end as soon as all parts are claimed, owner always transcodes at least one part.
+    // Normal priority as load itself, render thread helps with High jobs only and must not get a transcode.
+    const auto helpers = std::min(partCount - 1, m_jobSystem.getWorkerCount());
+    for (uint32_t i = 0; i < helpers; ++i) {
+      m_jobSystem.submit([this, batch] {
+        while (transcodeNextPart(*batch)) {
+        }
+        m_stagingBuffer.releaseThreadChunk();
+      }, JobPriority::Normal, &m_jobs);
+    }
+
+    uint32_t pushed = 0;
+    const auto pushStaged = [&] {
+      TextureUploadJob job;
+      while (batch->staged.try_dequeue(job)) {
+        job.firstChunk = pushed == 0;
+        job.lastChunk = ++pushed == partCount;
+        m_transferThread.pushJob(job);
+      }
+    };
+    while (transcodeNextPart(*batch)) {
+      pushStaged();
     } {
-      ZoneScopedN("Free stbi ptr");
-      stbi_image_free(origPixels);
+      ZoneScopedN("Wait transcode parts");
+      for (auto finished = batch->finishedParts.load(); finished < partCount; finished = batch->finishedParts.load()) {
+        pushStaged();
+        batch->finishedParts.wait(finished);
+      }
     }
+    pushStaged();
+    if (batch->error)
+      std::rethrow_exception(batch->error);
+  }
 
-    constexpr auto subresource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, 1);
-    const TextureUploadJob copyJob{
+  /**
+   * Claim next part of batch, transcode it and queue its upload job for batch owner
+   * @return false when batch has no unclaimed parts
+   */
+  bool transcodeNextPart(KtxTranscodeBatch &batch) {
+    const auto index = batch.nextPart++;
+    if (index >= batch.parts.size())
+      return false;
+    try {
+      if (!batch.failed.load())
+        stageTranscodePart(batch, batch.parts[index]);
+    } catch (...) {
+      std::lock_guard lock(batch.errorMutex);
+      if (!batch.error)
+        batch.error = std::current_exception();
+      batch.failed = true;
+    }
+    ++batch.finishedParts;
+    batch.finishedParts.notify_all();
+    return true;
+  }
+
+  void stageTranscodePart(KtxTranscodeBatch &batch, const KtxTranscodePart &part) {
+    ZoneScoped;
+    const auto destroy = [](ktxTexture2 *texture) { ktxTexture_Destroy(ktxTexture(texture)); };
+    std::vector<std::unique_ptr<ktxTexture2, decltype(destroy)> > transcoded;
+    for (const auto &band: part.bands) {
+      const auto file = makeUastcBandFile(batch, band);
+      ktxTexture2 *kBand;
+      if (ktxTexture2_CreateFromMemory(file.data(), file.size(), KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT, &kBand)
+          != KTX_SUCCESS) {
+        throw std::runtime_error(std::format("Failed to load KTX2 band (level = {}, layer = {})", band.level, band.layer));
+      }
+      transcoded.emplace_back(kBand, destroy);
+      ZoneScopedN("Transcoding");
+      if (ktxTexture2_TranscodeBasis(kBand, KTX_TTF_BC7_RGBA, 0) != KTX_SUCCESS
+          || static_cast<vk::Format>(kBand->vkFormat) != batch.format) {
+        throw std::runtime_error(std::format("Failed to transcode KTX2 band (level = {}, layer = {})", band.level, band.layer));
+      }
+    }
+
+    auto alloc = m_stagingBuffer.allocateBlocking(part.size);
+    std::vector<vk::BufferImageCopy> regions;
+    for (size_t i = 0; i < part.bands.size(); ++i) {
+      ZoneScopedN("Staging texture data copy");
+      const auto &band = part.bands[i];
+      const auto *kBand = transcoded[i].get();
+      memcpy(static_cast<std::uint8_t *>(alloc.mapped) + band.offset, kBand->pData, kBand->dataSize);
+      const auto y = band.firstRow * 4;
+      regions.emplace_back(
+        alloc.offset + band.offset, 0, 0,
+        vk::ImageSubresourceLayers(batch.range.aspectMask, band.level, band.layer, 1),
+        vk::Offset3D(0, static_cast<int32_t>(y), 0),
+        vk::Extent3D(kBand->baseWidth, kBand->baseHeight, 1));
+    }
+    batch.staged.enqueue(TextureUploadJob{
       .allocation = alloc,
-      .dstImage = texture->getImage(),
-      .subresourceRange = vk::ImageSubresourceRange(
-        vk::ImageAspectFlagBits::eColor, 0, mipLevels, 0, 1),
-      .region = vk::BufferImageCopy(
-        alloc.offset, 0, 0, subresource,
-        vk::Offset3D(0, 0, 0),
-        vk::Extent3D(width, height, 1)),
+      .dstImage = batch.image,
+      .subresourceRange = batch.range,
+      .regions = std::move(regions),
+      .handle = batch.upload
+    });
+  }
+
+  /**
+   * Build in-memory single-level 2D KTX2 file holding block rows of band, its level data is read from batch source
+   */
+  static std::vector<uint8_t> makeUastcBandFile(const KtxTranscodeBatch &batch, const KtxTranscodeBand &band) {
+    ZoneScoped;
+    const auto *kTexture = batch.source.texture;
+    const auto width = std::max(kTexture->baseWidth >> band.level, 1u);
+    const auto height = std::max(kTexture->baseHeight >> band.level, 1u);
+    const auto rowPitch = static_cast<vk::DeviceSize>((width + 3) / 4) * 16;
+    const auto imageSize = rowPitch * ((height + 3) / 4);
+    const auto dataSize = rowPitch * band.rowCount;
+    const auto dfdSize = static_cast<uint32_t>(batch.dfd.size() * sizeof(uint32_t));
+    // 80 byte header, one level index entry, DFD, then level data aligned to UASTC block size
+    constexpr uint32_t dfdOffset = 80 + 3 * sizeof(uint64_t);
+    const auto dataOffset = static_cast<uint64_t>(dfdOffset + dfdSize + 15) / 16 * 16;
+
+    std::vector<uint8_t> file(dataOffset + dataSize);
+    constexpr uint8_t identifier[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+    const uint32_t header[] = {
+      0, 1, // vkFormat (undefined for Basis), typeSize
+      width, std::min(band.rowCount * 4, height - band.firstRow * 4), 0, // pixelWidth, pixelHeight, pixelDepth
+      0, 1, 1, KTX_SS_NONE, // layerCount, faceCount, levelCount, supercompressionScheme
+      dfdOffset, dfdSize, 0, 0 // DFD and key/value data
+    };
+    const uint64_t index[] = {
+      0, 0, // Supercompression global data
+      dataOffset, dataSize, dataSize // Level 0
     };
-    m_transferThread.pushJob(copyJob);
+    memcpy(file.data(), identifier, sizeof(identifier));
+    memcpy(file.data() + sizeof(identifier), header, sizeof(header));
+    memcpy(file.data() + sizeof(identifier) + sizeof(header), index, sizeof(index));
+    memcpy(file.data() + dfdOffset, batch.dfd.data(), dfdSize);
+    batch.source.read(
+      file.data() + dataOffset,
+      batch.levelOffsets[band.level] + band.layer * imageSize + band.firstRow * rowPitch,
+      dataSize);
+    return file;
+  }
 
-    return texture;
+  /**
+   * Load generic image through texture cache, image is encoded into cache on miss
+   */
+  std::unique_ptr<Texture> loadCachedTexture(const TextureLoadJob &job, const std::shared_ptr<UploadHandle> &upload) {
+    ZoneScoped;
+    const auto content = job.file->data();
+    // Cache encoder takes 8-bit images only
+    const auto size = static_cast<int>(content.size());
+    if (stbi_is_hdr_from_memory(content.data(), size) || stbi_is_16_bit_from_memory(content.data(), size))
+      return loadGenericTexture(job, upload);
+    const auto key = TextureCache::makeKey(content, job.kind);
+    if (const auto cached = m_textureCache->find(key)) {
+      try {
+        const MappedFile entry(*cached);
+        return loadKtxTexture(job, entry, upload);
+      } catch (const std::runtime_error &e) {
+        spdlog::warn(std::format("Cached texture {} failed to load: {}", job.filepath.string(), e.what()));
+        m_textureCache->invalidate(key);
+      }
+    }
+    if (isCancelled(job))
+      return nullptr;
+
+    spdlog::info(std::format("Encode texture {} into cache", job.filepath.string()));
+    auto *kTexture = encodeTexture(job, content);
+    m_textureCache->store(key, kTexture);
+    return uploadKtxTexture(job, kTexture, upload);
+  }
+
+  /**
+   * Decode image, build its mip chain by box filter and encode it into UASTC,
+   * then transcode into BC7 (color) or BC5 (normal map XY)
+   */
+  static ktxTexture2 *encodeTexture(const TextureLoadJob &job, const std::span<const uint8_t> content) {
+    ZoneScoped;
+    int width, height, channels;
+    stbi_uc *pixels; {
+      ZoneScopedN("Texture Loading");
+      pixels = stbi_load_from_memory(
+        content.data(), static_cast<int>(content.size()), &width, &height, &channels, STBI_rgb_alpha);
+      if (!pixels) {
+        throw std::runtime_error("Failed to load texture image: " + job.filepath.string());
+      }
+    }
+
+    const auto mipLevels = static_cast<uint32_t>(std::bit_width(static_cast<uint32_t>(std::max(width, height))));
+    auto createInfo = ktxTextureCreateInfo{};
+    createInfo.vkFormat = static_cast<ktx_uint32_t>(vk::Format::eR8G8B8A8Unorm);
+    createInfo.baseWidth = width;
+    createInfo.baseHeight = height;
+    createInfo.baseDepth = 1;
+    createInfo.numDimensions = 2;
+    createInfo.numLevels = mipLevels;
+    createInfo.numLayers = 1;
+    createInfo.numFaces = 1;
+    createInfo.isArray = KTX_FALSE;
+    createInfo.generateMipmaps = KTX_FALSE;
+    ktxTexture2 *kTexture;
+    if (ktxTexture2_Create(&createInfo, KTX_TEXTURE_CREATE_ALLOC_STORAGE, &kTexture) != KTX_SUCCESS) {
+      stbi_image_free(pixels);
+      throw std::runtime_error("Failed to create KTX2 texture for " + job.filepath.string());
+    }
+
+    {
+      ZoneScopedN("Build mip chain");
+      auto level = std::vector<uint8_t>(pixels, pixels + static_cast<size_t>(width) * height * 4);
+      stbi_image_free(pixels);
+      auto levelWidth = static_cast<uint32_t>(width);
+      auto levelHeight = static_cast<uint32_t>(height);
+      for (uint32_t mip = 0; mip < mipLevels; ++mip) {
+        ktxTexture_SetImageFromMemory(ktxTexture(kTexture), mip, 0, 0, level.data(), level.size());
+        if (mip + 1 < mipLevels) {
+          level = downsampleRgba8(level, levelWidth, levelHeight);
+          levelWidth = std::max(levelWidth / 2, 1u);
+          levelHeight = std::max(levelHeight / 2, 1u);
+        }
+      }
+    }
+
+    const bool normalMap = job.kind == TextureKind::Normal;
+    auto params = ktxBasisParams{};
+    params.structSize = sizeof(params);
+    params.uastc = KTX_TRUE;
+    params.uastcFlags = KTX_PACK_UASTC_LEVEL_FASTER;
+    params.threadCount = 1; // Worker pool already runs one encode per thread
+    if (normalMap) {
+      // X in RGB and Y in alpha, so BC5 gets X in red and Y in green
+      params.inputSwizzle[0] = 'r';
+      params.inputSwizzle[1] = 'r';
+      params.inputSwizzle[2] = 'r';
+      params.inputSwizzle[3] = 'g';
+    }
+    {
+      ZoneScopedN("Encoding");
+      if (ktxTexture2_CompressBasisEx(kTexture, &params) != KTX_SUCCESS) {
+        ktxTexture_Destroy(ktxTexture(kTexture));
+        throw std::runtime_error("Failed to encode texture " + job.filepath.string());
+      }
+    }
+    {
+      ZoneScopedN("Transcoding");
+      if (ktxTexture2_TranscodeBasis(kTexture, normalMap ? KTX_TTF_BC5_RG : KTX_TTF_BC7_RGBA, 0) != KTX_SUCCESS) {
+        ktxTexture_Destroy(ktxTexture(kTexture));
+        throw std::runtime_error("Failed to transcode texture " + job.filepath.string());
+      }
+    }
+    return kTexture;
   }
 
-  std::unique_ptr<Texture> loadKtxTexture(const TextureLoadJob &job) {
+  /**
+   * 2x2 box filter of RGBA8 image, odd edge texels are repeated
+   */
+  static std::vector<uint8_t> downsampleRgba8(const std::vector<uint8_t> &src, const uint32_t width,
+                                              const uint32_t height) {
+    const auto dstWidth = std::max(width / 2, 1u);
+    const auto dstHeight = std::max(height / 2, 1u);
+    std::vector<uint8_t> dst(static_cast<size_t>(dstWidth) * dstHeight * 4);
+    for (uint32_t y = 0; y < dstHeight; ++y) {
+      const auto y0 = std::min(y * 2, height - 1);
+      const auto y1 = std::min(y * 2 + 1, height - 1);
+      for (uint32_t x = 0; x < dstWidth; ++x) {
+        const auto x0 = std::min(x * 2, width - 1);
+        const auto x1 = std::min(x * 2 + 1, width - 1);
+        for (uint32_t c = 0; c < 4; ++c) {
+          const auto texel = [&](const uint32_t tx, const uint32_t ty) {
+            return static_cast<uint32_t>(src[(static_cast<size_t>(ty) * width + tx) * 4 + c]);
+          };
+          const auto sum = texel(x0, y0) + texel(x1, y0) + texel(x0, y1) + texel(x1, y1);
+          dst[(static_cast<size_t>(y) * dstWidth + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+        }
+      }
+    }
+    return dst;
+  }
+
+  std::unique_ptr<Texture> loadKtxTexture(
+    const TextureLoadJob &job,
+    const MappedFile &file,
+    const std::shared_ptr<UploadHandle> &upload
+  ) {
     ZoneScoped;
     ktxTexture2 *kTexture; {
       ZoneScopedN("Load KTX2 Texture");
-      auto result = ktxTexture2_CreateFromNamedFile(
-        job.filepath.string().c_str(), KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT, &kTexture);
+      // Header and level index only, plain block data is copied straight into staging memory
+      auto result = ktxTexture2_CreateFromMemory(
+        file.data().data(), file.size(), KTX_TEXTURE_CREATE_NO_FLAGS, &kTexture);
 
       if (result != KTX_SUCCESS) {
         throw std::runtime_error("Failed to load KTX: " + job.filepath.string());
       }
     }
-    if (ktxTexture2_NeedsTranscoding(kTexture)) {
+    const bool transcode = ktxTexture2_NeedsTranscoding(kTexture);
+    const auto baseSize = static_cast<vk::DeviceSize>((kTexture->baseWidth + 3) / 4) * ((kTexture->baseHeight + 3) / 4)
+                          * 16 * kTexture->numLayers * kTexture->numFaces;
+    const bool byParts = transcode && ktxTexture2_GetColorModel_e(kTexture) == KHR_DF_MODEL_UASTC
+                         && kTexture->baseDepth == 1 && baseSize >= KTX_PARALLEL_TRANSCODE_MIN_SIZE;
+    if ((!transcode || byParts) && kTexture->supercompressionScheme == KTX_SS_NONE)
+      return uploadKtxTexture(job, kTexture, upload, file.data(), byParts);
+
+    {
+      ZoneScopedN("Load KTX2 Image Data");
+      if (ktxTexture_LoadImageData(ktxTexture(kTexture), nullptr, 0) != KTX_SUCCESS) {
+        ktxTexture_Destroy(ktxTexture(kTexture));
+        throw std::runtime_error("Failed to load KTX image data: " + job.filepath.string());
+      }
+    }
+    if (transcode && !byParts) {
       ZoneScopedN("Transcoding");
       auto result = ktxTexture2_TranscodeBasis(
         kTexture,
@@ -219,50 +985,77 @@ private:
         throw std::runtime_error("Failed to transcode KTX2 texture");
       }
     }
+    return uploadKtxTexture(job, kTexture, upload, {}, byParts);
+  }
+
+  /**
+   * Create image for KTX texture and stage all its data, takes ownership of kTexture
+   * @param fileData read image data from this mapped KTX2 file instead of loaded <code>pData</code>,
+   * data must not be supercompressed
+   * @param transcodeByParts texture is UASTC, transcode it into BC7 by parts, see <code>KtxTranscodeBatch</code>
+   * @return texture, also when staging failed after first upload job was pushed (job token is cancelled then)
+   */
+  std::unique_ptr<Texture> uploadKtxTexture(
+    const TextureLoadJob &job,
+    ktxTexture2 *kTexture,
+    const std::shared_ptr<UploadHandle> &upload,
+    const std::span<const uint8_t> fileData = {},
+    const bool transcodeByParts = false
+  ) {
+    ZoneScoped;
+    if (kTexture->baseDepth > 1) {
+      ktxTexture_Destroy(ktxTexture(kTexture));
+      throw std::runtime_error("3D KTX textures are not supported: " + job.filepath.string());
+    }
 
-    auto width = kTexture->baseWidth;
-    auto height = kTexture->baseHeight;
-    auto mipLevels = kTexture->numLevels;
+    const auto width = kTexture->baseWidth;
+    const auto height = kTexture->baseHeight;
+    const auto mipLevels = kTexture->numLevels;
+    const auto layerCount = kTexture->numLayers * kTexture->numFaces;
+    const auto format = !transcodeByParts
+                          ? static_cast<vk::Format>(kTexture->vkFormat)
+                          : ktxTexture2_GetOETF_e(kTexture) == KHR_DF_TRANSFER_SRGB
+                          ? vk::Format::eBc7SrgbBlock
+                          : vk::Format::eBc7UnormBlock;
     auto texture = std::make_unique<Texture>(
       m_device, m_allocator,
       width, height, mipLevels,
-      static_cast<vk::Format>(kTexture->vkFormat),
+      format,
       vk::SampleCountFlagBits::e1,
       vk::ImageAspectFlagBits::eColor,
       vk::ImageUsageFlagBits::eSampled
       | vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst,
       true,
-      job.filepath.string()
+      job.filepath.string(),
+      layerCount,
+      kTexture->isCubemap
     );
 
-    ktx_size_t offset;
-    auto result = ktxTexture_GetImageOffset(
-      ktxTexture(kTexture), 0, 0, 0, &offset
-    );
-    if (result != KTX_SUCCESS) {
+    if (isCancelled(job)) {
       ktxTexture_Destroy(ktxTexture(kTexture));
-      throw std::runtime_error("Failed to get KTX2 image offset");
+      return nullptr;
     }
 
-    size_t size = ktxTexture_GetImageSize(ktxTexture(kTexture), 0);
-    auto alloc = m_stagingBuffer.allocateBlocking(size); {
-      ZoneScopedN("Staging texture data copy");
-      memcpy(alloc.mapped, kTexture->pData + offset, size);
+    try {
+      auto source = KtxImageSource{.texture = kTexture};
+      if (!fileData.empty()) {
+        // KTX2 level index follows 80 byte header, each entry is byteOffset, byteLength, uncompressedByteLength
+        const auto indexOffset = 80 + static_cast<size_t>(mipLevels - 1) * 3 * sizeof(uint64_t);
+        if (indexOffset + sizeof(uint64_t) > fileData.size())
+          throw std::runtime_error("Failed to read KTX2 level index: " + job.filepath.string());
+        memcpy(&source.dataFileOffset, fileData.data() + indexOffset, sizeof(uint64_t));
+        source.file = fileData;
+      }
+      if (transcodeByParts)
+        transcodeKtxParts(source, texture->getImage(), format, layerCount, upload);
+      else
+        stageKtxLevels(source, texture->getImage(), format, layerCount, upload);
+    } catch (const std::exception &e) {
+      ktxTexture_Destroy(ktxTexture(kTexture));
+      abandonStartedUpload(job, *upload, e);
+      return texture;
     }
 
-    constexpr auto subresource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, 1);
-    const TextureUploadJob copyJob{
-      .allocation = alloc,
-      .dstImage = texture->getImage(),
-      .subresourceRange = vk::ImageSubresourceRange(
-        vk::ImageAspectFlagBits::eColor, 0, mipLevels, 0, 1),
-      .region = vk::BufferImageCopy(
-        alloc.offset, 0, 0, subresource,
-        vk::Offset3D(0, 0, 0),
-        vk::Extent3D(width, height, 1)),
-    };
-    m_transferThread.pushJob(copyJob);
-
     ktxTexture_Destroy(ktxTexture(kTexture));
 
     return texture;
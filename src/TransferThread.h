@@ -1,30 +1,71 @@
 #ifndef TRANSFERTHREAD_H
 #define TRANSFERTHREAD_H
 
+#include <algorithm>
 #include <deque>
+#include <format>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <variant>
 #include <vulkan/vulkan.hpp>
 #include "concurrentqueue/blockingconcurrentqueue.h"
 
+#include "Async.h"
 #include "StagingBuffer.h"
+#include "UploadHandle.h"
 #include "utils.cpp"
 
-// TODO: More universal job struct to copy into buffer
+/**
+ * Copy of one region into image, image uploaded in several jobs transitions
+ * on its first job and becomes usable after its last one (jobs are recorded in push order).
+ * With <code>generateMipmaps</code> only base level of range is copied, the rest of chain
+ * is blitted from it after last job, dstImageLayout must be ShaderReadOnlyOptimal then.
+ */
 struct TextureUploadJob {
   StagingBuffer::Allocation allocation;
   vk::Image dstImage;
   vk::ImageSubresourceRange subresourceRange;
-  vk::BufferImageCopy region;
+  std::vector<vk::BufferImageCopy> regions; // bufferOffset is relative to staging buffer start
   vk::ImageLayout srcImageLayout = vk::ImageLayout::eUndefined;
   vk::ImageLayout dstImageLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+  std::shared_ptr<UploadHandle> handle; // Optional
+  bool firstChunk = true; // Transition subresourceRange from srcImageLayout to TransferDst before copy
+  bool lastChunk = true; // Transition (or release) subresourceRange into dstImageLayout after copy
+  bool generateMipmaps = false; // Read on last chunk
+  vk::Extent2D extent = {}; // Base level size, required by generateMipmaps
 };
 
+struct BufferUploadJob {
+  StagingBuffer::Allocation allocation;
+  vk::Buffer dstBuffer;
+  vk::BufferCopy region; // srcOffset is relative to staging buffer start
+  std::shared_ptr<UploadHandle> handle; // Optional
+};
+
+using TransferJob = std::variant<TextureUploadJob, BufferUploadJob>;
+
+#define TRANSFER_RING_SIZE 4
+#define TRANSFER_MAX_JOB_SIZE (2 * 1024 * 1024) // Larger uploads are split, so one resource never fills staging buffer
+
 /**
- * Handles asynchronous GPU uploads of staging buffer allocations to textures
+ * Handles asynchronous GPU uploads of staging buffer allocations to textures and buffers
  * - Pulls completed jobs from job queues (e.g., future texture loaders)
- * - Records copy commands into a command buffer.
+ * - Records copy commands into next command buffer of ring
  * - Submits command buffer to a transfer-capable queue
- * - Uses semaphore signaling to track GPU completion of each allocation
+ * - Uses staging timeline semaphore to track GPU completion of each batch and allocation,
+ * up to <code>TRANSFER_RING_SIZE</code> batches are in flight, thread blocks only when ring is full
  * - Polls staging buffer to reclaim memory after GPU finishes processing
+ * - When transfer queue family differs from destination (graphics) family, batch releases
+ * ownership of uploaded ranges and images, acquire half is recorded on destination queue by
+ * <code>TransferThread::cmdAcquireOwnership</code> before first use
+ * - Images uploaded with <code>TextureUploadJob::generateMipmaps</code> get their mip chains
+ * by batched blits of all such images of a batch. Blit needs graphics queue, so with
+ * ownership transfer chains are generated on destination queue right after acquire.
+ * - Optional per-frame byte budget (see <code>TransferThread::setFrameBudget</code>),
+ * jobs over budget wait for next <code>TransferThread::beginFrame</code> in push order
+ * - Coroutines await upload completion (see <code>TransferThread::uploaded</code>), thread checks
+ * their handles after every reclaim and resumes ready ones on <code>JobSystem</code>
  */
 class TransferThread {
 public:
@@ -32,16 +73,23 @@ public:
     const vk::Device device,
     const vk::Queue transferQueue,
     const uint32_t transferQueueFamilyIndex,
+    const uint32_t dstQueueFamilyIndex,
     StagingBuffer &stagingBuffer
-  ): m_device(device), m_transferQueue(transferQueue), m_stagingBuffer(stagingBuffer), m_stop(false) {
+  ): m_device(device), m_transferQueue(transferQueue), m_stagingBuffer(stagingBuffer),
+     m_srcFamily(transferQueueFamilyIndex), m_dstFamily(dstQueueFamilyIndex),
+     m_ownershipTransfer(transferQueueFamilyIndex != dstQueueFamilyIndex), m_stop(false) {
     ZoneScoped;
     const auto transferPoolInfo = vk::CommandPoolCreateInfo(
       vk::CommandPoolCreateFlagBits::eResetCommandBuffer, transferQueueFamilyIndex);
     m_commandPool = m_device.createCommandPoolUnique(transferPoolInfo);
     const auto transferCmdInfo = vk::CommandBufferAllocateInfo(
-      m_commandPool.get(), vk::CommandBufferLevel::ePrimary, 1);
-    m_cmdBuff = std::move(m_device.allocateCommandBuffersUnique(transferCmdInfo).front());
-    m_submitFence = m_device.createFenceUnique({});
+      m_commandPool.get(), vk::CommandBufferLevel::ePrimary, TRANSFER_RING_SIZE);
+    auto cmdBuffers = m_device.allocateCommandBuffersUnique(transferCmdInfo);
+    m_ring.resize(TRANSFER_RING_SIZE);
+    for (uint32_t i = 0; i < TRANSFER_RING_SIZE; ++i) {
+      m_ring[i].cmd = std::move(cmdBuffers[i]);
+      setObjectName(m_device, m_ring[i].cmd.get(), std::format("Transfer command buffer {}", i));
+    }
 
     m_thread = std::thread(&TransferThread::threadLoop, this);
   }
@@ -50,73 +98,449 @@ public:
     m_stop = true;
     if (m_thread.joinable())
       m_thread.join();
+
+    // Command buffers of ring may still execute
+    if (m_lastSubmittedValue > 0) {
+      const auto waitInfo = vk::SemaphoreWaitInfo({}, m_stagingBuffer.getTimeline(), m_lastSubmittedValue);
+      auto _ = m_device.waitSemaphores(waitInfo, UINT64_MAX);
+    }
   }
 
   TransferThread(const TransferThread &) = delete;
 
   TransferThread &operator=(const TransferThread &) = delete;
 
-  void pushJob(const TextureUploadJob &job) {
+  void pushJob(const TransferJob &job) {
     ZoneScoped;
+    if (const auto &handle = std::visit([](const auto &j) { return j.handle; }, job))
+      handle->addJob();
+    ++m_pushedJobs;
     m_queue.enqueue(job);
   }
 
+  /**
+   * Record acquire half of queue family ownership transfers of batches finished on GPU
+   * @remark Render thread only. Must be recorded into destination queue command buffer before any resource
+   * of upload reported ready (see <code>UploadHandle::isReady</code>) is used, submit must wait for returned value.
+   * @return staging timeline value to wait, 0 when nothing was acquired
+   */
+  uint64_t cmdAcquireOwnership(const vk::CommandBuffer cmd) {
+    if (!m_ownershipTransfer)
+      return 0;
+
+    ZoneScoped;
+    const auto completed = m_device.getSemaphoreCounterValue(m_stagingBuffer.getTimeline());
+    std::vector<vk::BufferMemoryBarrier2> bufferBarriers;
+    std::vector<vk::ImageMemoryBarrier2> imageBarriers;
+    std::vector<MipmapTarget> mipmaps;
+    uint64_t waitValue = 0; {
+      std::lock_guard lock(m_acquireMutex);
+      while (!m_pendingAcquires.empty() && m_pendingAcquires.front().timelineValue <= completed) {
+        auto &acquire = m_pendingAcquires.front();
+        bufferBarriers.insert(bufferBarriers.end(), acquire.buffers.begin(), acquire.buffers.end());
+        imageBarriers.insert(imageBarriers.end(), acquire.images.begin(), acquire.images.end());
+        mipmaps.insert(mipmaps.end(), acquire.mipmaps.begin(), acquire.mipmaps.end());
+        waitValue = acquire.timelineValue;
+        m_pendingAcquires.pop_front();
+      }
+    }
+
+    if (waitValue > 0)
+      cmd.pipelineBarrier2(vk::DependencyInfo({}, {}, bufferBarriers, imageBarriers));
+    if (!mipmaps.empty())
+      cmdGenerateMipmaps(cmd, mipmaps);
+    return waitValue;
+  }
+
+  /**
+   * Drop acquires of image which are not recorded yet, call it before destroying image of abandoned upload
+   * (e.g. cancelled texture), so <code>TransferThread::cmdAcquireOwnership</code> never records barrier of freed image
+   * @remark Render thread only. Upload of image must be ready, so its acquire is already queued.
+   * @return true when acquire of image may be recorded into frame which is still in flight,
+   * caller keeps image until destination queue finished such frames
+   */
+  bool forgetImage(const vk::Image image) {
+    if (!m_ownershipTransfer)
+      return false;
+
+    ZoneScoped;
+    bool pending = false;
+    std::lock_guard lock(m_acquireMutex);
+    for (auto &acquire: m_pendingAcquires) {
+      pending |= std::erase_if(acquire.images, [&](const vk::ImageMemoryBarrier2 &barrier) {
+        return barrier.image == image;
+      }) > 0;
+      std::erase_if(acquire.mipmaps, [&](const MipmapTarget &target) { return target.image == image; });
+    }
+    return !pending;
+  }
+
+  [[nodiscard]] vk::Semaphore getTimeline() const { return m_stagingBuffer.getTimeline(); }
+
+  /**
+   * End staging burst of calling thread, see <code>StagingBuffer::releaseThreadChunk</code>
+   */
+  void releaseStagingChunk() const { m_stagingBuffer.releaseThreadChunk(); }
+
+  [[nodiscard]] std::shared_ptr<UploadHandle> makeHandle() const {
+    return std::make_shared<UploadHandle>(m_device, m_stagingBuffer.getTimeline());
+  }
+
+  /**
+   * Copy data into staging buffer and push jobs uploading it into dstBuffer,
+   * data is split into jobs of at most <code>TRANSFER_MAX_JOB_SIZE</code> bytes
+   * @remark Blocks while staging buffer has no free space
+   * @param dstBuffer destination, must have TransferDst usage
+   * @param data source data
+   * @param size data size in bytes
+   * @param handle optional completion handle, ready after last job
+   * @param dstOffset offset in dstBuffer
+   */
+  void uploadBuffer(
+    const vk::Buffer dstBuffer,
+    const void *data,
+    const vk::DeviceSize size,
+    const std::shared_ptr<UploadHandle> &handle = nullptr,
+    const vk::DeviceSize dstOffset = 0
+  ) {
+    ZoneScoped;
+    const auto bytes = static_cast<const char *>(data);
+    for (vk::DeviceSize offset = 0; offset < size; offset += TRANSFER_MAX_JOB_SIZE) {
+      const auto chunkSize = std::min<vk::DeviceSize>(TRANSFER_MAX_JOB_SIZE, size - offset);
+      auto allocation = m_stagingBuffer.allocateBlocking(chunkSize, 16);
+      memcpy(allocation.mapped, bytes + offset, chunkSize);
+
+      pushJob(BufferUploadJob{
+        .allocation = allocation,
+        .dstBuffer = dstBuffer,
+        .region = vk::BufferCopy(allocation.offset, dstOffset + offset, chunkSize),
+        .handle = handle
+      });
+    }
+  }
+
+  /**
+   * Upload data into dstBuffer and resume once it is ready on GPU, e.g.
+   * <code>co_await transferThread.uploadBufferAsync(jobSystem, buffer, data, size)</code>
+   * @remark data is copied when task starts, so it must stay valid until task is awaited.
+   * Staging copy blocks while staging buffer has no free space.
+   */
+  Task<> uploadBufferAsync(
+    JobSystem &jobSystem,
+    const vk::Buffer dstBuffer,
+    const void *data,
+    const vk::DeviceSize size,
+    const vk::DeviceSize dstOffset = 0,
+    const JobPriority priority = JobPriority::Normal
+  ) {
+    const auto handle = makeHandle();
+    uploadBuffer(dstBuffer, data, size, handle, dstOffset);
+    handle->seal();
+    releaseStagingChunk(); // Task may resume on another worker
+    co_await uploaded(jobSystem, handle, priority);
+  }
+
+  /**
+   * Await upload completion, coroutine resumes as job of given priority
+   * @remark Handle must be sealed, otherwise it never gets ready
+   */
+  CompletionAwaiter uploaded(
+    JobSystem &jobSystem,
+    std::shared_ptr<UploadHandle> handle,
+    const JobPriority priority = JobPriority::Normal
+  ) {
+    return {jobSystem, priority, [this, handle = std::move(handle)](CompletionAwaiter::Callback callback) {
+      whenReady(handle, std::move(callback));
+    }};
+  }
+
+  /**
+   * Call fn(true) from transfer thread once upload is ready, immediately when it already is
+   * @remark fn must be short (e.g. submit job), waiters left on destruction are dropped,
+   * so owners must finish their tasks before transfer thread is destroyed
+   */
+  void whenReady(const std::shared_ptr<UploadHandle> &handle, std::function<void(bool)> fn) {
+    if (handle->isReady()) {
+      fn(true);
+      return;
+    }
+    std::lock_guard lock(m_waitersMutex);
+    m_readyWaiters.push_back({handle, std::move(fn)});
+  }
+
+  /**
+   * Limit bytes submitted between two <code>TransferThread::beginFrame</code> calls
+   * @param bytes budget, 0 disables limit. Single job larger than budget is submitted
+   * when frame budget is not yet exhausted, so it never stalls.
+   */
+  void setFrameBudget(const uint64_t bytes) {
+    m_frameBudget = bytes;
+    m_budgetRemaining = static_cast<int64_t>(bytes);
+  }
+
+  /**
+   * Refill upload budget, called once per frame by render thread
+   */
+  void beginFrame() {
+    m_budgetRemaining = static_cast<int64_t>(m_frameBudget.load());
+  }
+
+  /**
+   * Block calling thread until every pushed job is submitted and finished on GPU
+   * @remark With frame budget set render thread must keep calling <code>TransferThread::beginFrame</code>
+   */
+  void waitIdle() const {
+    ZoneScoped;
+    while (m_completedJobs.load() < m_pushedJobs.load()) {
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+  }
+
 private:
+  struct InFlightBatch {
+    vk::UniqueCommandBuffer cmd;
+    uint64_t timelineValue = 0; // Signaled by submit of this batch
+    size_t jobCount = 0; // 0 when slot is free
+  };
+
+  struct ReadyWaiter {
+    std::shared_ptr<UploadHandle> handle;
+    std::function<void(bool)> fn;
+  };
+
+  struct PendingAcquire {
+    uint64_t timelineValue = 0; // Release batch value
+    std::vector<vk::BufferMemoryBarrier2> buffers;
+    std::vector<vk::ImageMemoryBarrier2> images;
+    std::vector<MipmapTarget> mipmaps; // Acquired in TransferDstOptimal, generated after acquire
+  };
+
   vk::Device m_device;
   vk::Queue m_transferQueue;
   StagingBuffer &m_stagingBuffer;
+  uint32_t m_srcFamily;
+  uint32_t m_dstFamily;
+  bool m_ownershipTransfer; // Transfer queue family is not destination one
+  TracyLockableN(std::mutex, m_acquireMutex, "Transfer Acquire Mutex");
+  std::deque<PendingAcquire> m_pendingAcquires; // In submit order
   vk::UniqueCommandPool m_commandPool;
-  vk::UniqueCommandBuffer m_cmdBuff;
-  vk::UniqueFence m_submitFence;
+  std::vector<InFlightBatch> m_ring; // Transfer thread only
+  uint32_t m_ringHead = 0; // Next slot to record
+  uint64_t m_lastSubmittedValue = 0;
 
-  moodycamel::BlockingConcurrentQueue<TextureUploadJob> m_queue;
+  moodycamel::BlockingConcurrentQueue<TransferJob> m_queue;
   std::thread m_thread;
   std::atomic_bool m_stop;
+  std::atomic_uint64_t m_pushedJobs = 0;
+  std::atomic_uint64_t m_completedJobs = 0;
+  std::deque<TransferJob> m_deferred; // Transfer thread only, dequeued jobs waiting for budget
+  std::atomic_uint64_t m_frameBudget = 0;
+  std::atomic_int64_t m_budgetRemaining = 0;
 
   std::chrono::microseconds m_maxBatchWait = std::chrono::microseconds(2000);
+  TracyLockableN(std::mutex, m_waitersMutex, "Transfer Waiters Mutex");
+  std::vector<ReadyWaiter> m_readyWaiters;
 
   void threadLoop() {
     tracy::SetThreadName("VK Transfer Thread");
     while (!m_stop.load()) {
-      if (TextureUploadJob firstJob{}; m_queue.wait_dequeue_timed(firstJob, m_maxBatchWait)) {
-        ZoneScoped;
-        std::deque<TextureUploadJob> batch;
-        batch.push_back(firstJob);
+      // Don't spin on deferred jobs while budget is exhausted
+      if (TransferJob firstJob{};
+        (m_deferred.empty() || !hasBudget()) && m_queue.wait_dequeue_timed(firstJob, m_maxBatchWait)) {
+        m_deferred.push_back(std::move(firstJob));
+      }
 
-        TextureUploadJob nextJob{};
-        while (m_queue.try_dequeue(nextJob)) {
-          batch.push_back(nextJob);
-        }
+      TransferJob nextJob{};
+      while (m_queue.try_dequeue(nextJob)) {
+        m_deferred.push_back(std::move(nextJob));
+      }
 
-        if (!batch.empty()) {
-          recordAndSubmitBatch(batch);
-        }
+      std::deque<TransferJob> batch;
+      while (!m_deferred.empty() && consumeBudget(jobSize(m_deferred.front()))) {
+        batch.push_back(std::move(m_deferred.front()));
+        m_deferred.pop_front();
+      }
+
+      if (!batch.empty()) {
+        ZoneScoped;
+        recordAndSubmitBatch(batch);
       }
+      reclaimCompleted();
+      notifyReadyWaiters();
     }
   }
 
-  void recordAndSubmitBatch(std::deque<TextureUploadJob> &batch) {
+  /**
+   * Call waiters whose uploads are ready on GPU, never blocks
+   */
+  void notifyReadyWaiters() {
+    std::vector<ReadyWaiter> ready; {
+      std::lock_guard lock(m_waitersMutex);
+      if (m_readyWaiters.empty())
+        return;
+      const auto firstReady = std::partition(m_readyWaiters.begin(), m_readyWaiters.end(),
+                                             [](const ReadyWaiter &waiter) { return !waiter.handle->isReady(); });
+      std::move(firstReady, m_readyWaiters.end(), std::back_inserter(ready));
+      m_readyWaiters.erase(firstReady, m_readyWaiters.end());
+    }
+    if (ready.empty())
+      return;
+
     ZoneScoped;
-    m_device.resetFences(*m_submitFence);
-    m_cmdBuff->reset();
-    m_cmdBuff->begin({vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+    for (const auto &waiter: ready)
+      waiter.fn(true);
+  }
 
-    for (auto &job: batch) {
+  static vk::DeviceSize jobSize(const TransferJob &job) {
+    return std::visit([](const auto &j) { return j.allocation.size; }, job);
+  }
+
+  [[nodiscard]] bool hasBudget() const {
+    return m_frameBudget.load() == 0 || m_budgetRemaining.load() > 0;
+  }
+
+  /**
+   * Take job bytes from frame budget, last job may overdraw it
+   * @return false when budget is exhausted and job must wait for next frame
+   */
+  bool consumeBudget(const vk::DeviceSize size) {
+    if (m_frameBudget.load() == 0)
+      return true;
+    if (m_budgetRemaining.load() <= 0)
+      return false;
+    m_budgetRemaining -= static_cast<int64_t>(size);
+    return true;
+  }
+
+  /**
+   * Release ring slots and staging ranges of batches finished on GPU, never blocks
+   */
+  void reclaimCompleted() {
+    ZoneScoped;
+    const auto completed = m_device.getSemaphoreCounterValue(m_stagingBuffer.getTimeline());
+    bool reclaimed = false;
+    for (auto &slot: m_ring) {
+      if (slot.jobCount == 0 || slot.timelineValue > completed)
+        continue;
+      m_completedJobs += slot.jobCount;
+      slot.jobCount = 0;
+      reclaimed = true;
+    }
+    if (reclaimed)
+      m_stagingBuffer.pollReclaimed();
+  }
+
+  /**
+   * Get next ring slot, waits for its previous batch only when all slots are in flight
+   */
+  InFlightBatch &acquireSlot() {
+    ZoneScoped;
+    auto &slot = m_ring[m_ringHead];
+    m_ringHead = (m_ringHead + 1) % TRANSFER_RING_SIZE;
+    if (slot.jobCount != 0) {
+      ZoneScopedN("Wait ring slot");
+      const auto waitInfo = vk::SemaphoreWaitInfo({}, m_stagingBuffer.getTimeline(), slot.timelineValue);
+      auto _ = m_device.waitSemaphores(waitInfo, UINT64_MAX);
+    }
+    reclaimCompleted();
+    return slot;
+  }
+
+  void recordAndSubmitBatch(std::deque<TransferJob> &batch) {
+    ZoneScoped;
+    auto &slot = acquireSlot();
+    const auto cmd = slot.cmd.get();
+    cmd.reset();
+    cmd.begin({vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+
+    std::vector<vk::BufferMemoryBarrier2> bufferBarriers;
+    std::vector<vk::ImageMemoryBarrier2> imageBarriers;
+    std::vector<MipmapTarget> mipmaps;
+    PendingAcquire acquire;
+    for (auto &batchJob: batch) {
       ZoneScopedN("Record cmd's for job");
-      cmdTransitionImageLayout2(
-        m_cmdBuff.get(),
-        job.dstImage,
-        job.srcImageLayout,
-        vk::ImageLayout::eTransferDstOptimal,
-        job.subresourceRange
-      );
+      if (const auto bufferJob = std::get_if<BufferUploadJob>(&batchJob)) {
+        cmd.copyBuffer(m_stagingBuffer.getBuffer(), bufferJob->dstBuffer, bufferJob->region);
+        if (m_ownershipTransfer) {
+          // Release, destination stage is ignored by release barrier
+          bufferBarriers.emplace_back(
+            vk::PipelineStageFlagBits2::eTransfer, vk::AccessFlagBits2::eTransferWrite,
+            vk::PipelineStageFlagBits2::eNone, vk::AccessFlagBits2::eNone,
+            m_srcFamily, m_dstFamily,
+            bufferJob->dstBuffer, bufferJob->region.dstOffset, bufferJob->region.size);
+          acquire.buffers.emplace_back(
+            vk::PipelineStageFlagBits2::eNone, vk::AccessFlagBits2::eNone,
+            vk::PipelineStageFlagBits2::eAllCommands, vk::AccessFlagBits2::eMemoryRead,
+            m_srcFamily, m_dstFamily,
+            bufferJob->dstBuffer, bufferJob->region.dstOffset, bufferJob->region.size);
+          continue;
+        }
+        bufferBarriers.emplace_back(
+          vk::PipelineStageFlagBits2::eTransfer, vk::AccessFlagBits2::eTransferWrite,
+          vk::PipelineStageFlagBits2::eAllCommands, vk::AccessFlagBits2::eMemoryRead,
+          vk::QueueFamilyIgnored, vk::QueueFamilyIgnored,
+          bufferJob->dstBuffer, bufferJob->region.dstOffset, bufferJob->region.size);
+        continue;
+      }
+
+      auto &job = std::get<TextureUploadJob>(batchJob);
+      if (job.firstChunk) {
+        cmdTransitionImageLayout2(
+          cmd,
+          job.dstImage,
+          job.srcImageLayout,
+          vk::ImageLayout::eTransferDstOptimal,
+          job.subresourceRange
+        );
+      }
 
-      m_cmdBuff->copyBufferToImage(
+      cmd.copyBufferToImage(
         m_stagingBuffer.getBuffer(), job.dstImage,
-        vk::ImageLayout::eTransferDstOptimal, job.region);
+        vk::ImageLayout::eTransferDstOptimal, job.regions);
+
+      if (!job.lastChunk)
+        continue;
+
+      if (job.generateMipmaps && job.subresourceRange.levelCount > 1) {
+        const auto target = MipmapTarget{
+          .image = job.dstImage, .extent = job.extent, .range = job.subresourceRange
+        };
+        if (!m_ownershipTransfer) {
+          mipmaps.push_back(target);
+          continue;
+        }
+        // Ownership moves without layout change, blits run on destination queue
+        imageBarriers.emplace_back(
+          vk::PipelineStageFlagBits2::eTransfer, vk::AccessFlagBits2::eTransferWrite,
+          vk::PipelineStageFlagBits2::eNone, vk::AccessFlagBits2::eNone,
+          vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eTransferDstOptimal,
+          m_srcFamily, m_dstFamily, job.dstImage, job.subresourceRange);
+        acquire.images.emplace_back(
+          vk::PipelineStageFlagBits2::eNone, vk::AccessFlagBits2::eNone,
+          vk::PipelineStageFlagBits2::eTransfer, vk::AccessFlagBits2::eTransferRead | vk::AccessFlagBits2::eTransferWrite,
+          vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eTransferDstOptimal,
+          m_srcFamily, m_dstFamily, job.dstImage, job.subresourceRange);
+        acquire.mipmaps.push_back(target);
+        continue;
+      }
+
+      if (m_ownershipTransfer) {
+        // Both halves perform the same layout transition
+        imageBarriers.emplace_back(
+          vk::PipelineStageFlagBits2::eTransfer, vk::AccessFlagBits2::eTransferWrite,
+          vk::PipelineStageFlagBits2::eNone, vk::AccessFlagBits2::eNone,
+          vk::ImageLayout::eTransferDstOptimal, job.dstImageLayout,
+          m_srcFamily, m_dstFamily, job.dstImage, job.subresourceRange);
+        acquire.images.emplace_back(
+          vk::PipelineStageFlagBits2::eNone, vk::AccessFlagBits2::eNone,
+          vk::PipelineStageFlagBits2::eAllCommands, vk::AccessFlagBits2::eShaderRead,
+          vk::ImageLayout::eTransferDstOptimal, job.dstImageLayout,
+          m_srcFamily, m_dstFamily, job.dstImage, job.subresourceRange);
+        continue;
+      }
 
       cmdTransitionImageLayout2(
-        m_cmdBuff.get(),
+        cmd,
         job.dstImage,
         vk::ImageLayout::eTransferDstOptimal,
         job.dstImageLayout,
@@ -124,23 +548,41 @@ private:
       );
     }
 
-    m_cmdBuff->end();
+    if (!mipmaps.empty()) {
+      cmdGenerateMipmaps(cmd, mipmaps);
+    }
+    if (!bufferBarriers.empty() || !imageBarriers.empty()) {
+      cmd.pipelineBarrier2(vk::DependencyInfo({}, {}, bufferBarriers, imageBarriers));
+    }
+
+    cmd.end();
 
     for (auto &job: batch) {
-      m_stagingBuffer.trackAlloc(job.allocation);
+      std::visit([&](auto &j) { m_stagingBuffer.trackAlloc(j.allocation); }, job);
     } {
       ZoneScopedN("Queue Submit");
-      const auto cbSubmitInfo = vk::CommandBufferSubmitInfo(m_cmdBuff.get());
+      const auto cbSubmitInfo = vk::CommandBufferSubmitInfo(cmd);
       const auto sigInfo = m_stagingBuffer.makeSignalInfo();
       const auto submit = vk::SubmitInfo2({}, {}, cbSubmitInfo, sigInfo);
 
-      m_transferQueue.submit2(submit, *m_submitFence);
-    } {
-      ZoneScopedN("Wait Queue");
-      auto _ = m_device.waitForFences(*m_submitFence, VK_TRUE, UINT64_MAX);
+      m_transferQueue.submit2(submit);
+      slot.timelineValue = sigInfo.value;
+      slot.jobCount = batch.size();
+      m_lastSubmittedValue = sigInfo.value;
+    }
+
+    // Queued before handles are notified, so ready resource always has its acquire pending
+    if (!acquire.buffers.empty() || !acquire.images.empty() || !acquire.mipmaps.empty()) {
+      acquire.timelineValue = m_lastSubmittedValue;
+      std::lock_guard lock(m_acquireMutex);
+      m_pendingAcquires.push_back(std::move(acquire));
     }
 
-    m_stagingBuffer.pollReclaimed();
+    for (auto &job: batch) {
+      std::visit([](const auto &j) {
+        if (j.handle) j.handle->jobSubmitted(j.allocation.timelineValue);
+      }, job);
+    }
   }
 };
 
@@ -0,0 +1,99 @@
+#ifndef UPLOADHANDLE_H
+#define UPLOADHANDLE_H
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vulkan/vulkan.hpp>
+#include <tracy/Tracy.hpp>
+
+/**
+ * @brief Completion handle shared by all transfer jobs of one GPU resource
+ *
+ * Handle starts with one pending "guard" job, so resource can't be reported as ready
+ * while its jobs are still being pushed. Lifecycle:
+ * 1. Every pushed job calls <code>UploadHandle::addJob</code>
+ * 2. Transfer thread calls <code>UploadHandle::jobSubmitted</code> with job timeline value after queue submit
+ * 3. Owner calls <code>UploadHandle::seal</code> when all jobs are pushed
+ *
+ * Resource is ready when all jobs are submitted and staging timeline semaphore
+ * reached the highest job value.
+ */
+class UploadHandle {
+public:
+  UploadHandle(const vk::Device device, const vk::Semaphore timeline) : m_device(device), m_timeline(timeline) {
+  }
+
+  UploadHandle(const UploadHandle &) = delete;
+
+  UploadHandle &operator=(const UploadHandle &) = delete;
+
+  void addJob() {
+    ++m_pendingJobs;
+    m_hasJobs = true;
+  }
+
+  void jobSubmitted(const uint64_t timelineValue) {
+    auto current = m_timelineValue.load();
+    while (current < timelineValue && !m_timelineValue.compare_exchange_weak(current, timelineValue)) {
+    }
+    --m_pendingJobs;
+  }
+
+  /**
+   * Release guard job, must be called once after last job was pushed
+   */
+  void seal() { --m_pendingJobs; }
+
+  [[nodiscard]] bool isSubmitted() const { return m_pendingJobs.load() == 0; }
+
+  /**
+   * Some job was pushed, so GPU may use resource until handle is ready even when upload was abandoned
+   */
+  [[nodiscard]] bool hasJobs() const { return m_hasJobs.load(); }
+
+  [[nodiscard]] uint64_t getTimelineValue() const { return m_timelineValue.load(); }
+
+  /**
+   * Non-blocking check, result is cached once resource is ready
+   */
+  [[nodiscard]] bool isReady() const {
+    if (m_ready.load())
+      return true;
+    if (!isSubmitted())
+      return false;
+
+    if (m_device.getSemaphoreCounterValue(m_timeline) >= m_timelineValue.load()) {
+      m_ready = true;
+      return true;
+    }
+    return false;
+  }
+
+  /**
+   * Block calling thread until resource is ready
+   */
+  void wait() const {
+    ZoneScoped;
+    if (m_ready.load())
+      return;
+
+    while (!isSubmitted()) {
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    const auto value = m_timelineValue.load();
+    const auto waitInfo = vk::SemaphoreWaitInfo({}, m_timeline, value);
+    auto _ = m_device.waitSemaphores(waitInfo, UINT64_MAX);
+    m_ready = true;
+  }
+
+private:
+  vk::Device m_device;
+  vk::Semaphore m_timeline;
+  std::atomic_uint32_t m_pendingJobs = 1; // Guard job, released by seal()
+  std::atomic_uint64_t m_timelineValue = 0;
+  std::atomic_bool m_hasJobs = false;
+  mutable std::atomic_bool m_ready = false;
+};
+
+#endif //UPLOADHANDLE_H
@@ -1,40 +1,121 @@
 #ifndef VERTEX_H
 #define VERTEX_H
 
+#include <array>
+#include <cstddef>
+#include <format>
+#include <stdexcept>
 #include <vulkan/vulkan.hpp>
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
+#include <glm/gtc/packing.hpp>
 
-class Vertex {
-public:
-  glm::vec3 Position;
-  glm::vec3 Normal;
-  glm::vec2 UV;
-  glm::vec4 Color;
-  uint32_t TextureIdx;
-  uint32_t NormalTextureIdx;
+/**
+ * Normal packed as 10:10:10:2 signed normalized, w is unused
+ */
+struct PackedNormal {
+  uint32_t bits;
+};
+
+/**
+ * Two half floats
+ */
+struct Half2 {
+  uint32_t bits;
+};
+
+/**
+ * Vertex component type description: attribute format and conversion from unpacked value.
+ * Every format is expanded by vertex fetch, so shader input type is same for any layout
+ */
+template<typename T>
+struct VertexComponent;
+
+template<>
+struct VertexComponent<glm::vec3> {
+  static constexpr auto format = vk::Format::eR32G32B32Sfloat;
+  static glm::vec3 pack(const glm::vec3 &value) { return value; }
+};
+
+template<>
+struct VertexComponent<glm::vec2> {
+  static constexpr auto format = vk::Format::eR32G32Sfloat;
+  static glm::vec2 pack(const glm::vec2 &value) { return value; }
+};
+
+template<>
+struct VertexComponent<PackedNormal> {
+  static constexpr auto format = vk::Format::eA2B10G10R10SnormPack32;
+  static PackedNormal pack(const glm::vec3 &value) { return {glm::packSnorm3x10_1x2(glm::vec4(value, 0.0f))}; }
+};
+
+template<>
+struct VertexComponent<Half2> {
+  static constexpr auto format = vk::Format::eR16G16Sfloat;
+  static Half2 pack(const glm::vec2 &value) { return {glm::packHalf2x16(value)}; }
+};
+
+/**
+ * @brief Vertex layout generated from component types
+ *
+ * Material data (color, texture indices) is per-draw and lives in <code>DrawData</code> of draw storage buffer.
+ * Shader locations: 0 - position, 1 - normal, 3 - UV
+ */
+template<typename PositionT, typename NormalT, typename UvT>
+struct BasicVertex {
+  PositionT Position;
+  NormalT Normal;
+  UvT UV;
+
+  static BasicVertex make(const glm::vec3 &position, const glm::vec3 &normal, const glm::vec2 &uv) {
+    return BasicVertex{
+      .Position = VertexComponent<PositionT>::pack(position),
+      .Normal = VertexComponent<NormalT>::pack(normal),
+      .UV = VertexComponent<UvT>::pack(uv)
+    };
+  }
 
   static vk::VertexInputBindingDescription GetBindingDescription() {
-    return vk::VertexInputBindingDescription(0, sizeof(Vertex), vk::VertexInputRate::eVertex);
+    return vk::VertexInputBindingDescription(0, sizeof(BasicVertex), vk::VertexInputRate::eVertex);
   }
 
   static std::vector<vk::VertexInputAttributeDescription> GetAttributeDescriptions() {
-    std::vector<vk::VertexInputAttributeDescription> attributeDescriptions;
-    attributeDescriptions.push_back(
-      vk::VertexInputAttributeDescription(0, 0, vk::Format::eR32G32B32Sfloat, offsetof(Vertex, Position)));
-    attributeDescriptions.push_back(
-      vk::VertexInputAttributeDescription(1, 0, vk::Format::eR32G32B32Sfloat, offsetof(Vertex, Normal)));
-    attributeDescriptions.push_back(
-      vk::VertexInputAttributeDescription(3, 0, vk::Format::eR32G32B32Sfloat, offsetof(Vertex, UV)));
-    attributeDescriptions.push_back(
-      vk::VertexInputAttributeDescription(4, 0, vk::Format::eR32G32B32A32Sfloat, offsetof(Vertex, Color)));
-    attributeDescriptions.push_back(
-      vk::VertexInputAttributeDescription(5, 0, vk::Format::eR32Uint, offsetof(Vertex, TextureIdx)));
-    attributeDescriptions.push_back(
-      vk::VertexInputAttributeDescription(6, 0, vk::Format::eR32Uint, offsetof(Vertex, NormalTextureIdx)));
-    return attributeDescriptions;
+    return {
+      vk::VertexInputAttributeDescription(
+        0, 0, VertexComponent<PositionT>::format, offsetof(BasicVertex, Position)),
+      vk::VertexInputAttributeDescription(
+        1, 0, VertexComponent<NormalT>::format, offsetof(BasicVertex, Normal)),
+      vk::VertexInputAttributeDescription(
+        3, 0, VertexComponent<UvT>::format, offsetof(BasicVertex, UV)),
+    };
+  }
+
+  /**
+   * Check that device can fetch every attribute format of layout
+   * @throws std::runtime_error if any format is not supported as vertex buffer
+   */
+  static void validateFormats(const vk::PhysicalDevice physicalDevice) {
+    for (const auto &attribute: GetAttributeDescriptions()) {
+      const auto props = physicalDevice.getFormatProperties(attribute.format);
+      if (!(props.bufferFeatures & vk::FormatFeatureFlagBits::eVertexBuffer))
+        throw std::runtime_error(std::format(
+          "Vertex format {} (location {}) is not supported by device", vk::to_string(attribute.format),
+          attribute.location));
+    }
   }
 };
 
+using FullVertex = BasicVertex<glm::vec3, glm::vec3, glm::vec2>;
+using PackedVertex = BasicVertex<glm::vec3, PackedNormal, Half2>;
+
+static_assert(sizeof(FullVertex) == 32);
+static_assert(sizeof(PackedVertex) == 20);
+
+#ifdef VKTS_FULL_PRECISION_VERTICES
+using Vertex = FullVertex;
+#else
+using Vertex = PackedVertex;
+#endif
+
 #endif
@@ -1,8 +1,8 @@
 #include "VkTestSiteApp.h"
 
-#define WINDOW_WIDTH 1280
-#define WINDOW_HEIGHT 720
-#define MAX_FRAME_IN_FLIGHT 2 //0..2 -> 3 frames
+#define MAX_FRAME_IN_FLIGHT 2 // Frames recorded by CPU while GPU executes previous ones
+#define GEOMETRY_ARENA_VERTICES (4 * 1024 * 1024)
+#define GEOMETRY_ARENA_INDICES (16 * 1024 * 1024)
 #define MAX_MATERIAL_PER_DESCRIPTOR 64
 
 const std::vector DEVICE_EXTENSIONS = {
@@ -13,6 +13,16 @@ const std::vector DEVICE_EXTENSIONS = {
   VK_KHR_SHADER_DRAW_PARAMETERS_EXTENSION_NAME
 };
 
+static std::vector<const char *> getDeviceExtensions(const bool headless) {
+  auto extensions = DEVICE_EXTENSIONS;
+  if (headless) {
+    std::erase_if(extensions, [](const char *ext) {
+      return std::string_view(ext) == VK_KHR_SWAPCHAIN_EXTENSION_NAME;
+    });
+  }
+  return extensions;
+}
+
 const std::vector LAYERS = {
 #ifndef NDEBUG
   "VK_LAYER_KHRONOS_validation"
@@ -21,19 +31,29 @@ const std::vector LAYERS = {
 
 void VkTestSiteApp::run() {
   ZoneScoped;
-  initWindow();
+  if (!m_options.headless)
+    initWindow();
   IMGUI_CHECKVERSION();
   ImGui::CreateContext();
   ImGui::ApplyCurrentStyle();
   initVk();
-  mainLoop();
+  if (m_options.modelPath)
+    loadModel(*m_options.modelPath);
+
+  if (m_options.headless)
+    headlessLoop();
+  else
+    mainLoop();
 
   m_device.waitIdle();
   ImGui_ImplVulkan_Shutdown();
-  ImGui_ImplGlfw_Shutdown();
+  if (!m_options.headless)
+    ImGui_ImplGlfw_Shutdown();
   cleanup();
-  glfwDestroyWindow(m_window);
-  glfwTerminate();
+  if (!m_options.headless) {
+    glfwDestroyWindow(m_window);
+    glfwTerminate();
+  }
 }
 
 void VkTestSiteApp::initWindow() {
@@ -43,7 +63,8 @@ void VkTestSiteApp::initWindow() {
   glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
   glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
 
-  m_window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "VK test", nullptr, nullptr);
+  m_window = glfwCreateWindow(
+    static_cast<int>(m_options.width), static_cast<int>(m_options.height), "VK test", nullptr, nullptr);
 }
 
 void VkTestSiteApp::initVk() {
@@ -53,10 +74,12 @@ void VkTestSiteApp::initVk() {
   VULKAN_HPP_DEFAULT_DISPATCHER.init(vkGetInstanceProcAddr);
   createInstance();
 
-  VkSurfaceKHR surface_tmp;
-  glfwCreateWindowSurface(m_instance, m_window, nullptr, &surface_tmp);
-  m_surface = vk::UniqueSurfaceKHR(surface_tmp, m_instance);
-  const auto deviceTmp = pickPhysicalDevice(m_instance, m_surface.get(), DEVICE_EXTENSIONS);
+  if (!m_options.headless) {
+    VkSurfaceKHR surface_tmp;
+    glfwCreateWindowSurface(m_instance, m_window, nullptr, &surface_tmp);
+    m_surface = vk::UniqueSurfaceKHR(surface_tmp, m_instance);
+  }
+  const auto deviceTmp = pickPhysicalDevice(m_instance, m_surface.get(), getDeviceExtensions(m_options.headless));
   if (!deviceTmp) {
     abort();
   }
@@ -82,47 +105,78 @@ void VkTestSiteApp::initVk() {
   }
   m_allocator = vma::Allocator(vmaAllocator);
 
-  m_swapchain = Swapchain(m_surface.get(), m_device, m_physicalDevice, m_window);
+  if (m_options.headless) {
+    m_swapchain = Swapchain(
+      m_device, m_allocator, vk::Extent2D(m_options.width, m_options.height), MAX_FRAME_IN_FLIGHT);
+  } else {
+    m_swapchain = Swapchain(m_surface.get(), m_device, m_physicalDevice, m_window);
+  }
   createRenderPass();
   createUniformBuffers();
-  m_descriptorPool = DescriptorPool(m_device);
-  m_lightManager = std::make_unique<LightManager>(
-    m_allocator, m_swapchain.imageViews.size());
+  m_textureCapacity = TextureRegistry::capacityFromLimits(m_physicalDevice);
+  m_descriptorPool = DescriptorPool(m_device, m_textureCapacity * MAX_FRAME_IN_FLIGHT);
+  m_lightManager = std::make_unique<LightManager>(m_allocator, MAX_FRAME_IN_FLIGHT);
+  m_lightClusters = std::make_unique<LightClusters>(m_device, m_allocator, MAX_FRAME_IN_FLIGHT);
+  m_geometryArena = std::make_unique<ModelGeometryArena>(
+    m_device, m_allocator, GEOMETRY_ARENA_VERTICES, GEOMETRY_ARENA_INDICES);
+  const auto deviceFeatures = m_physicalDevice.getFeatures();
+  m_drawList = std::make_unique<DrawList>(
+    m_allocator, MAX_FRAME_IN_FLIGHT,
+    deviceFeatures.multiDrawIndirect
+      ? std::min<uint32_t>(MAX_DRAWS, m_physicalDevice.getProperties().limits.maxDrawIndirectCount)
+      : MAX_DRAWS,
+    deviceFeatures.multiDrawIndirect,
+    m_drawIndirectCount);
   createCommandPool();
   createColorObjets();
   createDepthObjets();
   createDescriptorSet();
+  createCullingObjects();
   createPipeline();
-  const auto lightCmdsInfo = vk::CommandBufferAllocateInfo(
-    m_commandPool, vk::CommandBufferLevel::eSecondary, m_swapchain.imageViews.size()
-  );
-  m_lightingCommandBuffers = m_device.allocateCommandBuffersUnique(lightCmdsInfo);
   createFramebuffers();
-  createCommandBuffers();
+  createFrames();
   createSyncObjects();
   const auto indices = QueueFamilyIndices(m_surface.get(), m_physicalDevice);
-  m_stagingBuffer = std::make_unique<StagingBuffer>(m_device, m_allocator, 128 * 1024 * 1024); // 64 MB
-  m_transferThread = std::make_unique<TransferThread>(m_device, m_transferQueue, indices.transfer, *m_stagingBuffer);
-  m_textureWorkerPool = std::make_unique<TextureWorkerPool>(m_device, m_allocator, *m_stagingBuffer, *m_transferThread);
+  m_gpuProfiler = std::make_unique<GpuProfiler>(
+    m_device, m_physicalDevice, indices.graphics, MAX_FRAME_IN_FLIGHT,
+    m_physicalDevice.getFeatures().pipelineStatisticsQuery);
+  m_stagingBuffer = std::make_unique<StagingBuffer>(
+    m_device, m_allocator, 128 * 1024 * 1024, // 128 MB
+    m_options.stagingRing ? StagingAllocMode::Ring : StagingAllocMode::VirtualBlock);
+  m_transferThread = std::make_unique<TransferThread>(
+    m_device, m_transferQueue, indices.transfer, indices.graphics, *m_stagingBuffer);
+  m_transferThread->setFrameBudget(static_cast<uint64_t>(m_options.uploadBudgetMb) * 1024 * 1024);
+  if (m_options.textureCacheDir) {
+    m_textureCache = std::make_unique<TextureCache>(
+      *m_options.textureCacheDir, static_cast<uint64_t>(m_options.textureCacheMb) * 1024 * 1024);
+  }
+  m_jobSystem = std::make_unique<JobSystem>(m_options.jobWorkers);
+  m_textureWorkerPool = std::make_unique<TextureWorkerPool>(
+    m_physicalDevice, m_device, m_allocator, *m_stagingBuffer, *m_transferThread,
+    *m_jobSystem, m_textureCache.get());
   m_texManager = std::make_unique<TextureManager>(
-    m_device, m_graphicsQueue, m_commandPool, *m_textureWorkerPool, m_geometryDescriptorSet, 1);
+    m_device, m_graphicsQueue, m_commandPool, *m_textureWorkerPool, *m_transferThread, m_geometryDescriptorSet, 3,
+    m_textureCapacity);
+  m_modelLoader = std::make_unique<ModelLoader>(*m_jobSystem, *m_texManager);
 
   m_camera = std::make_unique<Camera>(m_swapchain.extent);
-  auto keyCallback = [](GLFWwindow *window, int key, int scancode, int action, int mods) {
-    const auto me = static_cast<VkTestSiteApp *>(glfwGetWindowUserPointer(window));
-    if (ImGui::GetIO().WantCaptureKeyboard)
-      return;
-    me->m_camera->keyboardCallback(key, action, mods);
-  };
-  auto mouseCallback = [](GLFWwindow *window, double xpos, double ypos) {
-    const auto me = static_cast<VkTestSiteApp *>(glfwGetWindowUserPointer(window));
-    if (ImGui::GetIO().WantCaptureMouse)
-      return;
-    me->m_camera->mouseCallback(window, xpos, ypos);
-  };
-  glfwSetWindowUserPointer(m_window, this);
-  glfwSetKeyCallback(m_window, keyCallback);
-  glfwSetCursorPosCallback(m_window, mouseCallback);
+  if (!m_options.headless) {
+    auto keyCallback = [](GLFWwindow *window, int key, int scancode, int action, int mods) {
+      const auto me = static_cast<VkTestSiteApp *>(glfwGetWindowUserPointer(window));
+      if (ImGui::GetIO().WantCaptureKeyboard)
+        return;
+      me->m_camera->keyboardCallback(key, action, mods);
+    };
+    auto mouseCallback = [](GLFWwindow *window, double xpos, double ypos) {
+      const auto me = static_cast<VkTestSiteApp *>(glfwGetWindowUserPointer(window));
+      if (ImGui::GetIO().WantCaptureMouse)
+        return;
+      me->m_camera->mouseCallback(window, xpos, ypos);
+    };
+    glfwSetWindowUserPointer(m_window, this);
+    glfwSetKeyCallback(m_window, keyCallback);
+    glfwSetCursorPosCallback(m_window, mouseCallback);
+  }
 
 #ifndef NDEBUG
   const auto gpdctd = reinterpret_cast<PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT>(vkGetInstanceProcAddr(
@@ -136,7 +190,8 @@ void VkTestSiteApp::initVk() {
   m_vkContext->Name(contextName.data(), contextName.size());
 #endif
 
-  ImGui_ImplGlfw_InitForVulkan(m_window, true);
+  if (!m_options.headless)
+    ImGui_ImplGlfw_InitForVulkan(m_window, true);
   ImGui_ImplVulkan_InitInfo vkInitInfo = {};
   vkInitInfo.ApiVersion = VK_API_VERSION_1_3;
   vkInitInfo.Instance = m_instance;
@@ -158,11 +213,6 @@ void VkTestSiteApp::initVk() {
     spdlog::error("Failed to initialize Imgui Vulkan render");
     abort();
   }
-
-  const auto imguiCmdsInfo = vk::CommandBufferAllocateInfo(
-    m_commandPool, vk::CommandBufferLevel::eSecondary, m_swapchain.imageViews.size()
-  );
-  m_imguiCommandBuffers = m_device.allocateCommandBuffersUnique(imguiCmdsInfo);
 }
 
 void VkTestSiteApp::createInstance() {
@@ -174,14 +224,15 @@ void VkTestSiteApp::createInstance() {
     VK_API_VERSION_1_3
   );
 
-  uint32_t glfw_extension_count;
-  const char **glfw_extensions = glfwGetRequiredInstanceExtensions(&glfw_extension_count);
-
   std::vector<std::string> required_extensions;
   const std::vector<std::string> required_layers;
 
-  for (uint32_t i = 0; i < glfw_extension_count; ++i) {
-    required_extensions.emplace_back(glfw_extensions[i]);
+  if (!m_options.headless) {
+    uint32_t glfw_extension_count;
+    const char **glfw_extensions = glfwGetRequiredInstanceExtensions(&glfw_extension_count);
+    for (uint32_t i = 0; i < glfw_extension_count; ++i) {
+      required_extensions.emplace_back(glfw_extensions[i]);
+    }
   }
 
 #ifndef NDEBUG
@@ -215,11 +266,14 @@ void VkTestSiteApp::createQueues() {
   const auto indices = QueueFamilyIndices(m_surface.get(), m_physicalDevice);
   m_graphicsQueue = m_device.getQueue(indices.graphics, 0);
   m_presentQueue = m_device.getQueue(indices.present, 0);
-  m_transferQueue = m_device.getQueue(indices.transfer, 1);
+  m_transferQueue = m_device.getQueue(indices.transfer, indices.transferQueueIndex);
+  spdlog::info(std::format("Transfer queue: family {} index {}{}", indices.transfer, indices.transferQueueIndex,
+                           indices.transfer != indices.graphics ? " (dedicated)" : ""));
 }
 
 void VkTestSiteApp::createLogicalDevice() {
   ZoneScoped;
+  Vertex::validateFormats(m_physicalDevice);
   auto indices = QueueFamilyIndices(m_surface.get(), m_physicalDevice);
 
   std::vector<vk::DeviceQueueCreateInfo> queue_create_infos;
@@ -228,7 +282,7 @@ void VkTestSiteApp::createLogicalDevice() {
 
   for (uint32_t queue_family: queue_families) {
     uint32_t count = 1;
-    if (queue_family == indices.graphics && indices.graphics == indices.transfer) {
+    if (queue_family == indices.transfer && indices.transferQueueIndex == 1) {
       count = 2;
     }
 
@@ -244,36 +298,48 @@ void VkTestSiteApp::createLogicalDevice() {
   }
 
   vk::PhysicalDeviceFeatures device_features{};
-  vk::PhysicalDeviceDescriptorIndexingFeatures descriptor_indexing_features{};
-  vk::PhysicalDeviceHostQueryResetFeatures hostQueryResetFeatures{};
-  vk::PhysicalDeviceTimelineSemaphoreFeatures timeline_semaphore_features{};
+  vk::PhysicalDeviceVulkan12Features features12{};
   vk::PhysicalDeviceVulkan13Features features13{};
 
-  hostQueryResetFeatures.setHostQueryReset(true);
-  timeline_semaphore_features
+  const auto supportedFeatures12 = m_physicalDevice.getFeatures2<
+    vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features>().get<vk::PhysicalDeviceVulkan12Features>();
+  // Optional: culled draw list is compacted on GPU and drawn with GPU-written count
+  m_drawIndirectCount = supportedFeatures12.drawIndirectCount;
+
+  features12
+      .setHostQueryReset(true)
       .setTimelineSemaphore(true)
-      .setPNext(&hostQueryResetFeatures);
-  descriptor_indexing_features
       .setDescriptorBindingPartiallyBound(true)
       .setDescriptorBindingSampledImageUpdateAfterBind(true)
       .setShaderSampledImageArrayNonUniformIndexing(true)
       .setRuntimeDescriptorArray(true)
       .setDescriptorBindingVariableDescriptorCount(true)
-      .setPNext(&timeline_semaphore_features);
+      .setDrawIndirectCount(m_drawIndirectCount);
 
   features13
       .setSynchronization2(true)
-      .setPNext(&descriptor_indexing_features);
+      .setPNext(&features12);
 
+  // Draw index is passed as firstInstance of indirect draws
+  const auto supportedFeatures = m_physicalDevice.getFeatures();
+  if (!supportedFeatures.drawIndirectFirstInstance)
+    throw std::runtime_error("Device does not support drawIndirectFirstInstance");
+
+  // Optional: pipeline statistics are used by GPU profiler to count vertex shader invocations,
+  // without multi draw indirect draw list is submitted as one indirect call per draw
   device_features
       .setSamplerAnisotropy(true)
-      .setSampleRateShading(true);
+      .setSampleRateShading(true)
+      .setDrawIndirectFirstInstance(true)
+      .setMultiDrawIndirect(supportedFeatures.multiDrawIndirect)
+      .setPipelineStatisticsQuery(supportedFeatures.pipelineStatisticsQuery);
 
+  const auto deviceExtensions = getDeviceExtensions(m_options.headless);
   vk::DeviceCreateInfo device_create_info(
     {},
     queue_create_infos,
     LAYERS,
-    DEVICE_EXTENSIONS,
+    deviceExtensions,
     &device_features
   );
   device_create_info.setPNext(&features13);
@@ -287,7 +353,7 @@ void VkTestSiteApp::createRenderPass() {
   const auto attachments = {
     vk::AttachmentDescription( // Depth
       {}, vk::Format::eD32Sfloat, vk::SampleCountFlagBits::e1,
-      vk::AttachmentLoadOp::eClear, vk::AttachmentStoreOp::eDontCare,
+      vk::AttachmentLoadOp::eClear, vk::AttachmentStoreOp::eStore, // Stored for Hi-Z build
       vk::AttachmentLoadOp::eDontCare, vk::AttachmentStoreOp::eDontCare,
       vk::ImageLayout::eUndefined, vk::ImageLayout::eDepthStencilReadOnlyOptimal),
     vk::AttachmentDescription( // Albedo
@@ -300,11 +366,12 @@ void VkTestSiteApp::createRenderPass() {
       vk::AttachmentLoadOp::eClear, vk::AttachmentStoreOp::eStore,
       vk::AttachmentLoadOp::eDontCare, vk::AttachmentStoreOp::eDontCare,
       vk::ImageLayout::eUndefined, vk::ImageLayout::eShaderReadOnlyOptimal),
-    vk::AttachmentDescription( // Final color (swapchain)
+    vk::AttachmentDescription( // Final color (swapchain or offscreen image for capture)
       {}, m_swapchain.format, vk::SampleCountFlagBits::e1,
       vk::AttachmentLoadOp::eClear, vk::AttachmentStoreOp::eStore,
       vk::AttachmentLoadOp::eDontCare, vk::AttachmentStoreOp::eDontCare,
-      vk::ImageLayout::eUndefined, vk::ImageLayout::ePresentSrcKHR)
+      vk::ImageLayout::eUndefined,
+      m_options.headless ? vk::ImageLayout::eTransferSrcOptimal : vk::ImageLayout::ePresentSrcKHR)
   };
 
   auto colorRefs = {
@@ -329,15 +396,22 @@ void VkTestSiteApp::createRenderPass() {
   );
 
   auto dependencies = {
+    // G-Buffer attachments are shared by frames in flight:
+    // wait previous frame writes (WAW), input attachment and Hi-Z build reads (WAR) before clear
     vk::SubpassDependency(
       vk::SubpassExternal, 0,
-      vk::PipelineStageFlagBits::eBottomOfPipe,
-      vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests,
-      vk::AccessFlagBits::eMemoryRead,
-      vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite),
+      vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests |
+      vk::PipelineStageFlagBits::eLateFragmentTests | vk::PipelineStageFlagBits::eFragmentShader |
+      vk::PipelineStageFlagBits::eComputeShader,
+      vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests |
+      vk::PipelineStageFlagBits::eLateFragmentTests,
+      vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite,
+      vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite |
+      vk::AccessFlagBits::eDepthStencilAttachmentRead),
     vk::SubpassDependency(
       0, 1,
-      vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests,
+      vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests |
+      vk::PipelineStageFlagBits::eLateFragmentTests,
       vk::PipelineStageFlagBits::eFragmentShader,
       vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite,
       vk::AccessFlagBits::eInputAttachmentRead),
@@ -358,8 +432,7 @@ void VkTestSiteApp::createPipeline() {
         "../res/shaders/deferred/geometry.ep.slang.spv",
         "Geometry Pass Pipeline"
       )
-      .withBindingDescriptions({Vertex::GetBindingDescription()})
-      .withAttributeDescriptions({Vertex::GetAttributeDescriptions()})
+      .withVertexLayout<Vertex>()
       .withColorBlendAttachments({
         PipelineBuilder::makeDefaultColorAttachmentState(),
         PipelineBuilder::makeDefaultColorAttachmentState(),
@@ -411,7 +484,8 @@ void VkTestSiteApp::createDepthObjets() {
     depthFormat,
     vk::SampleCountFlagBits::e1,
     vk::ImageAspectFlagBits::eDepth,
-    vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eInputAttachment,
+    vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eInputAttachment |
+    vk::ImageUsageFlagBits::eSampled, // Hi-Z build source
     false, "Depth attachment"
   );
 
@@ -445,7 +519,7 @@ void VkTestSiteApp::createFramebuffers() {
 
 void VkTestSiteApp::createUniformBuffers() {
   ZoneScoped;
-  for (size_t i = 0; i < m_swapchain.imageViews.size(); ++i) {
+  for (size_t i = 0; i < MAX_FRAME_IN_FLIGHT; ++i) {
     m_uniforms.emplace_back(m_allocator,
                             vk::MemoryPropertyFlagBits::eHostCoherent | vk::MemoryPropertyFlagBits::eHostVisible);
   }
@@ -478,25 +552,34 @@ void VkTestSiteApp::createDescriptorSet() {
   };
 
   m_geometryDescriptorSet = DescriptorSet(
-    m_device, m_descriptorPool.getDescriptorPool(), m_swapchain.imageViews.size(),
+    m_device, m_descriptorPool.getDescriptorPool(), MAX_FRAME_IN_FLIGHT,
     {
       uboDescriptor,
+      DescriptorLayout{
+        .type = vk::DescriptorType::eStorageBuffer,
+        .stage = vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment,
+        .bindingFlags = {},
+        .shaderBinding = 2,
+        .count = 1,
+        .imageInfos = {},
+        .bufferInfos = m_drawList->getBufferInfos()
+      },
+      // Bindless texture table, filled by TextureManager
       DescriptorLayout{
         .type = vk::DescriptorType::eCombinedImageSampler,
         .stage = vk::ShaderStageFlagBits::eFragment,
         .bindingFlags = vk::DescriptorBindingFlagBits::ePartiallyBound |
-                        vk::DescriptorBindingFlagBits::eUpdateAfterBind,
-        .shaderBinding = 1,
-        .count = MAX_TEXTURE_PER_DESCRIPTOR,
+                        vk::DescriptorBindingFlagBits::eUpdateAfterBind |
+                        vk::DescriptorBindingFlagBits::eVariableDescriptorCount,
+        .shaderBinding = 3,
+        .count = m_textureCapacity,
         .imageInfos = {},
         .bufferInfos = {}
       }
-    }, {
-      vk::PushConstantRange(vk::ShaderStageFlagBits::eVertex, 0, sizeof(ModelPushConsts))
-    });
+    }, {});
 
   m_lightingDescriptorSet = DescriptorSet(
-    m_device, m_descriptorPool.getDescriptorPool(), m_swapchain.imageViews.size(),
+    m_device, m_descriptorPool.getDescriptorPool(), MAX_FRAME_IN_FLIGHT,
     {
       uboDescriptor,
       lightsDescriptor,
@@ -533,9 +616,34 @@ void VkTestSiteApp::createDescriptorSet() {
         },
         .bufferInfos = {}
       },
-    }, {
-      vk::PushConstantRange(vk::ShaderStageFlagBits::eFragment, 0, sizeof(LightPushConsts)) // Lights count
-    });
+      DescriptorLayout{
+        .type = vk::DescriptorType::eUniformBuffer,
+        .stage = vk::ShaderStageFlagBits::eFragment,
+        .bindingFlags = {},
+        .shaderBinding = 5,
+        .count = 1,
+        .imageInfos = {},
+        .bufferInfos = m_lightClusters->getUniformInfos()
+      },
+      DescriptorLayout{
+        .type = vk::DescriptorType::eStorageBuffer,
+        .stage = vk::ShaderStageFlagBits::eFragment,
+        .bindingFlags = {},
+        .shaderBinding = 6,
+        .count = 1,
+        .imageInfos = {},
+        .bufferInfos = m_lightClusters->getClusterInfos()
+      },
+    }, {});
+
+  m_lightClusters->createPipeline(m_descriptorPool.getDescriptorPool(), m_lightManager->getBufferInfos());
+}
+
+void VkTestSiteApp::createCullingObjects() {
+  ZoneScoped;
+  m_culling = std::make_unique<GpuCulling>(
+    m_device, m_allocator, m_descriptorPool.getDescriptorPool(), *m_drawList, MAX_FRAME_IN_FLIGHT,
+    m_depth->getImageView(), m_swapchain.extent);
 }
 
 void VkTestSiteApp::createCommandPool() {
@@ -546,18 +654,32 @@ void VkTestSiteApp::createCommandPool() {
   m_commandPool = m_device.createCommandPool(poolInfo);
 }
 
-void VkTestSiteApp::createCommandBuffers() {
+void VkTestSiteApp::createFrames() {
   ZoneScoped;
-  const auto commandBufInfo = vk::CommandBufferAllocateInfo(m_commandPool, vk::CommandBufferLevel::ePrimary,
-                                                            m_swapchain.imageViews.size());
-  m_commandBuffers = m_device.allocateCommandBuffers(commandBufInfo);
+  const auto indices = QueueFamilyIndices(m_surface.get(), m_physicalDevice);
+  constexpr auto fenceInfo = vk::FenceCreateInfo(vk::FenceCreateFlagBits::eSignaled);
+
+  m_frames.resize(MAX_FRAME_IN_FLIGHT);
+  for (uint32_t i = 0; i < MAX_FRAME_IN_FLIGHT; ++i) {
+    auto &frame = m_frames[i];
+    frame.commandPool = m_device.createCommandPoolUnique(
+      vk::CommandPoolCreateInfo(vk::CommandPoolCreateFlagBits::eTransient, indices.graphics));
+    frame.commandBuffer = m_device.allocateCommandBuffers(
+      vk::CommandBufferAllocateInfo(frame.commandPool.get(), vk::CommandBufferLevel::ePrimary, 1))[0];
+    const auto secondaries = m_device.allocateCommandBuffers(
+      vk::CommandBufferAllocateInfo(frame.commandPool.get(), vk::CommandBufferLevel::eSecondary, 2));
+    frame.lightingCommandBuffer = secondaries[0];
+    frame.imguiCommandBuffer = secondaries[1];
+    frame.inFlight = m_device.createFenceUnique(fenceInfo);
+    frame.imageAvailable = m_device.createSemaphoreUnique(vk::SemaphoreCreateInfo());
+
+    setObjectName(m_device, frame.commandPool.get(), std::format("Frame {} command pool", i));
+    setObjectName(m_device, frame.inFlight.get(), std::format("Frame {} in flight fence", i));
+  }
 }
 
 void VkTestSiteApp::createSyncObjects() {
-  constexpr auto fenceInfo = vk::FenceCreateInfo(vk::FenceCreateFlagBits::eSignaled);
-  for (int i = 0; i < m_swapchain.imageViews.size(); ++i) {
-    m_inFlight.push_back(m_device.createFence(fenceInfo));
-    m_imageAvailable.push_back(m_device.createSemaphore(vk::SemaphoreCreateInfo()));
+  for (size_t i = 0; i < m_swapchain.images.size(); ++i) {
     m_renderFinished.push_back(m_device.createSemaphore(vk::SemaphoreCreateInfo()));
   }
 }
@@ -569,7 +691,12 @@ void VkTestSiteApp::mainLoop() {
     const float deltaTime = currentTime - m_lastTime;
     m_lastTime = currentTime;
     glfwPollEvents();
+    m_transferThread->beginFrame();
     m_texManager->checkTextureLoading();
+    if (m_modelLoaded) {
+      m_model->streamIn(*m_lightManager);
+      m_model->updateTexturePriorities(*m_camera, *m_texManager);
+    }
     if (glfwGetWindowAttrib(m_window, GLFW_ICONIFIED) != 0) {
       ImGui_ImplGlfw_Sleep(10);
       continue;
@@ -584,20 +711,39 @@ void VkTestSiteApp::mainLoop() {
     ImGui::SetNextWindowSize(ImVec2(300, 200), ImGuiCond_Once);
     const auto cameraPos = m_camera->getViewPos();
     ImGui::Text("Camera pos: %f %f %f", cameraPos.x, cameraPos.y, cameraPos.z);
+    if (m_lastGpuTimings) {
+      const auto passMs = [&](GpuPass pass) {
+        return m_lastGpuTimings->passMs[static_cast<uint32_t>(pass)].value_or(0.0);
+      };
+      ImGui::Text("GPU: %.3f ms (culling %.3f, clusters %.3f, geometry %.3f, lighting %.3f, imgui %.3f, hiz %.3f)",
+                  m_lastGpuTimings->frameMs.value_or(0.0), passMs(GpuPass::Culling), passMs(GpuPass::Clusters),
+                  passMs(GpuPass::Geometry), passMs(GpuPass::Lighting), passMs(GpuPass::ImGui),
+                  passMs(GpuPass::HiZ));
+    }
+    ImGui::Checkbox("Frustum culling", &m_options.frustumCulling);
+    ImGui::SameLine();
+    ImGui::Checkbox("Occlusion culling", &m_options.occlusionCulling);
+    ImGui::Text("Visible draws: %u / %u", m_lastVisibleDraws, m_lastCandidateDraws);
+    if (!m_modelLoaded)
+      ImGui::Checkbox("Optimize vertex cache", &m_options.optimizeVertexCache);
     if (!m_modelLoaded && ImGui::Button("Load model")) {
       ZoneScopedN("Model loading");
       auto path = tinyfd_openFileDialog("Open model file", nullptr, 0, nullptr, nullptr, 0);
       if (path != nullptr) {
-        auto pathStr = std::string(path);
-        m_model = std::make_unique<Model>(
-          m_device, m_graphicsQueue, m_commandPool, m_allocator, *m_texManager, *m_lightManager, pathStr);
-        m_model->createCommandBuffers(m_device, m_commandPool, m_swapchain.imageViews.size());
-        m_modelLoaded = true;
+        loadModel(std::string(path));
+      }
+    }
+    if (m_modelLoaded) {
+      if (const auto progress = m_model->getProgress(); !progress.isFinished()) {
+        ImGui::ProgressBar(progress.fraction(), ImVec2(-1.0f, 0.0f),
+                           std::format("{}/{} submeshes", progress.residentSubmeshes,
+                                       progress.totalSubmeshes).c_str());
+      } else if (progress.state == ModelLoadState::Failed) {
+        ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "Model loading failed");
       }
     }
     if (m_modelLoaded && ImGui::Button("Unload model")) {
-      m_model.reset();
-      m_modelLoaded = false;
+      unloadModel();
     }
 
     if (m_modelLoaded && ImGui::Button("Dump VMA stats")) {
@@ -625,9 +771,9 @@ void VkTestSiteApp::mainLoop() {
       static unsigned int selected = -1; {
         ImGui::BeginChild("Slots", ImVec2(ImGui::GetContentRegionAvail().x * 0.2f, 260), ImGuiChildFlags_None,
                           ImGuiWindowFlags_HorizontalScrollbar);
-        for (const auto &id: m_texManager->m_textures | std::views::keys) {
-          if (ImGui::Selectable(std::format("Slot: {}", id).c_str(), selected == id)) {
-            selected = id;
+        for (const auto handle: m_texManager->getSlots()) {
+          if (ImGui::Selectable(std::format("Slot: {}", TextureRegistry::slotOf(handle)).c_str(), selected == handle)) {
+            selected = handle;
           }
         }
         ImGui::EndChild();
@@ -670,15 +816,108 @@ void VkTestSiteApp::mainLoop() {
   }
 }
 
+/**
+ * Deterministic frame loop for headless runs: waits for all assets, then renders
+ * a fixed number of frames with a fixed time step and optional scripted camera
+ */
+void VkTestSiteApp::headlessLoop() {
+  ZoneScoped;
+  const auto loadStart = std::chrono::steady_clock::now();
+  waitForAssets();
+  m_assetLoadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+  if (m_options.cameraPath)
+    m_cameraPath = CameraPath::fromFile(*m_options.cameraPath);
+  if (m_options.captureDir)
+    std::filesystem::create_directories(*m_options.captureDir);
+
+  m_frameStats = FrameStatsRecorder(m_frameNumber, m_options.frameCount, m_options.warmupFrames);
+
+  auto &io = ImGui::GetIO();
+  for (uint32_t frame = 0; frame < m_options.frameCount; ++frame) {
+    const auto frameStart = std::chrono::steady_clock::now();
+    const auto frameNumber = m_frameNumber;
+    const float time = static_cast<float>(frame) * m_options.frameDelta;
+    if (!m_cameraPath.empty()) {
+      const auto key = m_cameraPath.sample(time);
+      m_camera->setPose(key.position, key.rotation);
+    }
+
+    io.DisplaySize = ImVec2(static_cast<float>(m_swapchain.extent.width),
+                            static_cast<float>(m_swapchain.extent.height));
+    io.DeltaTime = m_options.frameDelta;
+    ImGui_ImplVulkan_NewFrame();
+    ImGui::NewFrame();
+    ImGui::Render();
+
+    const auto imageIndex = renderOffscreen(ImGui::GetDrawData(), m_options.frameDelta);
+    const std::chrono::duration<double, std::milli> cpuTime = std::chrono::steady_clock::now() - frameStart;
+    m_frameStats.recordCpu(frameNumber, cpuTime.count());
+    if (m_options.captureDir)
+      captureFrame(imageIndex, frame);
+    FrameMark;
+  }
+
+  // Timings of last frames in flight
+  m_device.waitIdle();
+  for (uint32_t frame = 0; frame < MAX_FRAME_IN_FLIGHT; ++frame)
+    collectGpuTimings(frame);
+
+  if (m_options.statsOutput)
+    writeFrameStats(*m_options.statsOutput);
+}
+
+/**
+ * Start background model loading, model is drawn progressively while it streams in
+ */
+void VkTestSiteApp::loadModel(const std::filesystem::path &path) {
+  ZoneScoped;
+  m_model = std::make_shared<Model>(m_device, *m_transferThread, *m_geometryArena, path, ModelImportOptions{
+                                      .optimizeVertexCache = m_options.optimizeVertexCache
+                                    });
+  m_model->createCommandBuffers(m_device, m_commandPool, MAX_FRAME_IN_FLIGHT);
+  m_modelLoader->pushJob(ModelLoadJob{.model = m_model});
+  m_modelLoaded = true;
+}
+
+void VkTestSiteApp::unloadModel() {
+  ZoneScoped;
+  if (!m_modelLoaded)
+    return;
+
+  // Model must not be released on loader worker, its buffers may be still used by frames in flight
+  m_model->cancel();
+  m_modelLoader->waitIdle();
+  m_model->cancelTextureLoads(*m_texManager);
+  m_device.waitIdle();
+  m_model.reset();
+  m_modelLoaded = false;
+}
+
+/**
+ * Block until model is streamed in and every requested texture is loaded and uploaded to GPU
+ */
+void VkTestSiteApp::waitForAssets() {
+  ZoneScoped;
+  while ((m_modelLoaded && !m_model->isFullyResident()) || m_texManager->hasPendingLoads()) {
+    m_transferThread->beginFrame(); // Loop step counts as frame for upload budget
+    m_texManager->checkTextureLoading();
+    if (m_modelLoaded)
+      m_model->streamIn(*m_lightManager);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  m_transferThread->waitIdle();
+  m_device.waitIdle();
+}
+
 void VkTestSiteApp::render(ImDrawData *draw_data, float deltaTime) {
   ZoneScoped;
-  auto _ = m_device.waitForFences(m_inFlight[m_currentFrame], true, UINT64_MAX);
-  m_device.resetFences(m_inFlight[m_currentFrame]);
+  const auto &frame = m_frames[m_currentFrame];
+  auto _ = m_device.waitForFences(frame.inFlight.get(), true, UINT64_MAX);
 
   uint32_t imageIndex;
   try {
     const auto acquireResult = m_device.acquireNextImageKHR(
-      m_swapchain.swapchain, UINT64_MAX, m_imageAvailable[m_currentFrame], nullptr);
+      m_swapchain.swapchain, UINT64_MAX, frame.imageAvailable.get(), nullptr);
     imageIndex = acquireResult.value;
   } catch (vk::OutOfDateKHRError &) {
     recreateSwapchain();
@@ -686,24 +925,25 @@ void VkTestSiteApp::render(ImDrawData *draw_data, float deltaTime) {
   } catch (vk::SystemError &) {
     throw std::runtime_error("Failed to acquire swapchain image!");
   }
+  // Reset only when work will be submitted, otherwise next wait on this slot deadlocks
+  m_device.resetFences(frame.inFlight.get());
+  collectGpuTimings(m_currentFrame);
 
   m_camera->onUpdate(deltaTime);
-  updateUniformBuffer(imageIndex);
-  recordCommandBuffer(draw_data, m_commandBuffers[imageIndex], imageIndex);
-
-  vk::PipelineStageFlags pipelineStageFlags = vk::PipelineStageFlagBits::eColorAttachmentOutput;
-  const auto submitInfo = vk::SubmitInfo(
-    m_imageAvailable[m_currentFrame],
-    pipelineStageFlags,
-    m_commandBuffers[imageIndex],
-    m_renderFinished[m_currentFrame]);
-  m_graphicsQueue.submit(submitInfo, m_inFlight[m_currentFrame]);
-
-  executeSingleTimeCommands(m_device, m_graphicsQueue, m_commandPool, [&](const vk::CommandBuffer cmd) {
-    //m_vkContext->Collect(cmd);
-  });
-
-  const auto presentInfo = vk::PresentInfoKHR(m_renderFinished[m_currentFrame], m_swapchain.swapchain, imageIndex);
+  updateUniformBuffer(m_currentFrame);
+  recordCommandBuffer(draw_data, m_currentFrame, imageIndex);
+
+  auto waitInfos = makeTransferWaitInfos();
+  waitInfos.emplace_back(frame.imageAvailable.get(), 0, vk::PipelineStageFlagBits2::eColorAttachmentOutput);
+  const auto cmdInfo = vk::CommandBufferSubmitInfo(frame.commandBuffer);
+  const auto signalInfo = vk::SemaphoreSubmitInfo(
+    m_renderFinished[imageIndex], 0, vk::PipelineStageFlagBits2::eAllCommands);
+  const auto submitInfo = vk::SubmitInfo2({}, waitInfos, cmdInfo, signalInfo);
+  m_graphicsQueue.submit2(submitInfo, frame.inFlight.get());
+  ++m_frameNumber;
+  m_currentFrame = (m_currentFrame + 1) % MAX_FRAME_IN_FLIGHT;
+
+  const auto presentInfo = vk::PresentInfoKHR(m_renderFinished[imageIndex], m_swapchain.swapchain, imageIndex);
   vk::Result presentResult;
   try {
     presentResult = m_presentQueue.presentKHR(presentInfo);
@@ -715,30 +955,167 @@ void VkTestSiteApp::render(ImDrawData *draw_data, float deltaTime) {
 
   if (presentResult == vk::Result::eSuboptimalKHR || presentResult == vk::Result::eErrorOutOfDateKHR) {
     recreateSwapchain();
+  }
+}
+
+/**
+ * Headless counterpart of <code>VkTestSiteApp::render</code>.
+ * Offscreen image count equals frames in flight, so frame slot is also image index
+ * @return index of rendered offscreen image
+ */
+uint32_t VkTestSiteApp::renderOffscreen(ImDrawData *draw_data, const float deltaTime) {
+  ZoneScoped;
+  const auto frameIndex = m_currentFrame;
+  const auto &frame = m_frames[frameIndex];
+  auto _ = m_device.waitForFences(frame.inFlight.get(), true, UINT64_MAX);
+  m_device.resetFences(frame.inFlight.get());
+  collectGpuTimings(frameIndex);
+
+  m_camera->onUpdate(deltaTime);
+  updateUniformBuffer(frameIndex);
+  recordCommandBuffer(draw_data, frameIndex, frameIndex);
+
+  const auto waitInfos = makeTransferWaitInfos();
+  const auto cmdInfo = vk::CommandBufferSubmitInfo(frame.commandBuffer);
+  m_graphicsQueue.submit2(vk::SubmitInfo2({}, waitInfos, cmdInfo, {}), frame.inFlight.get());
+  ++m_frameNumber;
+
+  m_currentFrame = (m_currentFrame + 1) % MAX_FRAME_IN_FLIGHT;
+  return frameIndex;
+}
+
+/**
+ * Frame submit waits for transfer batches whose ownership was acquired in its command buffer
+ */
+std::vector<vk::SemaphoreSubmitInfo> VkTestSiteApp::makeTransferWaitInfos() const {
+  std::vector<vk::SemaphoreSubmitInfo> waitInfos;
+  if (m_transferWaitValue > 0)
+    waitInfos.emplace_back(m_transferThread->getTimeline(), m_transferWaitValue,
+                           vk::PipelineStageFlagBits2::eAllCommands);
+  return waitInfos;
+}
+
+/**
+ * Copy offscreen image to host memory and write it as PNG into capture directory
+ */
+void VkTestSiteApp::captureFrame(const uint32_t imageIndex, const uint32_t frameNumber) {
+  ZoneScoped;
+  auto _ = m_device.waitForFences(m_frames[imageIndex].inFlight.get(), true, UINT64_MAX);
+
+  const auto extent = m_swapchain.extent;
+  const vk::DeviceSize size = static_cast<vk::DeviceSize>(extent.width) * extent.height * 4;
+  auto [readback, readbackAlloc] = createBufferUnique(
+    m_allocator, size, vk::BufferUsageFlagBits::eTransferDst,
+    vma::MemoryUsage::eAuto,
+    vma::AllocationCreateFlagBits::eMapped | vma::AllocationCreateFlagBits::eHostAccessRandom);
+
+  executeSingleTimeCommands(m_device, m_graphicsQueue, m_commandPool, [&](const vk::CommandBuffer cmd) {
+    constexpr auto subresource = vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+    const auto toCopy = vk::ImageMemoryBarrier(
+      vk::AccessFlagBits::eColorAttachmentWrite, vk::AccessFlagBits::eTransferRead,
+      vk::ImageLayout::eTransferSrcOptimal, vk::ImageLayout::eTransferSrcOptimal,
+      vk::QueueFamilyIgnored, vk::QueueFamilyIgnored,
+      m_swapchain.images[imageIndex], subresource);
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eColorAttachmentOutput, vk::PipelineStageFlagBits::eTransfer,
+                        {}, {}, {}, toCopy);
+
+    constexpr auto layers = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, 1);
+    const auto region = vk::BufferImageCopy(
+      0, 0, 0, layers, vk::Offset3D(0, 0, 0), vk::Extent3D(extent.width, extent.height, 1));
+    cmd.copyImageToBuffer(m_swapchain.images[imageIndex], vk::ImageLayout::eTransferSrcOptimal,
+                          readback.get(), region);
+
+    const auto toHost = vk::BufferMemoryBarrier(
+      vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eHostRead,
+      vk::QueueFamilyIgnored, vk::QueueFamilyIgnored, readback.get(), 0, size);
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost,
+                        {}, {}, toHost, {});
+  });
+
+  m_allocator.invalidateAllocation(readbackAlloc.get(), 0, size);
+  const auto pixels = static_cast<uint8_t *>(m_allocator.getAllocationInfo(readbackAlloc.get()).pMappedData);
+  if (m_swapchain.format == vk::Format::eB8G8R8A8Unorm || m_swapchain.format == vk::Format::eB8G8R8A8Srgb) {
+    // PNG wants RGBA
+    for (vk::DeviceSize i = 0; i < size; i += 4)
+      std::swap(pixels[i], pixels[i + 2]);
+  }
+  const auto file = *m_options.captureDir / std::format("frame_{:05}.png", frameNumber);
+  if (!stbi_write_png(file.string().c_str(), static_cast<int>(extent.width), static_cast<int>(extent.height),
+                      4, pixels, static_cast<int>(extent.width * 4))) {
+    throw std::runtime_error("Failed to write captured frame: " + file.string());
+  }
+}
+
+/**
+ * Read back GPU pass timings of the frame previously recorded into frame slot
+ * @remark Slot commands must be completed by GPU
+ */
+void VkTestSiteApp::collectGpuTimings(const uint32_t frameIndex) {
+  const auto timings = m_gpuProfiler->collect(frameIndex);
+  if (!timings)
     return;
+
+  m_lastGpuTimings = timings;
+  if (m_options.headless)
+    m_frameStats.recordGpu(*timings);
+}
+
+void VkTestSiteApp::writeFrameStats(const std::filesystem::path &output) const {
+  ZoneScoped;
+  const auto props = m_physicalDevice.getProperties();
+  std::vector<std::pair<std::string, std::string> > metadata = {
+    {"device", std::string(props.deviceName)},
+    {"model", m_options.modelPath ? m_options.modelPath->string() : ""},
+    {"cameraPath", m_options.cameraPath ? m_options.cameraPath->string() : ""},
+    {"resolution", std::format("{}x{}", m_swapchain.extent.width, m_swapchain.extent.height)},
+    {"vertexCacheOptimization", m_options.optimizeVertexCache ? "on" : "off"},
+    {"stagingMode", m_options.stagingRing ? "ring" : "virtualBlock"},
+    {"jobWorkers", std::to_string(m_options.jobWorkers)},
+    {"uploadBudgetMb", std::to_string(m_options.uploadBudgetMb)},
+    {"textureCache", m_options.textureCacheDir ? m_options.textureCacheDir->string() : ""},
+    {"assetLoadMs", std::format("{:.2f}", m_assetLoadMs)},
+  };
+  if (m_modelLoaded) {
+    const auto stats = m_model->getGeometryStats();
+    metadata.emplace_back("modelVertices", std::to_string(stats.vertices));
+    metadata.emplace_back("modelIndices", std::to_string(stats.indices));
+    metadata.emplace_back("modelGeometryBytes", std::to_string(stats.vertexBytes + stats.indexBytes));
+    metadata.emplace_back("modelAcmr", std::format("{:.4f}", stats.acmr));
   }
+  const auto json = m_frameStats.toJson(metadata);
 
-  m_presentQueue.waitIdle();
+  if (output == "-") {
+    std::cout << json << std::flush;
+    return;
+  }
 
-  m_currentFrame = imageIndex;
+  auto file = std::ofstream(output);
+  if (!file.is_open())
+    throw std::runtime_error("Failed to open stats output file: " + output.string());
+  file << json;
+  spdlog::info("Frame stats saved at {}", output.string());
 }
 
-void VkTestSiteApp::updateUniformBuffer(uint32_t imageIndex) {
+void VkTestSiteApp::updateUniformBuffer(const uint32_t frameIndex) {
   auto ubo = UniformBufferObject{
     glm::vec4(m_camera->getViewPos(), 1.0f),
     m_camera->getViewProj(),
     m_camera->getInvViewProj(),
     static_cast<uint32_t>(m_debugView)
   };
-  m_uniforms[imageIndex].map(ubo);
-  m_lightManager->map(imageIndex);
+  m_uniforms[frameIndex].map(ubo);
+  m_lightManager->map(frameIndex);
 }
 
-void VkTestSiteApp::recordCommandBuffer(ImDrawData *draw_data, const vk::CommandBuffer &commandBuffer,
-                                        uint32_t imageIndex) {
+void VkTestSiteApp::recordCommandBuffer(ImDrawData *draw_data, const uint32_t frameIndex, const uint32_t imageIndex) {
   ZoneScoped;
-  commandBuffer.reset();
-  commandBuffer.begin(vk::CommandBufferBeginInfo());
+  const auto &frame = m_frames[frameIndex];
+  m_device.resetCommandPool(frame.commandPool.get());
+  const auto commandBuffer = frame.commandBuffer;
+  commandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+  m_gpuProfiler->beginFrame(frameIndex, m_frameNumber);
+  // Uploads which became ready before this frame are used by it
+  m_transferWaitValue = m_transferThread->cmdAcquireOwnership(commandBuffer);
 
   const auto renderArea = vk::Rect2D({}, m_swapchain.extent);
   auto colorClearValue = m_modelLoaded
@@ -750,18 +1127,33 @@ void VkTestSiteApp::recordCommandBuffer(ImDrawData *draw_data, const vk::Command
   auto clearValues = {depthClearValue, albedoClearValue, normalClearValue, colorClearValue};
   const auto beginInfo = vk::RenderPassBeginInfo(m_renderPass, m_framebuffers[imageIndex], renderArea, clearValues);
 
+  // Slot fence is signaled, so previous culling result of slot is readable
+  m_lastVisibleDraws = m_drawList->getVisibleCount(frameIndex);
+  m_lastCandidateDraws = m_drawList->getCount(frameIndex);
+  if (m_modelLoaded) {
+    m_model->fillDrawList(*m_jobSystem, *m_drawList, frameIndex);
+  } else {
+    m_drawList->reset(frameIndex);
+  }
+  m_culling->cmdCull(commandBuffer, *m_gpuProfiler, *m_drawList, m_camera->getFrustumPlanes(),
+                     m_camera->getViewProj(), m_options.frustumCulling, m_options.occlusionCulling, frameIndex);
+  m_lightClusters->cmdBuild(commandBuffer, *m_gpuProfiler, *m_camera, m_swapchain.extent,
+                            m_lightManager->getCount(), frameIndex);
+
   commandBuffer.beginRenderPass(beginInfo, vk::SubpassContents::eSecondaryCommandBuffers); {
     // Model temp render
     if (m_modelLoaded) {
       auto modelCmd = m_model->cmdDraw(
         *m_vkContext,
+        *m_gpuProfiler,
         m_framebuffers[imageIndex],
         m_renderPass,
         m_geometryPipeline,
         m_swapchain,
         m_geometryDescriptorSet,
+        *m_drawList,
         0,
-        imageIndex
+        frameIndex
       );
 
       commandBuffer.executeCommands(modelCmd);
@@ -769,36 +1161,35 @@ void VkTestSiteApp::recordCommandBuffer(ImDrawData *draw_data, const vk::Command
   }
   commandBuffer.nextSubpass(vk::SubpassContents::eSecondaryCommandBuffers); {
     //Light subpass
-    auto lightCmd = m_lightingCommandBuffers[imageIndex].get();
+    auto lightCmd = frame.lightingCommandBuffer;
     auto inheritanceInfo = vk::CommandBufferInheritanceInfo(m_renderPass, 1, m_framebuffers[imageIndex]);
     auto lightBeginInfo = vk::CommandBufferBeginInfo(
-      vk::CommandBufferUsageFlagBits::eRenderPassContinue | vk::CommandBufferUsageFlagBits::eSimultaneousUse,
+      vk::CommandBufferUsageFlagBits::eRenderPassContinue | vk::CommandBufferUsageFlagBits::eOneTimeSubmit,
       &inheritanceInfo);
-    lightCmd.reset();
     lightCmd.begin(lightBeginInfo); {
       //TracyVkZone(m_vkContext, lightCmd, "Light Pass");
+      m_gpuProfiler->cmdBegin(lightCmd, frameIndex, GpuPass::Lighting);
       m_swapchain.cmdSetViewport(lightCmd);
       m_swapchain.cmdSetScissor(lightCmd);
       lightCmd.bindPipeline(vk::PipelineBindPoint::eGraphics, m_lightingPipeline);
-      m_lightingDescriptorSet.bind(lightCmd, imageIndex, {});
-      auto lightPush = LightPushConsts{.lightCount = m_lightManager->getCount()};
-      lightCmd.pushConstants(m_lightingDescriptorSet.getPipelineLayout(), vk::ShaderStageFlagBits::eFragment, 0,
-                             sizeof(lightPush), &lightPush);
+      m_lightingDescriptorSet.bind(lightCmd, frameIndex, {});
       lightCmd.draw(3, 1, 0, 0);
+      m_gpuProfiler->cmdEnd(lightCmd, frameIndex, GpuPass::Lighting);
     }
     lightCmd.end();
     commandBuffer.executeCommands(lightCmd);
   } {
     // ImGUI Secondary Cmd record -> exec
-    auto imguiCmd = m_imguiCommandBuffers[imageIndex].get();
+    auto imguiCmd = frame.imguiCommandBuffer;
     auto inheritanceInfo = vk::CommandBufferInheritanceInfo(m_renderPass, 1, m_framebuffers[imageIndex]);
     auto imguiBeginInfo = vk::CommandBufferBeginInfo(
-      vk::CommandBufferUsageFlagBits::eRenderPassContinue | vk::CommandBufferUsageFlagBits::eSimultaneousUse,
+      vk::CommandBufferUsageFlagBits::eRenderPassContinue | vk::CommandBufferUsageFlagBits::eOneTimeSubmit,
       &inheritanceInfo);
-    imguiCmd.reset();
     imguiCmd.begin(imguiBeginInfo); {
       //TracyVkZone(m_vkContext, imguiCmd, "Imgui");
+      m_gpuProfiler->cmdBegin(imguiCmd, frameIndex, GpuPass::ImGui);
       ImGui_ImplVulkan_RenderDrawData(draw_data, imguiCmd);
+      m_gpuProfiler->cmdEnd(imguiCmd, frameIndex, GpuPass::ImGui);
     }
     imguiCmd.end();
 
@@ -806,6 +1197,7 @@ void VkTestSiteApp::recordCommandBuffer(ImDrawData *draw_data, const vk::Command
   }
 
   commandBuffer.endRenderPass();
+  m_culling->cmdBuildHiZ(commandBuffer, *m_gpuProfiler, m_depth->getImage(), frameIndex);
   commandBuffer.end();
 }
 
@@ -822,22 +1214,24 @@ void VkTestSiteApp::recreateSwapchain() {
   m_swapchain = Swapchain(m_surface.get(), m_device, m_physicalDevice, m_window);
   createRenderPass();
   createUniformBuffers();
-  m_descriptorPool = DescriptorPool(m_device);
+  m_descriptorPool = DescriptorPool(m_device, m_textureCapacity * MAX_FRAME_IN_FLIGHT);
   createColorObjets();
   createDepthObjets();
   createDescriptorSet();
   m_texManager->updateDS(m_geometryDescriptorSet);
+  createCullingObjects();
   createPipeline();
   createFramebuffers();
-  createCommandBuffers();
+  createSyncObjects();
 }
 
 void VkTestSiteApp::cleanupSwapchain() {
+  m_culling.reset();
+  m_lightClusters->destroyPipeline();
   m_uniforms.clear();
   m_geometryDescriptorSet.destroy(m_device);
   m_lightingDescriptorSet.destroy(m_device);
   m_descriptorPool.destroy(m_device);
-  m_device.freeCommandBuffers(m_commandPool, m_commandBuffers);
   m_depth.reset();
   m_albedo.reset();
   m_normal.reset();
@@ -847,6 +1241,10 @@ void VkTestSiteApp::cleanupSwapchain() {
   m_device.destroyPipeline(m_geometryPipeline);
   m_device.destroyPipeline(m_lightingPipeline);
   m_device.destroyRenderPass(m_renderPass);
+  for (const auto semaphore: m_renderFinished) {
+    m_device.destroySemaphore(semaphore);
+  }
+  m_renderFinished.clear();
   m_swapchain.destroy(m_device);
 }
 
@@ -856,23 +1254,22 @@ void VkTestSiteApp::cleanup() {
   TracyVkDestroy(m_vkContext);
 #endif
 
-  for (int i = 0; i < m_swapchain.imageViews.size(); ++i) {
-    m_device.destroyFence(m_inFlight[i]);
-    m_device.destroySemaphore(m_imageAvailable[i]);
-    m_device.destroySemaphore(m_renderFinished[i]);
-  }
-
   cleanupSwapchain();
+  m_frames.clear();
 
-  if (m_modelLoaded)
-    m_model.reset();
+  unloadModel();
+  m_modelLoader.reset();
   m_texManager.reset();
   m_textureWorkerPool.reset();
+  m_jobSystem.reset();
+  m_textureCache.reset();
+  m_lightClusters.reset();
   m_lightManager.reset();
+  m_drawList.reset();
+  m_geometryArena.reset();
   m_transferThread.reset();
   m_stagingBuffer.reset();
-  m_imguiCommandBuffers.clear();
-  m_lightingCommandBuffers.clear();
+  m_gpuProfiler.reset();
   m_device.destroyCommandPool(m_commandPool);
   vmaDestroyAllocator(m_allocator);
   m_device.destroy();
@@ -17,14 +17,19 @@
 
 #include "vulkan-memory-allocator-hpp/vk_mem_alloc.hpp"
 #include "tinyfiledialogs/tinyfiledialogs.h"
+#include <stb_image_write.h>
 
 #include "utils.cpp"
 #include <string>
 #include <iostream>
 #include <stdexcept>
+#include <chrono>
 #include <cstdlib>
+#include <filesystem>
+#include <optional>
 #include <set>
 
+#include "AppOptions.h"
 #include "QueueFamilyIndices.cpp"
 #include "Swapchain.h"
 #include "ShaderModule.h"
@@ -32,14 +37,21 @@
 #include "DescriptorPool.h"
 #include "DescriptorSet.h"
 #include "Model.h"
+#include "ModelLoader.h"
 #include "Ubo.h"
 #include "Camera.h"
+#include "CameraPath.h"
 #include "TextureManager.h"
 #include "Pipeline.h"
 #include "Light.h"
 #include "StagingBuffer.h"
 #include "TextureWorkersPool.h"
 #include "TransferThread.h"
+#include "GpuProfiler.h"
+#include "GpuCulling.h"
+#include "JobSystem.h"
+#include "LightClusters.h"
+#include "FrameStats.h"
 
 struct alignas(16) UniformBufferObject {
   glm::vec4 viewPos;
@@ -48,11 +60,31 @@ struct alignas(16) UniformBufferObject {
   uint32_t displayDebugTarget;
 };
 
+/**
+ * @brief Resources of one frame slot
+ *
+ * CPU records frame N+1 into next slot while GPU still executes frame N,
+ * a slot is reused only after its <code>inFlight</code> fence is signaled.
+ */
+struct FrameContext {
+  vk::UniqueCommandPool commandPool; // Reset as whole at frame start
+  vk::CommandBuffer commandBuffer;
+  vk::CommandBuffer lightingCommandBuffer;
+  vk::CommandBuffer imguiCommandBuffer;
+  vk::UniqueFence inFlight;
+  vk::UniqueSemaphore imageAvailable;
+};
+
 class VkTestSiteApp {
 public:
+  explicit VkTestSiteApp(AppOptions options = {}) : m_options(std::move(options)) {
+  }
+
   void run();
 
 private:
+  AppOptions m_options;
+  CameraPath m_cameraPath;
   GLFWwindow *m_window = nullptr;
   tracy::VkCtx *m_vkContext = nullptr;
   vk::CommandBuffer m_tracyCmdBuffer;
@@ -82,26 +114,40 @@ private:
   std::unique_ptr<Texture> m_normal;
   std::unique_ptr<Camera> m_camera;
 
-  std::unique_ptr<Model> m_model;
+  std::shared_ptr<Model> m_model;
+  std::unique_ptr<ModelLoader> m_modelLoader;
   bool m_modelLoaded = false;
   std::unique_ptr<TextureManager> m_texManager;
+  uint32_t m_textureCapacity = 0; // Bindless texture table size, from device limits
   std::unique_ptr<LightManager> m_lightManager;
+  std::unique_ptr<LightClusters> m_lightClusters;
+  std::unique_ptr<ModelGeometryArena> m_geometryArena;
+  std::unique_ptr<DrawList> m_drawList;
+  std::unique_ptr<GpuCulling> m_culling; // Depends on depth buffer, recreated with swapchain
+  bool m_drawIndirectCount = false;
+  uint32_t m_lastVisibleDraws = 0; // Culling result of last finished frame in current slot
+  uint32_t m_lastCandidateDraws = 0;
 
   vk::Queue m_transferQueue;
   std::unique_ptr<TransferThread> m_transferThread;
   std::unique_ptr<StagingBuffer> m_stagingBuffer;
+  std::unique_ptr<JobSystem> m_jobSystem; // Texture loads, model import and frame work
+  std::unique_ptr<TextureCache> m_textureCache; // Optional, used by texture workers
   std::unique_ptr<TextureWorkerPool> m_textureWorkerPool;
 
   std::vector<vk::Framebuffer> m_framebuffers;
   std::vector<UniformBuffer<UniformBufferObject>> m_uniforms = {};
-  std::vector<vk::CommandBuffer> m_commandBuffers;
-  std::vector<vk::UniqueCommandBuffer> m_imguiCommandBuffers;
-  std::vector<vk::UniqueCommandBuffer> m_lightingCommandBuffers;
-  std::vector<vk::Fence> m_inFlight;
-  std::vector<vk::Semaphore> m_imageAvailable;
-  std::vector<vk::Semaphore> m_renderFinished;
-
-  uint32_t m_currentFrame = 0;
+  std::vector<FrameContext> m_frames;
+  std::vector<vk::Semaphore> m_renderFinished; // Per swapchain image, waited by present
+
+  std::unique_ptr<GpuProfiler> m_gpuProfiler;
+  std::optional<GpuFrameTimings> m_lastGpuTimings;
+  FrameStatsRecorder m_frameStats;
+  double m_assetLoadMs = 0.0; // Headless only: model and textures streaming time
+  uint64_t m_transferWaitValue = 0; // Staging timeline value current frame submit waits for
+  uint64_t m_frameNumber = 0;
+
+  uint32_t m_currentFrame = 0; // Frame slot index
   int32_t m_debugView = 0;
   float m_lastTime = 0.0f;
 
@@ -117,14 +163,24 @@ private:
   void createFramebuffers();
   void createUniformBuffers();
   void createDescriptorSet();
+  void createCullingObjects();
   void createCommandPool();
-  void createCommandBuffers();
+  void createFrames();
   void createSyncObjects();
 
   void mainLoop();
+  void headlessLoop();
+  void loadModel(const std::filesystem::path &path);
+  void unloadModel();
+  void waitForAssets();
   void render(ImDrawData* draw_data, float deltaTime);
-  void updateUniformBuffer(uint32_t imageIndex);
-  void recordCommandBuffer(ImDrawData* draw_data, const vk::CommandBuffer& commandBuffer, uint32_t imageIndex);
+  uint32_t renderOffscreen(ImDrawData* draw_data, float deltaTime);
+  std::vector<vk::SemaphoreSubmitInfo> makeTransferWaitInfos() const;
+  void captureFrame(uint32_t imageIndex, uint32_t frameNumber);
+  void collectGpuTimings(uint32_t frameIndex);
+  void writeFrameStats(const std::filesystem::path &output) const;
+  void updateUniformBuffer(uint32_t frameIndex);
+  void recordCommandBuffer(ImDrawData* draw_data, uint32_t frameIndex, uint32_t imageIndex);
   void recreateSwapchain();
   void cleanupSwapchain();
   void cleanup();
@@ -4,7 +4,7 @@
 
 VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE
 
-int main() {
+int main(const int argc, char **argv) {
   const auto console_sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
   const auto tracy_sink = std::make_shared<tracy_sink_mt>();
 
@@ -13,9 +13,8 @@ int main() {
   const auto logger = std::make_shared<spdlog::logger>("def_logger", sinks.begin(), sinks.end());
   spdlog::set_default_logger(logger);
 
-  VkTestSiteApp app{};
-
   try {
+    VkTestSiteApp app{parseAppOptions(argc, argv)};
     app.run();
   } catch (const std::exception &e) {
     std::cerr << e.what() << std::endl;
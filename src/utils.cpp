@@ -7,6 +7,7 @@
 #include <glm/ext/matrix_float4x4.hpp>
 #include "spdlog/spdlog.h"
 
+#include <algorithm>
 #include <functional>
 #include <iostream>
 #include <optional>
@@ -316,12 +317,14 @@ static std::pair<vma::UniqueImage, vma::UniqueAllocation> createImageUnique(
   const vk::Format format,
   const vk::ImageTiling tiling,
   const vk::ImageUsageFlags usage,
-  const vk::MemoryPropertyFlags properties
+  const vk::MemoryPropertyFlags properties,
+  const uint32_t arrayLayers = 1,
+  const vk::ImageCreateFlags flags = {}
 ) {
   auto info = vk::ImageCreateInfo(
-    {}, vk::ImageType::e2D,
+    flags, vk::ImageType::e2D,
     format, vk::Extent3D(width, height, 1),
-    mipLevels, 1, samples,
+    mipLevels, arrayLayers, samples,
     tiling, usage, vk::SharingMode::eExclusive
   );
   info.setInitialLayout(vk::ImageLayout::eUndefined);
@@ -346,7 +349,7 @@ static vk::UniqueSampler createSamplerUnique(const vk::Device device) {
       .setMipmapMode(vk::SamplerMipmapMode::eLinear)
       .setMipLodBias(0.0f)
       .setMinLod(0.0f)
-      .setMaxLod(0.0f);
+      .setMaxLod(vk::LodClampNone); // Limited by view mip count
   return device.createSamplerUnique(info);
 }
 
@@ -486,52 +489,88 @@ static void transitionImageLayout(
   });
 }
 
-static void generateMipmaps(
-  const vk::Device device,
-  const vk::Queue graphicsQueue,
-  const vk::CommandPool commandPool,
-  const vk::Image image,
-  const uint32_t width, const uint32_t height,
-  const uint32_t mipLevels
-) {
-  executeSingleTimeCommands(device, graphicsQueue, commandPool, [&](const vk::CommandBuffer cmd) {
-    auto mipWidth = width;
-    auto mipHeight = height;
-    for (int mipLevel = 1; mipLevel < mipLevels; ++mipLevel) {
-      cmdTransitionImageLayout(
-        cmd, image, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eTransferSrcOptimal,
-        1, {}, mipLevel - 1);
-
-      const auto srcSubResource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, mipLevel - 1, 0, 1);
-      const auto dstSubResource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, mipLevel, 0, 1);
-      auto blit = vk::ImageBlit(
-        srcSubResource,
-        {
-          vk::Offset3D(0, 0, 0),
-          vk::Offset3D(mipWidth, mipHeight, 1),
-        },
-        dstSubResource,
-        {
-          vk::Offset3D(0, 0, 0),
-          vk::Offset3D(mipWidth > 1 ? mipWidth / 2 : 1, mipHeight > 1 ? mipHeight / 2 : 1, 1),
-        }
+/**
+ * Image whose mip chain is generated by <code>cmdGenerateMipmaps</code>
+ */
+struct MipmapTarget {
+  vk::Image image;
+  vk::Extent2D extent; // Level 0 size
+  vk::ImageSubresourceRange range; // Levels to fill starting from written base level, all layers
+};
+
+/**
+ * Record mip chain generation of several images by linear blits, level i is blitted from level i - 1.
+ * Every level step is one barrier and one blit per image, so a batch of images costs
+ * as many barriers as its longest chain instead of two per level of each image.
+ * @remark Whole range must be in TransferDstOptimal with base level written (by transfer stage),
+ * range ends in ShaderReadOnlyOptimal visible to fragment shader. Format must support linear blit.
+ */
+static void cmdGenerateMipmaps(const vk::CommandBuffer cmd, const std::vector<MipmapTarget> &targets) {
+  ZoneScoped;
+  uint32_t maxLevels = 0;
+  for (const auto &target: targets)
+    maxLevels = std::max(maxLevels, target.range.levelCount);
+
+  std::vector<vk::ImageMemoryBarrier2> barriers;
+  for (uint32_t i = 1; i < maxLevels; ++i) {
+    barriers.clear();
+    for (const auto &target: targets) {
+      if (i >= target.range.levelCount)
+        continue;
+      barriers.emplace_back(
+        vk::PipelineStageFlagBits2::eTransfer, vk::AccessFlagBits2::eTransferWrite,
+        vk::PipelineStageFlagBits2::eBlit, vk::AccessFlagBits2::eTransferRead,
+        vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eTransferSrcOptimal,
+        vk::QueueFamilyIgnored, vk::QueueFamilyIgnored, target.image,
+        vk::ImageSubresourceRange(target.range.aspectMask, target.range.baseMipLevel + i - 1, 1,
+                                  target.range.baseArrayLayer, target.range.layerCount));
+    }
+    cmd.pipelineBarrier2(vk::DependencyInfo({}, {}, {}, barriers));
+
+    for (const auto &target: targets) {
+      if (i >= target.range.levelCount)
+        continue;
+      const auto srcLevel = target.range.baseMipLevel + i - 1;
+      const auto mipOffset = [&](const uint32_t level) {
+        return vk::Offset3D(static_cast<int32_t>(std::max(target.extent.width >> level, 1u)),
+                            static_cast<int32_t>(std::max(target.extent.height >> level, 1u)), 1);
+      };
+      const auto blit = vk::ImageBlit(
+        vk::ImageSubresourceLayers(target.range.aspectMask, srcLevel,
+                                   target.range.baseArrayLayer, target.range.layerCount),
+        {vk::Offset3D(0, 0, 0), mipOffset(srcLevel)},
+        vk::ImageSubresourceLayers(target.range.aspectMask, srcLevel + 1,
+                                   target.range.baseArrayLayer, target.range.layerCount),
+        {vk::Offset3D(0, 0, 0), mipOffset(srcLevel + 1)}
       );
       cmd.blitImage(
-        image, vk::ImageLayout::eTransferSrcOptimal,
-        image, vk::ImageLayout::eTransferDstOptimal,
+        target.image, vk::ImageLayout::eTransferSrcOptimal,
+        target.image, vk::ImageLayout::eTransferDstOptimal,
         blit, vk::Filter::eLinear
       );
-
-      cmdTransitionImageLayout(
-        cmd, image, vk::ImageLayout::eTransferSrcOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
-        1, {}, mipLevel - 1);
-
-      mipWidth = mipWidth > 1 ? mipWidth / 2 : mipWidth;
-      mipHeight = mipHeight > 1 ? mipHeight / 2 : mipHeight;
     }
+  }
 
-    cmdTransitionImageLayout(
-      cmd, image, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
-      1, {}, mipLevels - 1);
-  });
+  barriers.clear();
+  for (const auto &target: targets) {
+    const auto &range = target.range;
+    if (range.levelCount > 1) {
+      barriers.emplace_back(
+        vk::PipelineStageFlagBits2::eBlit, vk::AccessFlagBits2::eTransferRead,
+        vk::PipelineStageFlagBits2::eFragmentShader, vk::AccessFlagBits2::eShaderRead,
+        vk::ImageLayout::eTransferSrcOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+        vk::QueueFamilyIgnored, vk::QueueFamilyIgnored, target.image,
+        vk::ImageSubresourceRange(range.aspectMask, range.baseMipLevel, range.levelCount - 1,
+                                  range.baseArrayLayer, range.layerCount));
+    }
+    barriers.emplace_back(
+      vk::PipelineStageFlagBits2::eTransfer, vk::AccessFlagBits2::eTransferWrite,
+      vk::PipelineStageFlagBits2::eFragmentShader, vk::AccessFlagBits2::eShaderRead,
+      vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+      vk::QueueFamilyIgnored, vk::QueueFamilyIgnored, target.image,
+      vk::ImageSubresourceRange(range.aspectMask, range.baseMipLevel + range.levelCount - 1, 1,
+                                range.baseArrayLayer, range.layerCount));
+  }
+  if (!barriers.empty())
+    cmd.pipelineBarrier2(vk::DependencyInfo({}, {}, {}, barriers));
 }